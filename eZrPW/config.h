@@ -9,4 +9,5 @@
 #define LAYER_STATE_8BIT
 
 #define RGB_MATRIX_STARTUP_SPD 60
-#define ACHORDION_STREAK
+
+#include "custom_config.h"
@@ -0,0 +1,109 @@
+# Custom QMK features, kept apart from rules.mk, which Oryx rewrites on each
+# layout change. scripts/apply-custom-qmk.sh includes this file from rules.mk.
+
+# Register presses on the first edge and debounce only releases, so DEBOUNCE
+# in config.h no longer delays presses.
+DEBOUNCE_TYPE = asym_eager_defer_pk
+
+# Achordion plumbs settled events back through features/event_queue.c.
+SRC += features/achordion.c features/event_queue.c
+
+# Keys held, which bypass mode, idle states and Achordion's Caps Word streak
+# wait on.
+SRC += features/keys_down.c
+
+# Layer indicator colors, converted a few LEDs per frame.
+SRC += features/layer_lighting.c
+
+# Oryx's ledmap and tap dances as tables, from scripts/oryx_codegen.py.
+SRC += oryx_tables.c features/oryx_dance.c
+
+# Cycle-counter timings of user hooks, read with scripts/user_hid.py.
+PROFILER_ENABLE = no
+ifeq ($(strip $(PROFILER_ENABLE)), yes)
+  OPT_DEFS += -DPROFILER_ENABLE
+  SRC += features/profiler.c
+endif
+
+# Scan rate and scan interval histogram, read with scripts/user_hid.py.
+SCAN_STATS_ENABLE = no
+ifeq ($(strip $(SCAN_STATS_ENABLE)), yes)
+  OPT_DEFS += -DSCAN_STATS_ENABLE
+  SRC += features/scan_stats.c
+endif
+
+# Key-to-report latency per key class, read with scripts/user_hid.py.
+LATENCY_TRACE_ENABLE = no
+ifeq ($(strip $(LATENCY_TRACE_ENABLE)), yes)
+  OPT_DEFS += -DLATENCY_TRACE_ENABLE
+  SRC += features/latency_trace.c
+  EXTRALDFLAGS += -Wl,--wrap=host_keyboard_send -Wl,--wrap=host_nkro_send
+endif
+
+# Physical key events for replay in sim/, recorded with scripts/user_hid.py.
+KEY_TRACE_ENABLE = no
+ifeq ($(strip $(KEY_TRACE_ENABLE)), yes)
+  OPT_DEFS += -DKEY_TRACE_ENABLE
+  SRC += features/key_trace.c
+endif
+
+# Stack high-water marks, read with scripts/user_hid.py. ChibiOS only.
+STACK_USAGE_ENABLE = no
+ifeq ($(strip $(STACK_USAGE_ENABLE)), yes)
+  OPT_DEFS += -DSTACK_USAGE_ENABLE
+  SRC += features/stack_usage.c
+endif
+
+# Gaming mode without tap-hold keys, toggled by scripts/user_hid.py.
+BYPASS_MODE_ENABLE = no
+ifeq ($(strip $(BYPASS_MODE_ENABLE)), yes)
+  OPT_DEFS += -DBYPASS_MODE_ENABLE
+  SRC += features/bypass_mode.c
+endif
+
+# Achordion settings tuned at runtime with scripts/user_hid.py tune.
+TUNING_ENABLE = no
+ifeq ($(strip $(TUNING_ENABLE)), yes)
+  OPT_DEFS += -DTUNING_ENABLE
+  SRC += features/tuning.c
+endif
+
+# Combos matched on key positions ahead of Achordion, in place of QMK's
+# COMBO_ENABLE. Combos are listed in custom_keymap.c.
+POSITION_COMBOS_ENABLE = no
+ifeq ($(strip $(POSITION_COMBOS_ENABLE)), yes)
+  OPT_DEFS += -DPOSITION_COMBOS_ENABLE
+  SRC += features/position_combos.c
+endif
+
+# Decaying per-key press counters, shown in place of the layer colors while
+# toggled on by scripts/user_hid.py.
+HEATMAP_ENABLE = no
+ifeq ($(strip $(HEATMAP_ENABLE)), yes)
+  OPT_DEFS += -DHEATMAP_ENABLE
+  SRC += features/heatmap.c
+endif
+
+# Skips idle housekeeping between key events.
+IDLE_ENABLE = yes
+ifeq ($(strip $(IDLE_ENABLE)), yes)
+  OPT_DEFS += -DIDLE_ENABLE
+  SRC += features/idle.c
+endif
+
+# Turns the LEDs off after a minute without key events, with
+# RGB_MATRIX_TIMEOUT in custom_config.h, and idle states sleep with them.
+IDLE_RGB_TIMEOUT = no
+ifeq ($(strip $(IDLE_RGB_TIMEOUT)), yes)
+  OPT_DEFS += -DIDLE_RGB_TIMEOUT
+endif
+
+# Keymap raw HID commands, answered ahead of Oryx's (see features/user_hid.h).
+# Linked only when a feature above answers any.
+USER_HID_FEATURES = $(PROFILER_ENABLE) $(SCAN_STATS_ENABLE) \
+  $(LATENCY_TRACE_ENABLE) $(KEY_TRACE_ENABLE) $(STACK_USAGE_ENABLE) \
+  $(BYPASS_MODE_ENABLE) $(TUNING_ENABLE) $(HEATMAP_ENABLE)
+ifneq ($(filter yes,$(strip $(USER_HID_FEATURES))),)
+  SRC += features/user_hid.c
+  EXTRALDFLAGS += -Wl,--wrap=raw_hid_receive
+endif
@@ -0,0 +1,18 @@
+// Options of the custom QMK features, kept apart from config.h, which Oryx
+// rewrites on each layout change. scripts/apply-custom-qmk.sh includes this
+// file from config.h.
+
+#pragma once
+
+#define ACHORDION_STREAK
+#define ACHORDION_CAPS_WORD_STREAK
+
+#ifdef TUNING_ENABLE
+// Saved parameter blocks of features/tuning.c, 2 + TUNING_PROFILES * 114.
+#define EECONFIG_USER_DATA_SIZE 458
+#endif
+
+#if defined(IDLE_RGB_TIMEOUT) && !defined(RGB_MATRIX_TIMEOUT)
+// Turns the LEDs off after a minute without key events, see features/idle.h.
+#define RGB_MATRIX_TIMEOUT 60000
+#endif
@@ -0,0 +1,222 @@
+// Keymap code of the custom QMK features, kept apart from keymap.c, which
+// Oryx rewrites on each layout change. keymap.c includes this file, and
+// scripts/apply-custom-qmk.sh keeps that include and the calls of
+// keyboard_post_init_custom() and process_record_custom() in Oryx's hooks.
+// Oryx's layer LED code, which features/layer_lighting.c replaces, is removed
+// by scripts/oryx_codegen.py.
+
+#include QMK_KEYBOARD_H
+#include "features/achordion.h"
+#include "features/bypass_mode.h"
+#include "features/event_queue.h"
+#include "features/heatmap.h"
+#include "features/idle.h"
+#include "features/key_trace.h"
+#include "features/keys_down.h"
+#include "features/layer_lighting.h"
+#include "features/latency_trace.h"
+#include "features/position_combos.h"
+#include "features/profiler.h"
+#include "features/scan_stats.h"
+#include "features/stack_usage.h"
+#include "features/tuning.h"
+#include "features/user_hid.h"
+#include "oryx_tables.h"
+
+#ifdef POSITION_COMBOS_ENABLE
+// Sorted by mask. Positions count from 0 in LAYOUT_voyager() order.
+const position_combo_t PROGMEM position_combos[] = {
+  // The , and . keys together on the base layer: Escape.
+  {POSITION_COMBO_KEY(44) | POSITION_COMBO_KEY(45), KC_ESCAPE, 0},
+};
+const uint8_t position_combos_count =
+    sizeof(position_combos) / sizeof(position_combos[0]);
+#endif
+
+uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key) {
+  const uint16_t combo_keycode = position_combos_keycode(key);
+  if (combo_keycode != KC_NO) {
+    return combo_keycode;
+  }
+  return achordion_caps_word_keycode(bypass_mode_keycode(layer, key));
+}
+
+void keyboard_pre_init_user(void) {
+  stack_usage_init();
+}
+
+// Called first from Oryx's keyboard_post_init_user().
+void keyboard_post_init_custom(void) {
+  profiler_init();
+  latency_trace_init();
+  layer_lighting_init();
+  heatmap_init();
+  position_combos_init();
+  idle_init();
+  tuning_init();
+}
+
+bool rgb_matrix_indicators_user(void) {
+  PROFILE_SCOPE(PROFILE_RGB_INDICATORS);
+  if (rawhid_state.rgb_control) {
+      layer_lighting_hide();
+      return false;
+  }
+  if (heatmap_is_on()) {
+    layer_lighting_show(LAYER_LIGHTING_HEATMAP);
+    return true;
+  }
+  if (!keyboard_config.disable_layer_led) { 
+  switch (layer_lighting_layer(biton32(layer_state))) {
+    case 1:
+      layer_lighting_show(1);
+      break;
+    case 2:
+      layer_lighting_show(2);
+      break;
+   default:
+        layer_lighting_hide();
+        if (rgb_matrix_get_flags() == LED_FLAG_NONE) {
+      rgb_matrix_set_color_all(0, 0, 0);
+  }
+    }
+  } else {
+    layer_lighting_hide();
+    if (rgb_matrix_get_flags() == LED_FLAG_NONE) {
+      rgb_matrix_set_color_all(0, 0, 0);
+    }
+  }
+
+  return true;
+}
+
+bool pre_process_record_user(uint16_t keycode, keyrecord_t *record) {
+  // Events the combo engine replays were seen here as they happened.
+  if (!event_queue_is_replaying()) {
+    achordion_caps_word_event(record);
+    keys_down_event(record);
+    latency_trace_event(keycode, record);
+    key_trace_event(record);
+    layer_lighting_event(keycode, record);
+    idle_event(record);
+  }
+  return bypass_mode_is_on() || process_position_combos(keycode, record);
+}
+
+// Called first from Oryx's process_record_user(), which stops at false.
+bool process_record_custom(uint16_t keycode, keyrecord_t *record) {
+  PROFILE_SCOPE(PROFILE_PROCESS_RECORD_USER);
+  if (!bypass_mode_is_on() &&
+      !PROFILE_CALL(PROFILE_PROCESS_ACHORDION,
+                    process_achordion(keycode, record))) { return false; }
+  heatmap_event(record);
+  return true;
+}
+
+void housekeeping_task_user(void) {
+  scan_stats_task();
+  idle_task();
+  // With all keys released and their timers run out, these have nothing to do.
+  if (idle_state() == IDLE_STATE_ACTIVE) {
+    PROFILE_CALL(PROFILE_ACHORDION_TASK, achordion_task());
+    position_combos_task();
+  }
+  bypass_mode_task();
+  heatmap_task();
+}
+
+bool process_raw_hid_user(uint8_t *data, uint8_t length) {
+#ifdef PROFILER_ENABLE
+  if (!process_profiler_hid(data, length)) { return false; }
+#endif
+#ifdef SCAN_STATS_ENABLE
+  if (!process_scan_stats_hid(data, length)) { return false; }
+#endif
+#ifdef LATENCY_TRACE_ENABLE
+  if (!process_latency_trace_hid(data, length)) { return false; }
+#endif
+#ifdef KEY_TRACE_ENABLE
+  if (!process_key_trace_hid(data, length)) { return false; }
+#endif
+#ifdef STACK_USAGE_ENABLE
+  if (!process_stack_usage_hid(data, length)) { return false; }
+#endif
+#ifdef BYPASS_MODE_ENABLE
+  if (!process_bypass_mode_hid(data, length)) { return false; }
+#endif
+#ifdef TUNING_ENABLE
+  if (!process_tuning_hid(data, length)) { return false; }
+#endif
+#ifdef HEATMAP_ENABLE
+  if (!process_heatmap_hid(data, length)) { return false; }
+#endif
+  return true;
+}
+
+// Keys on opposite hands chord, as by default, with the hands of
+// tap_hold_hands, where '*' keys chord with either hand.
+static char hand(keypos_t key) {
+  const char h = pgm_read_byte(&tap_hold_hands[key.row][key.col]);
+  if (h) {
+    return h;
+  }
+  return key.row < MATRIX_ROWS / 2 ? 'L' : 'R';  // A position combo's.
+}
+
+bool achordion_chord(uint16_t tap_hold_keycode, keyrecord_t *tap_hold_record,
+                     uint16_t other_keycode, keyrecord_t *other_record) {
+  const char tap_hold_hand = hand(tap_hold_record->event.key);
+  const char other_hand = hand(other_record->event.key);
+  return tap_hold_hand == '*' || other_hand == '*' ||
+         tap_hold_hand != other_hand;
+}
+
+uint16_t achordion_streak_chord_timeout(
+    uint16_t tap_hold_keycode, uint16_t next_keycode) {
+  const uint16_t tuned = tuning_streak_chord_timeout(tap_hold_keycode);
+  if (tuned != TUNING_KEYMAP) {
+    return tuned;  // Set at runtime, see features/tuning.h.
+  }
+  if (IS_QK_LAYER_TAP(tap_hold_keycode)) {
+    return 0;  // Disable streak detection on layer-tap keys.
+  }
+
+  // Otherwise, tap_hold_keycode is a mod-tap key.
+  uint8_t mod = mod_config(QK_MOD_TAP_GET_MODS(tap_hold_keycode));
+  if ((mod & (MOD_LSFT | MOD_RSFT)) != 0) {
+    return 0;  // Exclude left and right shift from typing streak.
+  } else if ((mod & (MOD_LGUI | MOD_RGUI | MOD_LALT | MOD_RALT)) != 0) {
+    return 200;  // Shorter timeout for command and option keys.
+  } else {
+    return 300;  // Longer timeout for other mod-tap keys.
+  }
+}
+
+bool achordion_streak_continue(uint16_t keycode) {
+  // If mods other than shift or AltGr are held, don't continue the streak.
+  if (get_mods() & (MOD_MASK_CG | MOD_BIT_LALT)) return false;
+  // This function doesn't get called for holds, so convert to tap keycodes.
+  if (IS_QK_MOD_TAP(keycode)) {
+    keycode = QK_MOD_TAP_GET_TAP_KEYCODE(keycode);
+  }
+  if (IS_QK_LAYER_TAP(keycode)) {
+    keycode = QK_LAYER_TAP_GET_TAP_KEYCODE(keycode);
+  }
+  if (tuning_has_streak_keys()) {
+    return tuning_is_streak_key(keycode);
+  }
+  // Regular letters and punctuation continue the streak.
+  if (keycode >= KC_A && keycode <= KC_Z) return true;
+  switch (keycode) {
+    case KC_DOT:
+    case KC_COMMA:
+    case KC_QUOTE:
+    case KC_SPACE:
+    case KC_EXLM:  // !
+    case KC_QUES:  // ?
+    case KC_AT:    // @
+    case KC_DLR:   // $
+      return true;
+  }
+  return false;  // All other keys end the streak.
+}
@@ -21,6 +21,8 @@
  */
 
 #include "achordion.h"
+#include "event_queue.h"
+#include "keys_down.h"
 
 #if !defined(IS_QK_MOD_TAP)
 // Attempt to detect out-of-date QMK installation, which would fail with
@@ -38,6 +40,17 @@ static uint8_t eager_mods = 0;
 // Flag to determine whether another key is pressed within the timeout.
 static bool pressed_another_key_before_release = false;
 
+#ifdef ACHORDION_OVERLAP
+// Press of another key, held back until that key's release.
+static keyrecord_t other_record;
+static uint16_t other_keycode = KC_NO;
+static bool other_pending = false;
+// Whether, and when, the tap-hold key was released while `other_record` was
+// held back.
+static bool tap_hold_released = false;
+static uint16_t tap_hold_release_time = 0;
+#endif
+
 #ifdef ACHORDION_STREAK
 // Timer for typing streak
 static uint16_t streak_timer = 0;
@@ -46,6 +59,13 @@ static uint16_t streak_timer = 0;
 #define is_streak false
 #endif
 
+#ifdef ACHORDION_CAPS_WORD_STREAK
+// Whether keys are looked up as Caps Word streak taps. Follows Caps Word at
+// presses made with no key held (see keys_down.h), so a key is released under
+// the keycode it was pressed with, however often QMK looks it up.
+static bool caps_word_streak = false;
+#endif
+
 // Achordion's current state.
 enum {
   // A tap-hold key is pressed, but hasn't yet been settled as tapped or held.
@@ -56,10 +76,6 @@ enum {
   STATE_TAPPING,
   // Active tap-hold key has been settled as held.
   STATE_HOLDING,
-  // This state is set while calling `process_record()`, which will recursively
-  // call `process_achordion()`. This state is checked so that we don't process
-  // events generated by Achordion and potentially create an infinite loop.
-  STATE_RECURSING,
 };
 static uint8_t achordion_state = STATE_RELEASED;
 
@@ -84,31 +100,18 @@ static void process_eager_mods_action(void) {
   process_action(&tap_hold_record, action);
 }
 
-// Calls `process_record()` with state set to RECURSING.
-static void recursively_process_record(keyrecord_t* record, uint8_t state) {
-  achordion_state = STATE_RECURSING;
-#if defined(POINTING_DEVICE_ENABLE) && defined(POINTING_DEVICE_AUTO_MOUSE_ENABLE)
-  int8_t mouse_key_tracker = get_auto_mouse_key_tracker();
-#endif
-  process_record(record);
-#if defined(POINTING_DEVICE_ENABLE) && defined(POINTING_DEVICE_AUTO_MOUSE_ENABLE)
-  set_auto_mouse_key_tracker(mouse_key_tracker);
-#endif
-  achordion_state = state;
-}
-
 // Sends hold press event and settles the active tap-hold key as held.
 static void settle_as_hold(void) {
   if (eager_mods) {
     // If eager mods are being applied, nothing needs to be done besides
     // updating the state.
     dprintln("Achordion: Settled eager mod as hold.");
-    achordion_state = STATE_HOLDING;
   } else {
     // Create hold press event.
     dprintln("Achordion: Plumbing hold press.");
-    recursively_process_record(&tap_hold_record, STATE_HOLDING);
+    event_queue_push(&tap_hold_record, 0);
   }
+  achordion_state = STATE_HOLDING;
 }
 
 // Sends tap press and release and settles the active tap-hold key as tapped.
@@ -132,26 +135,82 @@ static void settle_as_tap(void) {
   tap_hold_record.event.pressed = true;
   tap_hold_record.tap.count = 1;  // Revise event as a tap.
   tap_hold_record.tap.interrupted = true;
-  // Plumb tap press event.
-  recursively_process_record(&tap_hold_record, STATE_TAPPING);
-
-  send_keyboard_report();
-#if TAP_CODE_DELAY > 0
-  wait_ms(TAP_CODE_DELAY);
-#endif  // TAP_CODE_DELAY > 0
+  // Plumb tap press event, waiting TAP_CODE_DELAY before the release.
+  event_queue_push(&tap_hold_record, TAP_CODE_DELAY);
 
   dprintln("Achordion: Plumbing tap release.");
   tap_hold_record.event.pressed = false;
   // Plumb tap release event.
-  recursively_process_record(&tap_hold_record, STATE_TAPPING);
+  event_queue_push(&tap_hold_record, 0);
+  achordion_state = STATE_TAPPING;
 }
 
-bool process_achordion(uint16_t keycode, keyrecord_t* record) {
-  // Don't process events that Achordion generated.
-  if (achordion_state == STATE_RECURSING) {
-    return true;
+// Handles the release of the active tap-hold key, plumbing what its
+// settlement still owes.
+static void release_tap_hold(void) {
+  if (eager_mods) {
+    dprintln("Achordion: Key released. Clearing eager mods.");
+    // Eager mods are released directly, after the events queued before.
+    event_queue_drain();
+    tap_hold_record.event.pressed = false;
+    process_eager_mods_action();
+  } else if (achordion_state == STATE_HOLDING) {
+    dprintln("Achordion: Key released. Plumbing hold release.");
+    tap_hold_record.event.pressed = false;
+    // Plumb hold release event.
+    event_queue_push(&tap_hold_record, 0);
+  } else if (!pressed_another_key_before_release) {
+    // No other key was pressed between the press and release of the tap-hold
+    // key, plumb a hold press and then a release.
+    dprintln("Achordion: Key released. Plumbing hold press and release.");
+    event_queue_push(&tap_hold_record, 0);
+    tap_hold_record.event.pressed = false;
+    event_queue_push(&tap_hold_record, 0);
+  } else {
+    dprintln("Achordion: Key released.");
+  }
+
+  achordion_state = STATE_RELEASED;
+  tap_hold_keycode = KC_NO;
+}
+
+#ifdef ACHORDION_OVERLAP
+// Returns true if enough of the other key's press, which ended at
+// `release_time`, fell inside the tap-hold key's press to settle it as held.
+// A press nested inside the tap-hold key's overlaps fully.
+static bool overlap_is_hold(uint16_t release_time) {
+  const uint16_t press_time = other_record.event.time;
+  const uint16_t duration = TIMER_DIFF_16(release_time, press_time);
+  const uint16_t overlap =
+      tap_hold_released ? TIMER_DIFF_16(tap_hold_release_time, press_time)
+                        : duration;
+  return (uint32_t)overlap * 100 >=
+         (uint32_t)duration * achordion_overlap_percent(tap_hold_keycode);
+}
+
+// Settles the active tap-hold key, then plumbs the other key's held back
+// press and, if it came before the current event, the tap-hold key's release.
+static void settle_overlap(bool hold) {
+  other_pending = false;
+  if (hold) {
+    settle_as_hold();
+  } else {
+    settle_as_tap();
+#ifdef ACHORDION_STREAK
+    update_streak_timer(other_keycode, &other_record);
+#endif
+  }
+  dprintln("Achordion: Plumbing held back press.");
+  event_queue_push(&other_record, 0);
+  if (tap_hold_released) {
+    release_tap_hold();
   }
+}
+#endif  // ACHORDION_OVERLAP
 
+// Handles an event from the pipeline. Events to plumb back are queued, and
+// processed by the caller once the handling is done.
+static bool handle_event(uint16_t keycode, keyrecord_t* record) {
   // Determine whether the current event is for a mod-tap or layer-tap key.
   const bool is_mt = IS_QK_MOD_TAP(keycode);
   const bool is_tap_hold = is_mt || IS_QK_LAYER_TAP(keycode);
@@ -179,7 +238,9 @@ bool process_achordion(uint16_t keycode, keyrecord_t* record) {
 #if defined(CAPS_WORD_ENABLE)
               // Since eager mods bypass normal event handling, Caps Word does
               // not work as expected with eager Shift. So we don't apply Shift
-              // eagerly while Caps Word is on.
+              // eagerly while Caps Word is on. With ACHORDION_CAPS_WORD_STREAK,
+              // the keys Caps Word types are plain keys by then and do not
+              // get here.
               !(is_caps_word_on() && (mod & MOD_LSFT) != 0) &&
 #endif  // defined(CAPS_WORD_ENABLE)
               achordion_eager_mod(mod)) {
@@ -203,30 +264,39 @@ bool process_achordion(uint16_t keycode, keyrecord_t* record) {
     pressed_another_key_before_release = true;
   }
 
-  // Release of the active tap-hold key.
-  if (keycode == tap_hold_keycode && !record->event.pressed) {
-    if (eager_mods) {
-      dprintln("Achordion: Key released. Clearing eager mods.");
-      tap_hold_record.event.pressed = false;
-      process_eager_mods_action();
-    } else if (achordion_state == STATE_HOLDING) {
-      dprintln("Achordion: Key released. Plumbing hold release.");
-      tap_hold_record.event.pressed = false;
-      // Plumb hold release event.
-      recursively_process_record(&tap_hold_record, STATE_RELEASED);
-    } else if (!pressed_another_key_before_release) {
-      // No other key was pressed between the press and release of the tap-hold
-      // key, plumb a hold press and then a release.
-      dprintln("Achordion: Key released. Plumbing hold press and release.");
-      recursively_process_record(&tap_hold_record, STATE_HOLDING);
-      tap_hold_record.event.pressed = false;
-      recursively_process_record(&tap_hold_record, STATE_RELEASED);
-    } else {
-      dprintln("Achordion: Key released.");
+#ifdef ACHORDION_OVERLAP
+  if (other_pending) {
+    if (keycode == tap_hold_keycode && !record->event.pressed) {
+      // The tap-hold key is released first: plumbed once settled.
+      tap_hold_released = true;
+      tap_hold_release_time = record->event.time;
+      return false;
     }
 
-    achordion_state = STATE_RELEASED;
-    tap_hold_keycode = KC_NO;
+    const bool other_released =
+        !record->event.pressed &&
+        KEYEQ(record->event.key, other_record.event.key);
+    if (other_released || record->event.pressed) {
+      bool hold;
+      if (other_released) {
+        hold = overlap_is_hold(record->event.time);
+      } else {
+        // A further press settles with what is known so far.
+        hold = !tap_hold_released &&
+               (!is_key_event || (is_tap_hold && record->tap.count == 0) ||
+                achordion_chord(tap_hold_keycode, &tap_hold_record,
+                                other_keycode, &other_record));
+      }
+      settle_overlap(hold);
+      event_queue_push(record, 0);  // Re-process event.
+      return false;                 // Block the original event.
+    }
+  }
+#endif  // ACHORDION_OVERLAP
+
+  // Release of the active tap-hold key.
+  if (keycode == tap_hold_keycode && !record->event.pressed) {
+    release_tap_hold();
     return false;
   }
 
@@ -241,6 +311,22 @@ bool process_achordion(uint16_t keycode, keyrecord_t* record) {
 
     // Press event occurred on a key other than the active tap-hold key.
 
+#ifdef ACHORDION_OVERLAP
+    // Under the overlap policy, hold the press back and settle at its release
+    // instead, unless it is a tap-hold key QMK considers held.
+    if (!is_streak && is_key_event &&
+        !(is_tap_hold && record->tap.count == 0) &&
+        achordion_overlap_percent(tap_hold_keycode) > 0) {
+      dprintf("Achordion: Holding back key 0x%04X until its release.\n",
+              keycode);
+      other_record = *record;
+      other_keycode = keycode;
+      other_pending = true;
+      tap_hold_released = false;
+      return false;
+    }
+#endif  // ACHORDION_OVERLAP
+
     // If the other key is *also* a tap-hold key and considered by QMK to be
     // held, then we settle the active key as held. This way, things like
     // chording multiple home row modifiers will work, but let's our logic
@@ -249,8 +335,9 @@ bool process_achordion(uint16_t keycode, keyrecord_t* record) {
     // Otherwise, we call `achordion_chord()` to determine whether to settle the
     // tap-hold key as tapped vs. held. We implement the tap or hold by plumbing
     // events back into the handling pipeline so that QMK features and other
-    // user code can see them. This is done by calling `process_record()`, which
-    // in turn calls most handlers including `process_record_user()`.
+    // user code can see them. This is done by queuing them for
+    // `process_record()`, which in turn calls most handlers including
+    // `process_record_user()`.
     if (!is_streak &&
         (!is_key_event || (is_tap_hold && record->tap.count == 0) ||
          achordion_chord(tap_hold_keycode, &tap_hold_record, keycode,
@@ -287,8 +374,8 @@ bool process_achordion(uint16_t keycode, keyrecord_t* record) {
 #endif
     }
 
-    recursively_process_record(record, achordion_state);  // Re-process event.
-    return false;  // Block the original event.
+    event_queue_push(record, 0);  // Re-process event.
+    return false;                 // Block the original event.
   }
 
 #ifdef ACHORDION_STREAK
@@ -298,16 +385,56 @@ bool process_achordion(uint16_t keycode, keyrecord_t* record) {
   return true;
 }
 
+bool process_achordion(uint16_t keycode, keyrecord_t* record) {
+  // Don't process events that Achordion generated.
+  if (event_queue_is_injected(record)) {
+    return true;
+  }
+
+  const bool result = handle_event(keycode, record);
+  event_queue_drain();
+  return result;
+}
+
+#ifdef ACHORDION_CAPS_WORD_STREAK
+void achordion_caps_word_event(keyrecord_t* record) {
+  if (IS_KEYEVENT(record->event) && record->event.pressed &&
+      !keys_down_count()) {
+    caps_word_streak = is_caps_word_on();
+  }
+}
+
+uint16_t achordion_caps_word_keycode(uint16_t keycode) {
+  if (!caps_word_streak || !achordion_caps_word_tap(keycode)) {
+    return keycode;
+  }
+  if (IS_QK_MOD_TAP(keycode)) {
+    return QK_MOD_TAP_GET_TAP_KEYCODE(keycode);
+  } else if (IS_QK_LAYER_TAP(keycode)) {
+    return QK_LAYER_TAP_GET_TAP_KEYCODE(keycode);
+  }
+  return keycode;
+}
+#endif
+
 void achordion_task(void) {
   if (achordion_state == STATE_UNSETTLED &&
       timer_expired(timer_read(), hold_timer)) {
-    settle_as_hold();  // Timeout expired, settle the key as held.
+#ifdef ACHORDION_OVERLAP
+    if (other_pending) {
+      // Out of time to wait for the other key's release. A tap-hold key
+      // released first was rolled, otherwise it is held.
+      settle_overlap(!tap_hold_released);
+    } else
+#endif  // ACHORDION_OVERLAP
+      settle_as_hold();  // Timeout expired, settle the key as held.
+    event_queue_drain();
   }
 
 #ifdef ACHORDION_STREAK
-#define MAX_STREAK_TIMEOUT 800
   if (streak_timer &&
-      timer_expired(timer_read(), (streak_timer + MAX_STREAK_TIMEOUT))) {
+      timer_expired(timer_read(),
+                    (streak_timer + achordion_max_streak_timeout()))) {
     streak_timer = 0;  // Expired.
   }
 #endif
@@ -339,11 +466,20 @@ __attribute__((weak)) bool achordion_chord(uint16_t tap_hold_keycode,
 }
 
 // By default, the timeout is 1000 ms for all keys.
+uint16_t achordion_default_timeout(uint16_t tap_hold_keycode) { return 1000; }
+
 __attribute__((weak)) uint16_t achordion_timeout(uint16_t tap_hold_keycode) {
-  return 1000;
+  return achordion_default_timeout(tap_hold_keycode);
 }
 
-__attribute__((weak)) bool achordion_eager_mod(uint8_t mod) {
+#ifdef ACHORDION_OVERLAP
+__attribute__((weak)) uint8_t achordion_overlap_percent(
+    uint16_t tap_hold_keycode) {
+  return ACHORDION_OVERLAP_PERCENT;
+}
+#endif
+
+bool achordion_default_eager_mod(uint8_t mod) {
   switch (mod) {
     case MOD_LCTL:
     case MOD_LALT:
@@ -356,6 +492,10 @@ __attribute__((weak)) bool achordion_eager_mod(uint8_t mod) {
   }
 }
 
+__attribute__((weak)) bool achordion_eager_mod(uint8_t mod) {
+  return achordion_default_eager_mod(mod);
+}
+
 #ifdef ACHORDION_STREAK
 __attribute__((weak)) bool achordion_streak_continue(uint16_t keycode) {
   // If any mods other than shift or AltGr are held, don't continue the streak
@@ -377,6 +517,13 @@ __attribute__((weak)) bool achordion_streak_continue(uint16_t keycode) {
   return false;
 }
 
+// By default, a streak is forgotten 800 ms after its last key.
+uint16_t achordion_default_max_streak_timeout(void) { return 800; }
+
+__attribute__((weak)) uint16_t achordion_max_streak_timeout(void) {
+  return achordion_default_max_streak_timeout();
+}
+
 __attribute__((weak)) uint16_t achordion_streak_chord_timeout(
     uint16_t tap_hold_keycode, uint16_t next_keycode) {
   return achordion_streak_timeout(tap_hold_keycode);
@@ -388,4 +535,16 @@ achordion_streak_timeout(uint16_t tap_hold_keycode) {
 }
 #endif
 
+#ifdef ACHORDION_CAPS_WORD_STREAK
+// By default, mod-taps on letters, which Caps Word shifts, are taps. Layer-tap
+// keys keep their layers, for the digits and symbols that continue Caps Word.
+__attribute__((weak)) bool achordion_caps_word_tap(uint16_t tap_hold_keycode) {
+  if (!IS_QK_MOD_TAP(tap_hold_keycode)) {
+    return false;
+  }
+  const uint16_t tap_keycode = QK_MOD_TAP_GET_TAP_KEYCODE(tap_hold_keycode);
+  return tap_keycode >= KC_A && tap_keycode <= KC_Z;
+}
+#endif
+
 #endif  // version check
@@ -127,6 +127,9 @@ bool achordion_chord(uint16_t tap_hold_keycode, keyrecord_t* tap_hold_record,
  */
 uint16_t achordion_timeout(uint16_t tap_hold_keycode);
 
+/** Achordion's own timeout, 1000 ms, for callbacks that fall back to it. */
+uint16_t achordion_default_timeout(uint16_t tap_hold_keycode);
+
 /**
  * Optional callback defining which mods are "eagerly" applied.
  *
@@ -149,6 +152,44 @@ uint16_t achordion_timeout(uint16_t tap_hold_keycode);
  */
 bool achordion_eager_mod(uint8_t mod);
 
+/**
+ * Achordion's own eager mods, the left hand's, for callbacks that fall back
+ * to them.
+ */
+bool achordion_default_eager_mod(uint8_t mod);
+
+/**
+ * Settle tap-hold keys at the other key's release rather than its press by
+ * defining ACHORDION_OVERLAP.
+ *
+ * When another key is pressed while a tap-hold key is unsettled, its press is
+ * held back until its release. If at least ACHORDION_OVERLAP_PERCENT (50 by
+ * default) of its press fell inside the tap-hold key's, the tap-hold key is
+ * settled as held: a press nested inside the tap-hold key's overlaps fully,
+ * while in a roll the tap-hold key is released first. Otherwise it is settled
+ * as tapped. A third key pressed in the meantime settles the key with
+ * `achordion_chord()`, and the timeout settles it as held, or as tapped if it
+ * was already released.
+ *
+ * Enable with:
+ *
+ *    #define ACHORDION_OVERLAP
+ *
+ * Set the threshold per key by defining the following callback in your
+ * keymap.c, returning 0 to settle that key at the next press as usual:
+ *
+ *    uint8_t achordion_overlap_percent(uint16_t tap_hold_keycode) {
+ *      return 50;
+ *    }
+ */
+#ifdef ACHORDION_OVERLAP
+#ifndef ACHORDION_OVERLAP_PERCENT
+#define ACHORDION_OVERLAP_PERCENT 50
+#endif
+
+uint8_t achordion_overlap_percent(uint16_t tap_hold_keycode);
+#endif
+
 /**
  * Returns true if the args come from keys on opposite hands.
  *
@@ -177,6 +218,10 @@ bool achordion_opposite_hands(const keyrecord_t* tap_hold_record,
  *        uint16_t tap_hold_keycode, uint16_t next_keycode) {
  *      return 200;  // Default of 200 ms.
  *    }
+ *
+ * The streak is forgotten once no key has continued it for
+ * achordion_max_streak_timeout() ms, 800 ms by default. Chord timeouts longer
+ * than that have no effect.
  */
 #ifdef ACHORDION_STREAK
 uint16_t achordion_streak_chord_timeout(uint16_t tap_hold_keycode,
@@ -184,10 +229,69 @@ uint16_t achordion_streak_chord_timeout(uint16_t tap_hold_keycode,
 
 bool achordion_streak_continue(uint16_t keycode);
 
+uint16_t achordion_max_streak_timeout(void);
+
+/** Achordion's own max streak timeout, 800 ms, to fall back to. */
+uint16_t achordion_default_max_streak_timeout(void);
+
 /** @deprecated Use `achordion_streak_chord_timeout()` instead. */
 uint16_t achordion_streak_timeout(uint16_t tap_hold_keycode);
 #endif
 
+/**
+ * Type through Caps Word without tap-hold decisions by defining
+ * ACHORDION_CAPS_WORD_STREAK, with ACHORDION_STREAK and CAPS_WORD_ENABLE.
+ *
+ * While Caps Word is on, a streak lasts as long as it does: tap-hold keys for
+ * which `achordion_caps_word_tap()` returns true are looked up as their tap
+ * keys. QMK then sees plain keys, which it sends at the press instead of
+ * holding them back for the tapping term and Achordion's chord decision, and
+ * Caps Word shifts them as any other letter, without eager Shift. Those keys
+ * have no hold until Caps Word ends, at the first key that does not continue
+ * it or after CAPS_WORD_IDLE_TIMEOUT. A switch takes effect at the next press
+ * made with no key held, so no key is released under a keycode other than the
+ * one it was pressed with.
+ *
+ * Enable with:
+ *
+ *    #define ACHORDION_CAPS_WORD_STREAK
+ *
+ * call `achordion_caps_word_event()` from `pre_process_record_user()`, ahead
+ * of `keys_down_event()`, and look keys up through
+ * `achordion_caps_word_keycode()` in keymap.c:
+ *
+ *    uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key) {
+ *      return achordion_caps_word_keycode(
+ *          keycode_at_keymap_location(layer, key.row, key.col));
+ *    }
+ *
+ * By default, mod-taps on letters are taps while Caps Word is on. Choose the
+ * keys by defining the following callback in your keymap.c:
+ *
+ *    bool achordion_caps_word_tap(uint16_t tap_hold_keycode) {
+ *      return IS_QK_MOD_TAP(tap_hold_keycode);
+ *    }
+ */
+#if defined(ACHORDION_CAPS_WORD_STREAK) && \
+    (!defined(ACHORDION_STREAK) || !defined(CAPS_WORD_ENABLE))
+#error "ACHORDION_CAPS_WORD_STREAK needs ACHORDION_STREAK and CAPS_WORD_ENABLE"
+#endif
+
+#ifdef ACHORDION_CAPS_WORD_STREAK
+/** Follows Caps Word at a press made with no key held. */
+void achordion_caps_word_event(keyrecord_t* record);
+
+/** Tap keycode of `keycode` during a streak, `keycode` otherwise. */
+uint16_t achordion_caps_word_keycode(uint16_t keycode);
+
+bool achordion_caps_word_tap(uint16_t tap_hold_keycode);
+#else
+static inline void achordion_caps_word_event(keyrecord_t* record) {}
+static inline uint16_t achordion_caps_word_keycode(uint16_t keycode) {
+  return keycode;
+}
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,93 @@
+/**
+ * @file bypass_mode.c
+ * @brief Gaming mode: every key a plain key, with no tap-hold resolution.
+ */
+
+#include "bypass_mode.h"
+
+#ifdef BYPASS_MODE_ENABLE
+#include "keys_down.h"
+#include "user_hid.h"
+
+bool bypass_mode_active = false;
+// State to switch to once no key is held.
+static bool requested = false;
+static uint16_t plain_keymap[BYPASS_MODE_LAYERS][MATRIX_ROWS][MATRIX_COLS];
+
+// Returns the key a tap-hold keycode taps, or `keycode` itself otherwise.
+static uint16_t plain_keycode(uint16_t keycode) {
+  if (IS_QK_MOD_TAP(keycode)) {
+    return QK_MOD_TAP_GET_TAP_KEYCODE(keycode);
+  } else if (IS_QK_LAYER_TAP(keycode)) {
+    return QK_LAYER_TAP_GET_TAP_KEYCODE(keycode);
+  }
+  return keycode;
+}
+
+static void build_plain_keymap(void) {
+  for (uint8_t layer = 0; layer < BYPASS_MODE_LAYERS; ++layer) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; ++row) {
+      for (uint8_t col = 0; col < MATRIX_COLS; ++col) {
+        plain_keymap[layer][row][col] =
+            plain_keycode(keycode_at_keymap_location(layer, row, col));
+      }
+    }
+  }
+}
+
+uint16_t bypass_mode_keycode(uint8_t layer, keypos_t key) {
+  if (key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+    return KC_NO;
+  }
+  if (!bypass_mode_active) {
+    return keycode_at_keymap_location(layer, key.row, key.col);
+  }
+  if (layer < BYPASS_MODE_LAYERS) {
+    return plain_keymap[layer][key.row][key.col];
+  }
+  return plain_keycode(keycode_at_keymap_location(layer, key.row, key.col));
+}
+
+void bypass_mode_set(bool on) {
+  requested = on;
+  bypass_mode_task();
+}
+
+void bypass_mode_toggle(void) { bypass_mode_set(!requested); }
+
+void bypass_mode_task(void) {
+  if (requested == bypass_mode_active || keys_down_count()) {
+    return;
+  }
+  if (requested) {
+    build_plain_keymap();
+  }
+  bypass_mode_active = requested;
+  dprintf("bypass_mode: %s\n", requested ? "on" : "off");
+}
+
+bool process_bypass_mode_hid(uint8_t* data, uint8_t length) {
+  if (data[0] != USER_HID_BYPASS) {
+    return true;
+  }
+
+  switch (data[1]) {
+    case 0x01:  // Set.
+      bypass_mode_set(data[2]);
+      break;
+    case 0x02:  // Toggle.
+      bypass_mode_toggle();
+      break;
+    case 0x00:  // Status.
+      break;
+    default:
+      user_hid_reply(data, length, USER_HID_ERROR);
+      return false;
+  }
+  data[2] = bypass_mode_active;
+  data[3] = requested != bypass_mode_active;
+  data[4] = keys_down_count();
+  user_hid_reply(data, length, USER_HID_OK);
+  return false;
+}
+#endif  // BYPASS_MODE_ENABLE
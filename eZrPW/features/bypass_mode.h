@@ -0,0 +1,84 @@
+/**
+ * @file bypass_mode.h
+ * @brief Gaming mode: every key a plain key, with no tap-hold resolution.
+ *
+ * While bypass mode is on, bypass_mode_keycode() looks keys up in a plain
+ * copy of the keymap in which mod-tap and layer-tap keys are replaced by their
+ * tap keycodes. QMK then sees no tap-hold keys, so presses are sent as they
+ * happen instead of waiting out the tapping term, and the keymap skips
+ * `process_achordion()` with the one check in bypass_mode_is_on(). Layer-tap
+ * keys lose their layers meanwhile.
+ *
+ * The copy is built from the keymap each time the mode turns on. A switch
+ * takes effect once no key is held (see keys_down.h), so no press is
+ * released under a keycode other than the one it was pressed with.
+ *
+ * Enable in custom.mk with
+ *
+ *     BYPASS_MODE_ENABLE = yes
+ *
+ * look keys up with `bypass_mode_keycode()` in the keymap's
+ * `keymap_key_to_keycode()`, call `bypass_mode_task()` from
+ * `housekeeping_task_user()`, and toggle with `scripts/user_hid.py bypass`.
+ * Oryx writes the layers and the keycode enum of keymap.c, so the mode has no
+ * keycode of its own.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Layers copied into the plain keymap; higher ones are converted per lookup. */
+#ifndef BYPASS_MODE_LAYERS
+#define BYPASS_MODE_LAYERS 4
+#endif
+
+#ifdef BYPASS_MODE_ENABLE
+extern bool bypass_mode_active;
+
+/** Returns true while bypass mode is on. */
+static inline bool bypass_mode_is_on(void) { return bypass_mode_active; }
+
+/**
+ * Keycode of `key` on `layer`, from the plain copy while bypass mode is on.
+ * Matches QMK's weak keymap_common.c lookup for the matrix otherwise (the
+ * Voyager has no encoders to map).
+ */
+uint16_t bypass_mode_keycode(uint8_t layer, keypos_t key);
+
+/** Turns bypass mode on or off, once no key is held. */
+void bypass_mode_set(bool on);
+
+void bypass_mode_toggle(void);
+
+/** Applies a pending switch. Call from `housekeeping_task_user()`. */
+void bypass_mode_task(void);
+
+/**
+ * Raw HID handler for `USER_HID_BYPASS`, see user_hid.h.
+ *
+ * Subcommand 0x00 replies with whether the mode is on, whether a switch is
+ * pending and the number of keys held. Subcommand 0x01 turns the mode on if
+ * byte 2 is nonzero and off otherwise, and 0x02 toggles it; both reply as
+ * 0x00 does.
+ */
+bool process_bypass_mode_hid(uint8_t* data, uint8_t length);
+#else
+static inline bool bypass_mode_is_on(void) { return false; }
+static inline uint16_t bypass_mode_keycode(uint8_t layer, keypos_t key) {
+  if (key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+    return KC_NO;
+  }
+  return keycode_at_keymap_location(layer, key.row, key.col);
+}
+static inline void bypass_mode_toggle(void) {}
+static inline void bypass_mode_task(void) {}
+#endif  // BYPASS_MODE_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,59 @@
+/**
+ * @file cycle_counter.h
+ * @brief Free-running cycle counter for timing hot paths.
+ *
+ * On Cortex-M3/M4/M7 parts, such as the Voyager's STM32F303, this reads the
+ * DWT CYCCNT register, which counts core clock cycles. Elsewhere, such as in
+ * the host simulator, it falls back to a monotonic clock in nanoseconds so the
+ * same instrumentation produces numbers off-target.
+ *
+ * Counts are 32 bits and wrap (after ~59 s at 72 MHz), so only ever compare
+ * two readings by unsigned subtraction.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+#define CYCLE_COUNTER_DWT
+
+// Debug registers, addressed directly to avoid depending on CMSIS headers.
+#define CYCLE_COUNTER_DEMCR (*(volatile uint32_t*)0xE000EDFCu)
+#define CYCLE_COUNTER_DWT_CTRL (*(volatile uint32_t*)0xE0001000u)
+#define CYCLE_COUNTER_DWT_CYCCNT (*(volatile uint32_t*)0xE0001004u)
+
+/** Starts the counter. Safe to call more than once. */
+static inline void cycle_counter_init(void) {
+  CYCLE_COUNTER_DEMCR |= (1u << 24);  // TRCENA: enable the DWT unit.
+  CYCLE_COUNTER_DWT_CTRL |= 1u;       // CYCCNTENA: start counting.
+}
+
+/** Reads the current count. */
+static inline uint32_t cycle_counter_read(void) {
+  return CYCLE_COUNTER_DWT_CYCCNT;
+}
+#else
+#include <time.h>
+
+static inline void cycle_counter_init(void) {}
+
+static inline uint32_t cycle_counter_read(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+#endif
+
+/**
+ * Number of buckets used by log2 histograms of counter differences.
+ */
+#define CYCLE_COUNTER_BUCKETS 32
+
+/**
+ * Returns the log2 histogram bucket for `cycles`: bucket b holds values in
+ * [2^b, 2^(b+1)), with 0 going to bucket 0.
+ */
+static inline uint8_t cycle_counter_bucket(uint32_t cycles) {
+  return cycles ? 31 - __builtin_clz(cycles) : 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file event_queue.c
+ * @brief Bounded queue of key events injected back into `process_record()`.
+ */
+
+#include "event_queue.h"
+
+typedef struct {
+  keyrecord_t record;
+  uint16_t delay_ms;
+  // Processed from the top of the pipeline, see event_queue_push_raw().
+  bool raw;
+} queued_event_t;
+
+static queued_event_t queue[EVENT_QUEUE_SIZE];
+// Index of the oldest event and number of events queued.
+static uint8_t head = 0;
+static uint8_t count = 0;
+// The event being processed, NULL when not draining.
+static const keyrecord_t* injected = NULL;
+// Whether a raw event is being passed to `action_exec()`.
+static bool replaying = false;
+
+// Processes one event as injected.
+static void process_injected(queued_event_t* event) {
+  if (event->raw) {
+    // A raw event is new to Achordion, which must drain what it plumbs while
+    // it handles the event, before QMK's tap-hold handling passes it the
+    // events buffered behind, so it is not marked as injected.
+    replaying = true;
+    action_exec(event->record.event);
+    replaying = false;
+    return;
+  }
+  const keyrecord_t* outer = injected;
+  injected = &event->record;
+#if defined(POINTING_DEVICE_ENABLE) && defined(POINTING_DEVICE_AUTO_MOUSE_ENABLE)
+  int8_t mouse_key_tracker = get_auto_mouse_key_tracker();
+#endif
+  process_record(&event->record);
+#if defined(POINTING_DEVICE_ENABLE) && defined(POINTING_DEVICE_AUTO_MOUSE_ENABLE)
+  set_auto_mouse_key_tracker(mouse_key_tracker);
+#endif
+  injected = outer;
+
+  // A release queued right behind would otherwise cancel the press before
+  // the host saw it.
+  if (event->record.event.pressed || event->delay_ms) {
+    send_keyboard_report();
+  }
+  if (event->delay_ms) {
+    wait_ms(event->delay_ms);
+  }
+}
+
+_Static_assert(EVENT_QUEUE_SIZE >= EVENT_QUEUE_ACHORDION_EVENTS,
+               "EVENT_QUEUE_SIZE too small for Achordion's events");
+
+// Takes the oldest event out, then processes it. Processing may push more
+// events, which is why it is taken out first.
+static void process_head(void) {
+  queued_event_t event = queue[head];
+  head = (head + 1) % EVENT_QUEUE_SIZE;
+  --count;
+  process_injected(&event);
+}
+
+static void push(const queued_event_t* event) {
+  if (count == EVENT_QUEUE_SIZE) {
+    // Unreachable with the sizes checked at compile time. Processing the new
+    // event in place would put it ahead of the queued ones.
+    dprintln("event_queue: Full, processing the oldest event first.");
+    process_head();
+  }
+  queue[(head + count) % EVENT_QUEUE_SIZE] = *event;
+  ++count;
+}
+
+void event_queue_push(const keyrecord_t* record, uint16_t delay_ms) {
+  push(&(queued_event_t){.record = *record, .delay_ms = delay_ms});
+}
+
+void event_queue_push_raw(const keyrecord_t* record) {
+  push(&(queued_event_t){.record = *record, .raw = true});
+}
+
+void event_queue_drain(void) {
+  if (injected) {
+    return;  // The outer drain loop takes the new events.
+  }
+  while (count) {
+    process_head();
+  }
+}
+
+bool event_queue_is_injected(const keyrecord_t* record) {
+  return record == injected;
+}
+
+bool event_queue_is_replaying(void) { return replaying; }
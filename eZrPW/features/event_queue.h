@@ -0,0 +1,91 @@
+/**
+ * @file event_queue.h
+ * @brief Bounded queue of key events injected back into `process_record()`.
+ *
+ * Achordion settles a tap-hold key by plumbing events back through the
+ * record pipeline: the settled tap or hold, and then the event that settled
+ * it. Instead of calling `process_record()` at the point each event is
+ * decided, it pushes them here and drains the queue once, on the way out of
+ * `process_achordion()` or `achordion_task()`. The events are processed one
+ * after another in a loop, so however many a settle produces, each is
+ * processed one level down from the event that settled it, and events pushed
+ * while an injected event is processed are taken by the same loop rather
+ * than a nested one.
+ *
+ * Handlers recognize the events being replayed with event_queue_is_injected(),
+ * by the identity of the record pointer, so they can let them through
+ * untouched.
+ *
+ * Events pushed with event_queue_push_raw() replay from the top of the
+ * pipeline instead, through `action_exec()` and QMK's tap-hold handling, for
+ * position_combos.c to release the presses it held back. Its handler, called
+ * again from `pre_process_record_user()`, recognizes them with
+ * event_queue_is_replaying(). They are not injected: Achordion handles them
+ * as new events, and drains what it plumbs while doing so, in a loop nested
+ * in the one replaying the raw event. Drain loops thus nest two levels deep,
+ * and `action_exec()` runs inside the `pre_process_record_user()` of the
+ * event that ended the held back set. It goes no deeper, since
+ * position_combos.c only pushes raw events outside a drain and drains each
+ * at once, so the nested loop finds only Achordion's events, which are
+ * injected and start no loop of their own.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Most events Achordion pushes while handling one event, before the queue is
+ * drained on its way out. With ACHORDION_OVERLAP, settling a tap pushes its
+ * press and release, the other key's held back press, the tap-hold key's
+ * release as a hold press and release, and the event itself.
+ */
+#define EVENT_QUEUE_ACHORDION_EVENTS 6
+
+/**
+ * Queue size in events. A raw event is taken out of the queue before it is
+ * processed, so the nested loop holds only Achordion's events, but the size
+ * also covers all the presses position_combos.c replays for one set of held
+ * back keys being queued ahead of those. Both check at compile time that
+ * they fit.
+ */
+#ifndef EVENT_QUEUE_SIZE
+#define EVENT_QUEUE_SIZE 10
+#endif
+
+/**
+ * Appends a copy of `record` to the queue. The keyboard report is sent after
+ * a press is processed. If `delay_ms` is nonzero, the report is sent after
+ * any event and the keyboard then waits that long, as `tap_code()` does with
+ * TAP_CODE_DELAY.
+ *
+ * Should the queue be full nonetheless, the oldest queued event is processed
+ * first to make room, so events keep their order.
+ */
+void event_queue_push(const keyrecord_t* record, uint16_t delay_ms);
+
+/**
+ * Appends `record`'s event to the queue, to be processed as a new event from
+ * the matrix would be. A full queue is handled as by event_queue_push().
+ */
+void event_queue_push_raw(const keyrecord_t* record);
+
+/**
+ * Processes the queued events in order, including any pushed meanwhile.
+ * Returns at once when called while an injected event is processed.
+ */
+void event_queue_drain(void);
+
+/** Returns true if `record` is an event the queue is processing. */
+bool event_queue_is_injected(const keyrecord_t* record);
+
+/** Returns true while an event pushed with event_queue_push_raw() starts. */
+bool event_queue_is_replaying(void);
+
+#ifdef __cplusplus
+}
+#endif
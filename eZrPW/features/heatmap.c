@@ -0,0 +1,131 @@
+/**
+ * @file heatmap.c
+ * @brief Typing heatmap: per-key press counters shown on the LEDs.
+ */
+
+#include "heatmap.h"
+
+#ifdef HEATMAP_ENABLE
+#include "user_hid.h"
+
+#define NUM_KEYS (MATRIX_ROWS * MATRIX_COLS)
+
+extern rgb_config_t rgb_matrix_config;
+
+static bool heatmap_on = false;
+static uint8_t heat[NUM_KEYS];
+static uint16_t decay_timer = 0;
+// Matrix position of each LED, UINT8_MAX for none.
+static uint8_t led_keys[RGB_MATRIX_LED_COUNT];
+// Colors by counter / (256 / HEATMAP_RAMP_SIZE), and the brightness they
+// were converted at. All black is right for brightness 0.
+static RGB ramp[HEATMAP_RAMP_SIZE];
+static uint8_t ramp_value = 0;
+
+_Static_assert((HEATMAP_RAMP_SIZE & (HEATMAP_RAMP_SIZE - 1)) == 0 &&
+                   HEATMAP_RAMP_SIZE >= 4 && HEATMAP_RAMP_SIZE <= 256,
+               "HEATMAP_RAMP_SIZE must be a power of 2 from 4 to 256.");
+
+void heatmap_init(void) {
+  memset(led_keys, UINT8_MAX, sizeof(led_keys));
+  for (uint8_t row = 0; row < MATRIX_ROWS; ++row) {
+    for (uint8_t col = 0; col < MATRIX_COLS; ++col) {
+      const uint8_t led = g_led_config.matrix_co[row][col];
+      if (led < RGB_MATRIX_LED_COUNT) {
+        led_keys[led] = row * MATRIX_COLS + col;
+      }
+    }
+  }
+}
+
+bool heatmap_is_on(void) { return heatmap_on; }
+
+void heatmap_set(bool on) { heatmap_on = on; }
+
+void heatmap_toggle(void) { heatmap_on = !heatmap_on; }
+
+void heatmap_event(keyrecord_t* record) {
+  const keypos_t key = record->event.key;
+  if (!IS_KEYEVENT(record->event) || !record->event.pressed ||
+      key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+    return;
+  }
+  uint8_t* h = &heat[key.row * MATRIX_COLS + key.col];
+  *h = *h < UINT8_MAX - HEATMAP_INCREMENT ? *h + HEATMAP_INCREMENT : UINT8_MAX;
+}
+
+void heatmap_task(void) {
+  if (timer_elapsed(decay_timer) < HEATMAP_DECAY_MS) {
+    return;
+  }
+  decay_timer = timer_read();
+  for (uint8_t i = 0; i < NUM_KEYS; ++i) {
+    // Rounded up, so counters reach 0.
+    heat[i] -= (heat[i] + (1 << HEATMAP_DECAY_SHIFT) - 1) >>
+               HEATMAP_DECAY_SHIFT;
+  }
+}
+
+// Blue for the coolest keys counted, through green, to red for the hottest.
+static void build_ramp(void) {
+  ramp_value = rgb_matrix_config.hsv.v;
+  ramp[0] = (RGB){0, 0, 0};
+  for (uint16_t i = 1; i < HEATMAP_RAMP_SIZE; ++i) {
+    const HSV hsv = {
+        .h = 170 - 170 * (i - 1) / (HEATMAP_RAMP_SIZE - 2),
+        .s = 255,
+        .v = ramp_value,
+    };
+    ramp[i] = hsv_to_rgb(hsv);
+  }
+}
+
+RGB heatmap_color(uint8_t led) {
+  if (rgb_matrix_config.hsv.v != ramp_value) {
+    build_ramp();
+  }
+  const uint8_t key = led_keys[led];
+  if (key == UINT8_MAX) {
+    return ramp[0];
+  }
+  return ramp[heat[key] / (256 / HEATMAP_RAMP_SIZE)];
+}
+
+bool process_heatmap_hid(uint8_t* data, uint8_t length) {
+  if (data[0] != USER_HID_HEATMAP) {
+    return true;
+  }
+
+  const uint8_t offset = data[2];
+  const uint8_t count = data[3];
+  switch (data[1]) {
+    case 0x01:  // Set.
+      heatmap_set(data[2]);
+      break;
+    case 0x02:  // Toggle.
+      heatmap_toggle();
+      break;
+    case 0x03:  // Read.
+      if (count > length - 2 || offset + count > NUM_KEYS) {
+        user_hid_reply(data, length, USER_HID_ERROR);
+        return false;
+      }
+      memcpy(data + 2, heat + offset, count);
+      user_hid_reply(data, length, USER_HID_OK);
+      return false;
+    case 0x04:  // Clear.
+      memset(heat, 0, sizeof(heat));
+      break;
+    case 0x00:  // Status.
+      break;
+    default:
+      user_hid_reply(data, length, USER_HID_ERROR);
+      return false;
+  }
+  data[2] = heatmap_on;
+  data[3] = MATRIX_ROWS;
+  data[4] = MATRIX_COLS;
+  user_hid_reply(data, length, USER_HID_OK);
+  return false;
+}
+#endif  // HEATMAP_ENABLE
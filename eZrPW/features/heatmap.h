@@ -0,0 +1,97 @@
+/**
+ * @file heatmap.h
+ * @brief Typing heatmap: per-key press counters shown on the LEDs.
+ *
+ * Each matrix position has an 8-bit counter, raised by HEATMAP_INCREMENT at
+ * each press that reaches `process_record_user()` and decayed every
+ * HEATMAP_DECAY_MS by 1/2^HEATMAP_DECAY_SHIFT of its value, rounded up so it
+ * reaches 0. A press is one saturating add; the decay is a shift per counter.
+ *
+ * While the heatmap is on, it is shown in place of the layer colors, through
+ * layer_lighting.h as the pseudo-layer LAYER_LIGHTING_HEATMAP: the frame cache
+ * is refreshed from the counters LAYER_LIGHTING_CHUNK_LEDS LEDs per frame, each
+ * a lookup into a ramp of HEATMAP_RAMP_SIZE colors from blue to red, so a
+ * frame costs no more than showing a layer. The ramp is converted from HSV
+ * when the brightness changes. Keys with a counter under 256 /
+ * HEATMAP_RAMP_SIZE are dark.
+ *
+ * Enable in custom.mk with
+ *
+ *     HEATMAP_ENABLE = yes
+ *
+ * call `heatmap_init()` from `keyboard_post_init_user()`, `heatmap_event()`
+ * from `process_record_user()` and `heatmap_task()` from
+ * `housekeeping_task_user()`, and toggle with `scripts/user_hid.py heatmap`,
+ * which also prints the counters. Oryx writes the keycode enum of keymap.c,
+ * so the heatmap has no keycode of its own.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Counter increase per press. */
+#ifndef HEATMAP_INCREMENT
+#define HEATMAP_INCREMENT 16
+#endif
+
+/** Time between decay steps, in ms. */
+#ifndef HEATMAP_DECAY_MS
+#define HEATMAP_DECAY_MS 1000
+#endif
+
+/** Each decay step takes 1/2^HEATMAP_DECAY_SHIFT off the counters. */
+#ifndef HEATMAP_DECAY_SHIFT
+#define HEATMAP_DECAY_SHIFT 3
+#endif
+
+/** Colors in the ramp, a power of 2. */
+#ifndef HEATMAP_RAMP_SIZE
+#define HEATMAP_RAMP_SIZE 16
+#endif
+
+#ifdef HEATMAP_ENABLE
+/** Maps LEDs to matrix positions. Call from `keyboard_post_init_user()`. */
+void heatmap_init(void);
+
+/** Returns true while the heatmap is shown. */
+bool heatmap_is_on(void);
+
+void heatmap_set(bool on);
+
+void heatmap_toggle(void);
+
+/** Counts presses. Call from `process_record_user()`. */
+void heatmap_event(keyrecord_t* record);
+
+/** Decays the counters. Call from `housekeeping_task_user()`. */
+void heatmap_task(void);
+
+/** Color of LED `led` for its counter, at the RGB Matrix brightness. */
+RGB heatmap_color(uint8_t led);
+
+/**
+ * Raw HID handler for `USER_HID_HEATMAP`, see user_hid.h.
+ *
+ * Subcommand 0x00 replies with whether the heatmap is shown, MATRIX_ROWS and
+ * MATRIX_COLS. 0x01 shows it if byte 2 is nonzero and hides it otherwise,
+ * 0x02 toggles it and 0x04 clears the counters; these reply as 0x00 does.
+ * 0x03 reads the count in byte 3, up to 30, of counters from the matrix
+ * position in byte 2 (row * MATRIX_COLS + col) into the reply's payload.
+ */
+bool process_heatmap_hid(uint8_t* data, uint8_t length);
+#else
+static inline void heatmap_init(void) {}
+static inline bool heatmap_is_on(void) { return false; }
+static inline void heatmap_toggle(void) {}
+static inline void heatmap_event(keyrecord_t* record) {}
+static inline void heatmap_task(void) {}
+#endif  // HEATMAP_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,56 @@
+/**
+ * @file idle.c
+ * @brief Idle states: housekeeping and LEDs wound down between key events.
+ */
+
+#include "idle.h"
+
+#ifdef IDLE_ENABLE
+#include "achordion.h"
+#include "keys_down.h"
+
+static idle_state_t state = IDLE_STATE_ACTIVE;
+static uint32_t last_event = 0;
+
+// Achordion clears an expired streak from achordion_task(), so that has to
+// keep running until it did.
+static uint32_t quiet_after(void) {
+#ifdef ACHORDION_STREAK
+  return (uint32_t)achordion_max_streak_timeout() + IDLE_QUIET_MS;
+#else
+  return IDLE_QUIET_MS;
+#endif
+}
+
+void idle_init(void) {
+  state = IDLE_STATE_ACTIVE;
+  last_event = timer_read32();
+}
+
+void idle_event(keyrecord_t* record) {
+  if (!IS_KEYEVENT(record->event)) {
+    return;
+  }
+  last_event = timer_read32();
+  state = IDLE_STATE_ACTIVE;
+}
+
+void idle_task(void) {
+  if (keys_down_count() || state == IDLE_STATE_ASLEEP) {
+    return;
+  }
+  const uint32_t elapsed = timer_elapsed32(last_event);
+#if defined(RGB_MATRIX_TIMEOUT) && RGB_MATRIX_TIMEOUT > 0
+  // QMK turns the LEDs off by then, see custom_config.h.
+  if (elapsed > RGB_MATRIX_TIMEOUT) {
+    state = IDLE_STATE_ASLEEP;
+    return;
+  }
+#endif
+  if (state == IDLE_STATE_ACTIVE && elapsed >= quiet_after()) {
+    state = IDLE_STATE_QUIET;
+  }
+}
+
+idle_state_t idle_state(void) { return state; }
+#endif  // IDLE_ENABLE
@@ -0,0 +1,73 @@
+/**
+ * @file idle.h
+ * @brief Idle states: housekeeping and LEDs wound down between key events.
+ *
+ * The keyboard is in one of three states, driven by the time of the last key
+ * event and by whether any key is down:
+ *
+ *  * IDLE_STATE_ACTIVE while a key is down, and until IDLE_QUIET_MS after
+ *    Achordion's longest streak timeout has passed since the last key event.
+ *  * IDLE_STATE_QUIET after that. Achordion and position combos have no
+ *    pending work once all keys are released and their timers ran out, so
+ *    `housekeeping_task_user()` skips their tasks.
+ *  * IDLE_STATE_ASLEEP once RGB_MATRIX_TIMEOUT has passed without key events.
+ *    QMK core's timeout, which custom_config.h sets when custom.mk has
+ *    IDLE_RGB_TIMEOUT = yes, then stops the RGB Matrix effect and the
+ *    indicator callbacks and turns the LEDs off. Without a timeout the
+ *    keyboard stays quiet.
+ *
+ * The first key event returns to IDLE_STATE_ACTIVE, and QMK brings the LEDs
+ * back. Nothing holds events back, so that event is processed at once, as any
+ * other; the skipped tasks only had expired timers to find. Raw HID commands
+ * do not wake the keyboard: the housekeeping they rely on, such as bypass
+ * mode's, keeps running.
+ *
+ * Enable in custom.mk with
+ *
+ *     IDLE_ENABLE = yes
+ *
+ * call `idle_init()` from `keyboard_post_init_user()`, `idle_event()` from
+ * `pre_process_record_user()` and `idle_task()` from
+ * `housekeeping_task_user()`, ahead of the tasks it gates on `idle_state()`.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Time after Achordion's max streak timeout before housekeeping winds down. */
+#ifndef IDLE_QUIET_MS
+#define IDLE_QUIET_MS 500
+#endif
+
+typedef enum {
+  IDLE_STATE_ACTIVE,
+  IDLE_STATE_QUIET,
+  IDLE_STATE_ASLEEP,
+} idle_state_t;
+
+#ifdef IDLE_ENABLE
+/** Starts active. Call from `keyboard_post_init_user()`. */
+void idle_init(void);
+
+/** Wakes on key events. Call from `pre_process_record_user()`. */
+void idle_event(keyrecord_t* record);
+
+/** Winds down as time passes. Call from `housekeeping_task_user()`. */
+void idle_task(void);
+
+idle_state_t idle_state(void);
+#else
+static inline void idle_init(void) {}
+static inline void idle_event(keyrecord_t* record) {}
+static inline void idle_task(void) {}
+static inline idle_state_t idle_state(void) { return IDLE_STATE_ACTIVE; }
+#endif  // IDLE_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,89 @@
+/**
+ * @file key_trace.c
+ * @brief Records physical key events for replay in the host simulator.
+ */
+
+#include "key_trace.h"
+
+#ifdef KEY_TRACE_ENABLE
+#include "key_trace_format.h"
+#include "user_hid.h"
+
+#define RECORDS_PER_PACKET 7
+
+static key_trace_record_t ring[KEY_TRACE_SIZE];
+// Index of the oldest record and number of records buffered.
+static uint16_t head = 0;
+static uint16_t count = 0;
+static uint32_t dropped = 0;
+// Time of the last record, which the next one's delta is relative to.
+static uint32_t last_time = 0;
+
+void key_trace_reset(void) {
+  head = 0;
+  count = 0;
+  dropped = 0;
+  last_time = timer_read32();
+}
+
+static void push(key_trace_record_t record) {
+  ring[(head + count) % KEY_TRACE_SIZE] = record;
+  ++count;
+}
+
+void key_trace_event(keyrecord_t* record) {
+  if (!IS_KEYEVENT(record->event)) {
+    return;
+  }
+  const uint32_t now = timer_read32();
+  uint32_t delta = now - last_time;
+  // Time records for long gaps, then the event itself.
+  const uint32_t needed = 1 + (delta ? (delta - 1) / UINT16_MAX : 0);
+  if (count + needed > KEY_TRACE_SIZE) {
+    ++dropped;
+    return;
+  }
+  for (; delta > UINT16_MAX; delta -= UINT16_MAX) {
+    push(key_trace_time_record(UINT16_MAX));
+  }
+  push(key_trace_record(delta, record->event.key.row, record->event.key.col,
+                        record->event.pressed ? KEY_TRACE_PRESSED : 0));
+  last_time = now;
+}
+
+bool process_key_trace_hid(uint8_t* data, uint8_t length) {
+  if (data[0] != USER_HID_KEY_TRACE) {
+    return true;
+  }
+
+  switch (data[1]) {
+    case 0x00:  // Status.
+      user_hid_put16(data + 2, count);
+      user_hid_put32(data + 4, dropped);
+      user_hid_put32(data + 8, timer_read32());
+      user_hid_reply(data, length, USER_HID_OK);
+      break;
+
+    case 0x01: {  // Drain up to RECORDS_PER_PACKET records.
+      const uint8_t n = count < RECORDS_PER_PACKET ? count : RECORDS_PER_PACKET;
+      data[2] = n;
+      for (uint8_t i = 0; i < n; ++i) {
+        memcpy(data + 3 + i * KEY_TRACE_RECORD_SIZE, &ring[head],
+               KEY_TRACE_RECORD_SIZE);
+        head = (head + 1) % KEY_TRACE_SIZE;
+      }
+      count -= n;
+      user_hid_reply(data, length, USER_HID_OK);
+    } break;
+
+    case 0x02:  // Reset.
+      key_trace_reset();
+      user_hid_reply(data, length, USER_HID_OK);
+      break;
+
+    default:
+      user_hid_reply(data, length, USER_HID_ERROR);
+  }
+  return false;
+}
+#endif  // KEY_TRACE_ENABLE
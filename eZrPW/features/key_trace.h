@@ -0,0 +1,55 @@
+/**
+ * @file key_trace.h
+ * @brief Records physical key events for replay in the host simulator.
+ *
+ * Every key event `pre_process_record_user()` sees, after debouncing and
+ * before tap-hold buffering, is appended to a RAM ring buffer as a record of
+ * the binary trace format in key_trace_format.h. The host drains the buffer
+ * over raw HID while typing, so real sessions can be replayed through
+ * sim/sim_replay. When the host falls behind, new events are dropped and
+ * counted rather than overwriting older ones, so a trace never has holes in
+ * its timing.
+ *
+ * Enable in custom.mk with
+ *
+ *     KEY_TRACE_ENABLE = yes
+ *
+ * and record with `scripts/user_hid.py trace -o session.ktr`.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Ring buffer size in records of 4 bytes. */
+#ifndef KEY_TRACE_SIZE
+#define KEY_TRACE_SIZE 512
+#endif
+
+#ifdef KEY_TRACE_ENABLE
+/** Records a key event. Call from `pre_process_record_user()`. */
+void key_trace_event(keyrecord_t* record);
+
+/** Empties the buffer and restarts the trace clock. */
+void key_trace_reset(void);
+
+/**
+ * Raw HID handler for `USER_HID_KEY_TRACE`, see user_hid.h.
+ *
+ * Subcommand 0x00 replies with the number of buffered records, the number of
+ * dropped events and `timer_read32()`. Subcommand 0x01 removes up to 7
+ * records from the buffer, replying with their number in byte 2 and the
+ * records from byte 3. Subcommand 0x02 resets.
+ */
+bool process_key_trace_hid(uint8_t* data, uint8_t length);
+#else
+static inline void key_trace_event(keyrecord_t* record) {}
+#endif  // KEY_TRACE_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,91 @@
+/**
+ * @file key_trace_format.h
+ * @brief Binary key event trace format, shared by firmware and host tools.
+ *
+ * A trace file is a 16-byte header followed by fixed-width 4-byte records,
+ * all little endian:
+ *
+ *     header:  "KTRC"  u16 version  u16 record size  u32 start ms  u32 count
+ *     record:  u16 delta ms  u8 key  u8 flags
+ *
+ * `delta` is the time since the previous record (or since `start` for the
+ * first). `key` packs the matrix position as row << 4 | col; the value
+ * KEY_TRACE_NO_KEY marks a record that only advances time, for gaps longer
+ * than 65535 ms. `flags` holds the pressed bit and, for traces generated with
+ * a known intent, whether the press was meant as a tap or a hold. `count` may
+ * be 0 when the writer could not know it up front; readers then take the
+ * records up to the end of the file.
+ *
+ * Writers: features/key_trace.c on the keyboard (saved by
+ * `scripts/user_hid.py trace`) and scripts/gen_trace.py. Reader: sim/trace.h.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KEY_TRACE_MAGIC "KTRC"
+#define KEY_TRACE_VERSION 1
+#define KEY_TRACE_HEADER_SIZE 16
+#define KEY_TRACE_RECORD_SIZE 4
+
+#define KEY_TRACE_NO_KEY 0xFF
+
+/** Record flags. */
+enum {
+  KEY_TRACE_PRESSED = 0x01,
+  /** Intent, in bits 1-2: none, tap or hold. */
+  KEY_TRACE_INTENT_SHIFT = 1,
+  KEY_TRACE_INTENT_MASK = 0x06,
+  KEY_TRACE_INTENT_NONE = 0,
+  KEY_TRACE_INTENT_TAP = 1,
+  KEY_TRACE_INTENT_HOLD = 2,
+};
+
+typedef struct {
+  uint8_t bytes[KEY_TRACE_RECORD_SIZE];
+} key_trace_record_t;
+
+static inline key_trace_record_t key_trace_record(uint16_t delta, uint8_t row,
+                                                  uint8_t col, uint8_t flags) {
+  return (key_trace_record_t){{delta & 0xff, delta >> 8,
+                               (uint8_t)(row << 4 | (col & 0x0f)), flags}};
+}
+
+/** A record advancing time by `delta` ms without a key event. */
+static inline key_trace_record_t key_trace_time_record(uint16_t delta) {
+  return (key_trace_record_t){{delta & 0xff, delta >> 8, KEY_TRACE_NO_KEY, 0}};
+}
+
+static inline uint16_t key_trace_delta(const key_trace_record_t* r) {
+  return r->bytes[0] | (r->bytes[1] << 8);
+}
+
+static inline bool key_trace_has_key(const key_trace_record_t* r) {
+  return r->bytes[2] != KEY_TRACE_NO_KEY;
+}
+
+static inline uint8_t key_trace_row(const key_trace_record_t* r) {
+  return r->bytes[2] >> 4;
+}
+
+static inline uint8_t key_trace_col(const key_trace_record_t* r) {
+  return r->bytes[2] & 0x0f;
+}
+
+static inline bool key_trace_pressed(const key_trace_record_t* r) {
+  return r->bytes[3] & KEY_TRACE_PRESSED;
+}
+
+static inline uint8_t key_trace_intent(const key_trace_record_t* r) {
+  return (r->bytes[3] & KEY_TRACE_INTENT_MASK) >> KEY_TRACE_INTENT_SHIFT;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,22 @@
+/**
+ * @file keys_down.c
+ * @brief Number of keys held, counted once for the modules that wait on it.
+ */
+
+#include "keys_down.h"
+
+static uint8_t count = 0;
+
+void keys_down_event(keyrecord_t* record) {
+  if (!IS_KEYEVENT(record->event)) {
+    return;
+  }
+  if (record->event.pressed) {
+    ++count;
+  } else if (count) {
+    // Keys held at power-up are released without a press.
+    --count;
+  }
+}
+
+uint8_t keys_down_count(void) { return count; }
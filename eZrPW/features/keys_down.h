@@ -0,0 +1,31 @@
+/**
+ * @file keys_down.h
+ * @brief Number of keys held, counted once for the modules that wait on it.
+ *
+ * Bypass mode and the idle states switch only once no key is held, and
+ * Achordion's Caps Word streak follows Caps Word only then. They all read
+ * this count. It is taken from the raw key events in
+ * `pre_process_record_user()`, ahead of QMK's tap-hold handling, so it
+ * includes presses that the tapping term or Achordion still hold back.
+ *
+ * Call `keys_down_event()` from `pre_process_record_user()`, for events from
+ * the matrix only, not those position combos replay (see event_queue.h).
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Counts presses and releases. Call from `pre_process_record_user()`. */
+void keys_down_event(keyrecord_t* record);
+
+/** Number of keys held. */
+uint8_t keys_down_count(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,275 @@
+/**
+ * @file latency_trace.c
+ * @brief Key-to-HID-report latency tracer.
+ */
+
+#include "latency_trace.h"
+
+#ifdef LATENCY_TRACE_ENABLE
+#include "cycle_counter.h"
+#include "user_hid.h"
+
+#ifndef LATENCY_TRACE_PENDING
+#define LATENCY_TRACE_PENDING 8
+#endif
+
+// A press waiting for the report that carries its effect.
+typedef struct {
+  keypos_t key;
+  uint8_t cls;
+  // timer_read() at detection, for timing out.
+  uint16_t time;
+  // Cycle counter at detection.
+  uint32_t start;
+} pending_press_t;
+
+// Pending presses, oldest first.
+static pending_press_t pending[LATENCY_TRACE_PENDING];
+static uint8_t num_pending = 0;
+
+typedef struct {
+  uint32_t count;
+  uint32_t max;
+  uint64_t sum;
+  // Presses that timed out or overflowed `pending` without a report.
+  uint32_t dropped;
+  uint16_t buckets[CYCLE_COUNTER_BUCKETS];
+} latency_dist_t;
+
+static latency_dist_t dists[LATENCY_CLASS_COUNT];
+
+// Previous reports, to tell which keys and mods a new one adds.
+static report_keyboard_t last_report;
+#ifdef NKRO_ENABLE
+static report_nkro_t last_nkro_report;
+#endif
+
+void latency_trace_init(void) { cycle_counter_init(); }
+
+void latency_trace_reset(void) {
+  memset(dists, 0, sizeof(dists));
+  num_pending = 0;
+}
+
+static uint8_t classify(uint16_t keycode) {
+  if (IS_QK_MOD_TAP(keycode)) {
+    return LATENCY_MOD_TAP;
+  } else if (IS_QK_LAYER_TAP(keycode)) {
+    return LATENCY_LAYER_TAP;
+#ifdef TAP_DANCE_ENABLE
+  } else if (IS_QK_TAP_DANCE(keycode)) {
+    return LATENCY_TAP_DANCE;
+#endif
+  }
+  return LATENCY_PLAIN;
+}
+
+static void remove_pending(uint8_t i) {
+  --num_pending;
+  memmove(&pending[i], &pending[i + 1],
+          (num_pending - i) * sizeof(pending_press_t));
+}
+
+static void drop_pending(uint8_t i) {
+  ++dists[pending[i].cls].dropped;
+  remove_pending(i);
+}
+
+static void drop_expired(void) {
+  while (num_pending &&
+         timer_elapsed(pending[0].time) >= LATENCY_TRACE_TIMEOUT) {
+    drop_pending(0);
+  }
+}
+
+void latency_trace_event(uint16_t keycode, keyrecord_t* record) {
+  if (!record->event.pressed || !IS_KEYEVENT(record->event)) {
+    return;
+  }
+  drop_expired();
+  if (num_pending == LATENCY_TRACE_PENDING) {
+    drop_pending(0);
+  }
+  pending[num_pending++] = (pending_press_t){
+      .key = record->event.key,
+      .cls = classify(keycode),
+      .time = timer_read(),
+      .start = cycle_counter_read(),
+  };
+}
+
+// Converts 5-bit `MOD_` bits to 8-bit report mods.
+static uint8_t report_mods(uint8_t mods) {
+  return (mods & 0x10) ? (mods & 0x0f) << 4 : mods;
+}
+
+// Returns the basic keycode `keycode` sends, if any, and its mods in `mods`.
+static uint8_t effect_of(uint16_t keycode, uint8_t* mods) {
+  *mods = 0;
+  if (IS_QK_MOD_TAP(keycode)) {
+    *mods = report_mods(QK_MOD_TAP_GET_MODS(keycode));
+    return QK_MOD_TAP_GET_TAP_KEYCODE(keycode);
+  } else if (IS_QK_LAYER_TAP(keycode)) {
+    return QK_LAYER_TAP_GET_TAP_KEYCODE(keycode);
+  } else if (IS_QK_MODS(keycode)) {
+    *mods = report_mods(QK_MODS_GET_MODS(keycode));
+    return QK_MODS_GET_BASIC_KEYCODE(keycode);
+  } else if (IS_MODIFIER_KEYCODE(keycode)) {
+    *mods = MOD_BIT(keycode);
+    return KC_NO;
+  } else if (IS_BASIC_KEYCODE(keycode)) {
+    return keycode;
+  }
+  return KC_NO;
+}
+
+// Whether the key at `key` sends `code` or any of `mods` on some layer. Keys
+// pressed while a layer-tap key is unsettled resolve on a layer that was not
+// yet active at detection, so every layer is considered.
+static bool key_produces(keypos_t key, uint8_t code, uint8_t mods) {
+  for (uint8_t layer = 0; layer < keymap_layer_count(); ++layer) {
+    uint8_t key_mods;
+    const uint8_t key_code =
+        effect_of(keymap_key_to_keycode(layer, key), &key_mods);
+    if ((code != KC_NO && key_code == code) || (key_mods & mods)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void record_latency(uint8_t cls, uint32_t cycles) {
+  latency_dist_t* d = &dists[cls];
+  ++d->count;
+  d->sum += cycles;
+  if (cycles > d->max) {
+    d->max = cycles;
+  }
+  uint16_t* bucket = &d->buckets[cycle_counter_bucket(cycles)];
+  if (*bucket == UINT16_MAX) {
+    // Halve the histogram rather than saturate it, which keeps its shape.
+    for (uint8_t i = 0; i < CYCLE_COUNTER_BUCKETS; ++i) {
+      d->buckets[i] >>= 1;
+    }
+  }
+  ++*bucket;
+}
+
+// Attributes a newly added key `code` or `mods` to the oldest pending press
+// that produces it, falling back to the oldest tap dance press for keys.
+static void attribute(uint32_t now, uint8_t code, uint8_t mods) {
+  int8_t match = -1;
+  for (uint8_t i = 0; i < num_pending && match < 0; ++i) {
+    if (key_produces(pending[i].key, code, mods)) {
+      match = i;
+    }
+  }
+  for (uint8_t i = 0; i < num_pending && match < 0 && code != KC_NO; ++i) {
+    if (pending[i].cls == LATENCY_TAP_DANCE) {
+      match = i;
+    }
+  }
+  if (match >= 0) {
+    record_latency(pending[match].cls, now - pending[match].start);
+    remove_pending(match);
+  }
+}
+
+static bool has_key(const report_keyboard_t* report, uint8_t code) {
+  for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; ++i) {
+    if (report->keys[i] == code) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void __real_host_keyboard_send(report_keyboard_t* report);
+
+// Linked in place of `host_keyboard_send()` by `--wrap`, see custom.mk.
+void __wrap_host_keyboard_send(report_keyboard_t* report) {
+  const uint32_t now = cycle_counter_read();
+  drop_expired();
+  for (uint8_t i = 0; i < KEYBOARD_REPORT_KEYS; ++i) {
+    const uint8_t code = report->keys[i];
+    if (code != KC_NO && !has_key(&last_report, code)) {
+      attribute(now, code, 0);
+    }
+  }
+  const uint8_t added_mods = report->mods & ~last_report.mods;
+  if (added_mods) {
+    attribute(now, KC_NO, added_mods);
+  }
+  last_report = *report;
+  __real_host_keyboard_send(report);
+}
+
+#ifdef NKRO_ENABLE
+void __real_host_nkro_send(report_nkro_t* report);
+
+// Linked in place of `host_nkro_send()` by `--wrap`, see custom.mk.
+void __wrap_host_nkro_send(report_nkro_t* report) {
+  const uint32_t now = cycle_counter_read();
+  drop_expired();
+  for (uint8_t i = 0; i < NKRO_REPORT_BITS; ++i) {
+    const uint8_t added = report->bits[i] & ~last_nkro_report.bits[i];
+    for (uint8_t bit = 0; bit < 8; ++bit) {
+      if (added & (1 << bit)) {
+        attribute(now, i * 8 + bit, 0);
+      }
+    }
+  }
+  const uint8_t added_mods = report->mods & ~last_nkro_report.mods;
+  if (added_mods) {
+    attribute(now, KC_NO, added_mods);
+  }
+  last_nkro_report = *report;
+  __real_host_nkro_send(report);
+}
+#endif  // NKRO_ENABLE
+
+bool process_latency_trace_hid(uint8_t* data, uint8_t length) {
+  if (data[0] != USER_HID_LATENCY) {
+    return true;
+  }
+
+  const uint8_t cls = data[2];
+  if (data[1] <= 0x01 && cls >= LATENCY_CLASS_COUNT) {
+    user_hid_reply(data, length, USER_HID_ERROR);
+    return false;
+  }
+
+  switch (data[1]) {
+    case 0x00: {  // Summary of one class.
+      const latency_dist_t* d = &dists[cls];
+      data[3] = LATENCY_CLASS_COUNT;
+      user_hid_put32(data + 4, d->count);
+      user_hid_put32(data + 8, d->count ? (uint32_t)(d->sum / d->count) : 0);
+      user_hid_put32(data + 12, d->max);
+      user_hid_put32(data + 16, d->dropped);
+      user_hid_reply(data, length, USER_HID_OK);
+    } break;
+
+    case 0x01: {  // Histogram buckets of one class from data[3].
+      const uint8_t first = data[3];
+      if (first >= CYCLE_COUNTER_BUCKETS) {
+        user_hid_reply(data, length, USER_HID_ERROR);
+        break;
+      }
+      for (uint8_t i = 0; i < 14 && first + i < CYCLE_COUNTER_BUCKETS; ++i) {
+        user_hid_put16(data + 4 + 2 * i, dists[cls].buckets[first + i]);
+      }
+      user_hid_reply(data, length, USER_HID_OK);
+    } break;
+
+    case 0x02:  // Reset.
+      latency_trace_reset();
+      user_hid_reply(data, length, USER_HID_OK);
+      break;
+
+    default:
+      user_hid_reply(data, length, USER_HID_ERROR);
+  }
+  return false;
+}
+#endif  // LATENCY_TRACE_ENABLE
@@ -0,0 +1,77 @@
+/**
+ * @file latency_trace.h
+ * @brief Key-to-HID-report latency tracer.
+ *
+ * Each key press is stamped with the cycle counter (see cycle_counter.h) when
+ * QMK first sees it in `pre_process_record_user()`, which runs after debouncing
+ * and before tap-hold buffering. It is stamped again when the first keyboard
+ * report carrying its effect is handed to the host driver. The difference is
+ * added to a log2 histogram for the key's class: plain, mod-tap, layer-tap or
+ * tap dance. Time a key spends held back by QMK's tapping logic, Achordion's
+ * unsettled state or tap dance resolution is all included.
+ *
+ * Reports are intercepted by linking with `-Wl,--wrap=host_keyboard_send` and
+ * `-Wl,--wrap=host_nkro_send`, which custom.mk adds when the tracer is enabled.
+ * A report is attributed to the oldest pending press whose key, on any layer,
+ * produces one of the keys or mods the report newly adds. Tap dance effects
+ * cannot be predicted from the keymap, so a report nobody claims goes to the
+ * oldest pending tap dance press. Presses that never produce a report, like a
+ * held layer key, are dropped after LATENCY_TRACE_TIMEOUT ms.
+ *
+ * Enable in custom.mk with
+ *
+ *     LATENCY_TRACE_ENABLE = yes
+ *
+ * and read the distributions with `scripts/user_hid.py latency`.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Key classes. Keep in sync with LATENCY_CLASSES in scripts/user_hid.py. */
+enum latency_class {
+  LATENCY_PLAIN,
+  LATENCY_MOD_TAP,
+  LATENCY_LAYER_TAP,
+  LATENCY_TAP_DANCE,
+  LATENCY_CLASS_COUNT,
+};
+
+#ifndef LATENCY_TRACE_TIMEOUT
+#define LATENCY_TRACE_TIMEOUT 2000
+#endif
+
+#ifdef LATENCY_TRACE_ENABLE
+/** Starts the cycle counter. Call from `keyboard_post_init_user()`. */
+void latency_trace_init(void);
+
+/** Stamps a key event. Call from `pre_process_record_user()`. */
+void latency_trace_event(uint16_t keycode, keyrecord_t* record);
+
+/** Clears all distributions. */
+void latency_trace_reset(void);
+
+/**
+ * Raw HID handler for `USER_HID_LATENCY`, see user_hid.h.
+ *
+ * Subcommand 0x00 reads the class in byte 2, replying with the class, the
+ * class count, then the sample count, mean, max and number of dropped presses.
+ * Subcommand 0x01 reads up to 14 histogram buckets of the class in byte 2
+ * starting at the index in byte 3; the buckets are halved whenever one would
+ * overflow, so they give proportions rather than counts. Subcommand 0x02
+ * resets.
+ */
+bool process_latency_trace_hid(uint8_t* data, uint8_t length);
+#else
+static inline void latency_trace_init(void) {}
+static inline void latency_trace_event(uint16_t keycode, keyrecord_t* record) {}
+#endif  // LATENCY_TRACE_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,176 @@
+/**
+ * @file layer_lighting.c
+ * @brief Layer indicator colors, converted a few LEDs per frame.
+ */
+
+#include "layer_lighting.h"
+
+#include "cycle_counter.h"
+#include "heatmap.h"
+#include "oryx_tables.h"
+
+extern rgb_config_t rgb_matrix_config;
+
+static RGB cache[RGB_MATRIX_LED_COUNT];
+// Layer and brightness the cache is being built for, and the LEDs done.
+static uint8_t cache_layer = UINT8_MAX;
+static uint8_t cache_value = 0;
+static uint8_t converted = 0;
+// Palette colors converted at the brightness in `palette_value`. All black is
+// right for brightness 0.
+static RGB palette[LEDMAP_PALETTE_SIZE];
+static uint8_t palette_value[LEDMAP_PALETTE_SIZE];
+// The next LED to refresh once the heatmap's cache is built.
+static uint8_t refreshed = 0;
+
+#ifdef HEATMAP_ENABLE
+#define IS_HEATMAP(layer) ((layer) == LAYER_LIGHTING_HEATMAP)
+#else
+#define IS_HEATMAP(layer) false
+#endif
+// Transition to the cache's colors: the colors shown when it started, and
+// its progress in 8.8 fixed point, 0x100 when done. `from_layer` is false if
+// it started from the effect, whose colors are taken as black.
+static RGB from[RGB_MATRIX_LED_COUNT];
+static uint16_t progress = 0x100;
+static bool from_layer = false;
+// Whether the last frame showed layer colors.
+static bool shown = false;
+// Layer of the layer-tap key pressed last, 0 for none, the key and the time
+// of the press.
+static uint8_t preview_layer = 0;
+static keypos_t preview_key;
+static uint16_t preview_time;
+
+static RGB led_color(uint8_t layer, uint8_t led) {
+#ifdef HEATMAP_ENABLE
+  if (IS_HEATMAP(layer)) {
+    return heatmap_color(led);
+  }
+#endif
+  // Palette entry 0 is black.
+  const uint8_t color = pgm_read_byte(&ledmap_colors[layer][led]);
+  if (color && palette_value[color] != cache_value) {
+    const HSV hsv = {
+        .h = pgm_read_byte(&ledmap_palette[color][0]),
+        .s = pgm_read_byte(&ledmap_palette[color][1]),
+        .v = pgm_read_byte(&ledmap_palette[color][2]),
+    };
+    const RGB rgb = hsv_to_rgb(hsv);
+    const uint16_t scale = cache_value + 1;
+    palette[color] = (RGB){(rgb.r * scale) >> 8, (rgb.g * scale) >> 8,
+                           (rgb.b * scale) >> 8};
+    palette_value[color] = cache_value;
+  }
+  return palette[color];
+}
+
+// `a` moved towards `b` by `t`, in 8.8 fixed point.
+static inline uint8_t blend(uint8_t a, uint8_t b, uint16_t t) {
+  return a + (((int16_t)b - a) * (int32_t)t >> 8);
+}
+
+static RGB blend_rgb(RGB a, RGB b, uint16_t t) {
+  return (RGB){blend(a.r, b.r, t), blend(a.g, b.g, t), blend(a.b, b.b, t)};
+}
+
+// Starts a transition from the colors shown.
+static void start_transition(void) {
+  if (shown) {
+    for (uint8_t i = 0; i < converted; ++i) {
+      from[i] = blend_rgb(from[i], cache[i], progress);
+    }
+  } else {
+    memset(from, 0, sizeof(from));
+  }
+  from_layer = shown;
+  progress = 0;
+}
+
+void layer_lighting_init(void) { cycle_counter_init(); }
+
+void layer_lighting_event(uint16_t keycode, keyrecord_t* record) {
+  if (!IS_KEYEVENT(record->event)) {
+    return;
+  }
+  if (record->event.pressed) {
+    // Any other press settles the key: its layer comes on, or it was a tap.
+    preview_layer = IS_QK_LAYER_TAP(keycode) ? QK_LAYER_TAP_GET_LAYER(keycode)
+                                             : 0;
+    preview_key = record->event.key;
+    preview_time = record->event.time;
+  } else if (KEYEQ(record->event.key, preview_key)) {
+    preview_layer = 0;
+  }
+}
+
+uint8_t layer_lighting_layer(uint8_t layer) {
+  if (preview_layer &&
+      timer_expired(timer_read(),
+                    preview_time + LAYER_LIGHTING_PREVIEW_DELAY_MS)) {
+    return preview_layer;
+  }
+  return layer;
+}
+
+void layer_lighting_show(uint8_t layer) {
+  const bool new_cache =
+      layer != cache_layer || rgb_matrix_config.hsv.v != cache_value;
+  if (new_cache || !shown) {
+    start_transition();
+  }
+  if (new_cache) {
+    cache_layer = layer;
+    cache_value = rgb_matrix_config.hsv.v;
+    converted = 0;
+  }
+  shown = true;
+
+  if (converted < RGB_MATRIX_LED_COUNT) {
+    const uint32_t start =
+        LAYER_LIGHTING_BUDGET_CYCLES ? cycle_counter_read() : 0;
+    uint8_t end = converted + LAYER_LIGHTING_CHUNK_LEDS;
+    if (end > RGB_MATRIX_LED_COUNT) {
+      end = RGB_MATRIX_LED_COUNT;
+    }
+    do {
+      cache[converted] = led_color(layer, converted);
+      ++converted;
+    } while (converted < end &&
+             (!LAYER_LIGHTING_BUDGET_CYCLES ||
+              cycle_counter_read() - start < LAYER_LIGHTING_BUDGET_CYCLES));
+  } else if (IS_HEATMAP(layer)) {
+    // The counters keep changing, so the cache is refreshed a chunk a frame.
+    for (uint8_t i = 0; i < LAYER_LIGHTING_CHUNK_LEDS; ++i) {
+      cache[refreshed] = led_color(layer, refreshed);
+      refreshed = (refreshed + 1) % RGB_MATRIX_LED_COUNT;
+    }
+  }
+
+  if (progress == 0x100) {
+    for (uint8_t i = 0; i < converted; ++i) {
+      rgb_matrix_set_color(i, cache[i].r, cache[i].g, cache[i].b);
+    }
+    return;
+  }
+
+  // A preview fades in at its own pace until its layer comes on.
+  progress += layer == preview_layer && !layer_state_is(layer)
+                  ? LAYER_LIGHTING_PREVIEW_STEP
+                  : LAYER_LIGHTING_FADE_STEP;
+  if (progress > 0x100) {
+    progress = 0x100;
+  }
+  for (uint8_t i = 0; i < converted; ++i) {
+    const RGB rgb = blend_rgb(from[i], cache[i], progress);
+    rgb_matrix_set_color(i, rgb.r, rgb.g, rgb.b);
+  }
+  // LEDs not converted yet keep what they showed.
+  if (from_layer) {
+    for (uint8_t i = converted; i < RGB_MATRIX_LED_COUNT; ++i) {
+      rgb_matrix_set_color(i, from[i].r, from[i].g, from[i].b);
+    }
+  }
+}
+
+void layer_lighting_hide(void) { shown = false; }
@@ -0,0 +1,108 @@
+/**
+ * @file layer_lighting.h
+ * @brief Layer indicator colors, converted a few LEDs per frame.
+ *
+ * The Oryx export's ledmap, compiled by scripts/oryx_codegen.py into a
+ * palette of HSV colors and a palette index per LED and layer
+ * (oryx_tables.h), gives each layer's LED colors, scaled by the RGB Matrix
+ * brightness. Converting all 52 LEDs in the one `rgb_matrix_indicators_user()`
+ * call made every frame with layer 1 or 2 on a long scan. This module keeps
+ * the converted colors of the layer shown in a cache, so a frame only copies
+ * them out, and converts each palette color once per brightness, by the first
+ * LED using it. It rebuilds the cache when the layer or brightness changes,
+ * LAYER_LIGHTING_CHUNK_LEDS LEDs per frame at most and fewer if a frame's
+ * conversions take LAYER_LIGHTING_BUDGET_CYCLES (in cycle counter units, see
+ * cycle_counter.h). Until an LED is converted, it keeps what it showed, so a
+ * new layer fills in over a few frames.
+ *
+ * A change of layer or brightness fades from the colors shown to the new
+ * ones. The start colors are taken once, at the change, and each frame
+ * blends each channel of the LEDs converted so far in 8.8 fixed point, one
+ * multiply and add, by LAYER_LIGHTING_FADE_STEP / 256 more than the last,
+ * with no HSV or float math. Colors fade in from black when the layer
+ * before showed the effect, whose colors can't be read back, and a return
+ * to the effect is immediate.
+ *
+ * While a layer-tap key is pressed and its layer not yet on, the layer's
+ * colors are previewed, fading in by LAYER_LIGHTING_PREVIEW_STEP / 256 per
+ * frame from the first frame after the press, as QMK and Achordion only turn
+ * the layer on once the key settles as held. The preview ends at the key's
+ * release or the next press, which settle the key. A tap is over within a few
+ * frames, while the preview is still faint, and its return to the effect is
+ * immediate. The preview uses the same cache, so the colors are ready if the
+ * layer does come on.
+ *
+ * Compare the scan interval histograms of `scripts/user_hid.py scanrate`
+ * with a layer held to see the effect of the settings.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Most LEDs converted per frame. */
+#ifndef LAYER_LIGHTING_CHUNK_LEDS
+#define LAYER_LIGHTING_CHUNK_LEDS 13
+#endif
+
+/**
+ * Cycles a frame may spend converting before it stops, checked after each
+ * LED; 0 for no limit. At least one LED is converted per frame.
+ */
+#ifndef LAYER_LIGHTING_BUDGET_CYCLES
+#define LAYER_LIGHTING_BUDGET_CYCLES 7200
+#endif
+
+/** Progress of a layer change's fade per frame, out of 256. */
+#ifndef LAYER_LIGHTING_FADE_STEP
+#define LAYER_LIGHTING_FADE_STEP 48
+#endif
+
+/**
+ * Time a layer-tap key is held before its layer is previewed, in ms. Raising
+ * it towards the tapping term keeps taps from showing any preview, at the
+ * cost of showing holds that much later.
+ */
+#ifndef LAYER_LIGHTING_PREVIEW_DELAY_MS
+#define LAYER_LIGHTING_PREVIEW_DELAY_MS 0
+#endif
+
+/** Progress of a preview's fade per frame, out of 256. */
+#ifndef LAYER_LIGHTING_PREVIEW_STEP
+#define LAYER_LIGHTING_PREVIEW_STEP 32
+#endif
+
+/** Pseudo-layer showing the typing heatmap, see heatmap.h. */
+#define LAYER_LIGHTING_HEATMAP (UINT8_MAX - 1)
+
+/** Starts the cycle counter. Call from `keyboard_post_init_user()`. */
+void layer_lighting_init(void);
+
+/**
+ * Starts and ends previews of layer-tap keys' layers. Call from
+ * `pre_process_record_user()`.
+ */
+void layer_lighting_event(uint16_t keycode, keyrecord_t* record);
+
+/** The layer to show: the one previewed, if any, or `layer`. */
+uint8_t layer_lighting_layer(uint8_t layer);
+
+/**
+ * Sets the LEDs to `layer`'s colors in `ledmap_colors`, as far as converted and
+ * faded in. Call from `rgb_matrix_indicators_user()`.
+ */
+void layer_lighting_show(uint8_t layer);
+
+/**
+ * Leaves the LEDs to the effect, so the next layer shown fades in from black.
+ * Call from `rgb_matrix_indicators_user()` on frames without layer colors.
+ */
+void layer_lighting_hide(void);
+
+#ifdef __cplusplus
+}
+#endif
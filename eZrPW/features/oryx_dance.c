@@ -0,0 +1,83 @@
+/**
+ * @file oryx_dance.c
+ * @brief Oryx's tap dances, run from a table instead of per-dance code.
+ */
+
+#include "oryx_dance.h"
+
+#include "oryx_tables.h"
+#include "profiler.h"
+
+#ifdef ORYX_DANCES
+static uint8_t steps[ORYX_DANCES];
+
+static uint16_t step_keycode(uint8_t dance, uint8_t step) {
+  if (step < SINGLE_TAP || step > DOUBLE_SINGLE_TAP) {
+    return KC_NO;
+  }
+  return pgm_read_word(&oryx_dances[dance].steps[step - 1]);
+}
+
+uint8_t oryx_dance_step(tap_dance_state_t* state) {
+  if (state->count == 1) {
+    if (state->interrupted || !state->pressed) return SINGLE_TAP;
+    else return SINGLE_HOLD;
+  } else if (state->count == 2) {
+    if (state->interrupted) return DOUBLE_SINGLE_TAP;
+    else if (state->pressed) return DOUBLE_HOLD;
+    else return DOUBLE_TAP;
+  }
+  return MORE_TAPS;
+}
+
+void oryx_dance_each(tap_dance_state_t* state, void* user_data) {
+  PROFILE_SCOPE(PROFILE_DANCE_EACH);
+  const uint16_t keycode =
+      pgm_read_word(&oryx_dances[(uintptr_t)user_data].multi_tap);
+  if (keycode == KC_NO) {
+    return;
+  }
+  if (state->count == 3) {
+    tap_code16(keycode);
+    tap_code16(keycode);
+    tap_code16(keycode);
+  }
+  if (state->count > 3) {
+    tap_code16(keycode);
+  }
+}
+
+void oryx_dance_finished(tap_dance_state_t* state, void* user_data) {
+  PROFILE_SCOPE(PROFILE_DANCE_FINISHED);
+  const uint8_t dance = (uintptr_t)user_data;
+  const uint8_t step = oryx_dance_step(state);
+  const uint16_t keycode = step_keycode(dance, step);
+  steps[dance] = step;
+  if (keycode == KC_NO) {
+    return;
+  }
+  switch (step) {
+    case DOUBLE_TAP:
+      register_code16(keycode);
+      register_code16(keycode);
+      break;
+    case DOUBLE_SINGLE_TAP:
+      tap_code16(keycode);
+      register_code16(keycode);
+      break;
+    default:
+      register_code16(keycode);
+  }
+}
+
+void oryx_dance_reset(tap_dance_state_t* state, void* user_data) {
+  PROFILE_SCOPE(PROFILE_DANCE_RESET);
+  const uint8_t dance = (uintptr_t)user_data;
+  wait_ms(10);
+  const uint16_t keycode = step_keycode(dance, steps[dance]);
+  if (keycode != KC_NO) {
+    unregister_code16(keycode);
+  }
+  steps[dance] = 0;
+}
+#endif  // ORYX_DANCES
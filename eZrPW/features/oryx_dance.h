@@ -0,0 +1,67 @@
+/**
+ * @file oryx_dance.h
+ * @brief Oryx's tap dances, run from a table instead of per-dance code.
+ *
+ * Oryx exports three functions per tap dance, identical up to the keycodes,
+ * plus a copy of `dance_step()`. scripts/oryx_codegen.py reads those
+ * keycodes into the `oryx_dances` table of the generated oryx_tables.c and
+ * points every dance's `tap_dance_actions[]` entry at the three callbacks
+ * here, which do what Oryx's code does: register the keycode of the step the
+ * dance ended on (a single tap, a single hold, a double tap, a double hold or
+ * a tap then a tap) and, for dances with "tap multiple", tap the keycode on
+ * every tap from the third on.
+ *
+ * The generator only takes dances it can express this way. If an export has
+ * others, such as a hold that switches layers, it leaves all of Oryx's dance
+ * code in keymap.c and generates no table.
+ *
+ * Enable in custom.mk with
+ *
+ *     SRC += features/oryx_dance.c
+ *
+ * next to oryx_tables.c.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Results of `oryx_dance_step()`, as Oryx numbers them. */
+enum oryx_dance_step {
+  SINGLE_TAP = 1,
+  SINGLE_HOLD,
+  DOUBLE_TAP,
+  DOUBLE_HOLD,
+  DOUBLE_SINGLE_TAP,
+  MORE_TAPS
+};
+
+typedef struct {
+  /** Keycode per step, indexed by `enum oryx_dance_step` - 1, or KC_NO. */
+  uint16_t steps[DOUBLE_SINGLE_TAP];
+  /** Keycode tapped from the third tap on, or KC_NO. */
+  uint16_t multi_tap;
+} oryx_dance_t;
+
+/** `tap_dance_actions[]` entry of dance `index` of `oryx_dances`. */
+#define ORYX_DANCE(index)                                            \
+  {                                                                  \
+    .fn = {oryx_dance_each, oryx_dance_finished, oryx_dance_reset,   \
+           NULL},                                                    \
+    .user_data = (void*)(uintptr_t)(index)                           \
+  }
+
+/** The step a dance ended on, from its tap count and interruption. */
+uint8_t oryx_dance_step(tap_dance_state_t* state);
+
+void oryx_dance_each(tap_dance_state_t* state, void* user_data);
+void oryx_dance_finished(tap_dance_state_t* state, void* user_data);
+void oryx_dance_reset(tap_dance_state_t* state, void* user_data);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,269 @@
+/**
+ * @file position_combos.c
+ * @brief Combos matched on key positions, ahead of the tap-hold keys.
+ */
+
+#include "position_combos.h"
+
+#ifdef POSITION_COMBOS_ENABLE
+#include "event_queue.h"
+
+_Static_assert(EVENT_QUEUE_SIZE >=
+                   POSITION_COMBOS_MAX_KEYS + EVENT_QUEUE_ACHORDION_EVENTS,
+               "EVENT_QUEUE_SIZE too small for the held back presses");
+_Static_assert(POSITION_COMBOS_LEFT_ROW < MATRIX_ROWS / 2 &&
+                   POSITION_COMBOS_RIGHT_ROW >= MATRIX_ROWS / 2 &&
+                   POSITION_COMBOS_RIGHT_ROW < MATRIX_ROWS,
+               "Combo rows must be in the matrix, one on each hand");
+
+// Layout position of each matrix key plus 1, or 0 where there is no key.
+// clang-format off
+static const uint8_t PROGMEM layout_positions[MATRIX_ROWS][MATRIX_COLS] =
+    LAYOUT_voyager(
+         1,  2,  3,  4,  5,  6,      7,  8,  9, 10, 11, 12,
+        13, 14, 15, 16, 17, 18,     19, 20, 21, 22, 23, 24,
+        25, 26, 27, 28, 29, 30,     31, 32, 33, 34, 35, 36,
+        37, 38, 39, 40, 41, 42,     43, 44, 45, 46, 47, 48,
+                        49, 50,     51, 52);
+// clang-format on
+
+// Whether position_combos_init() found the combo rows free of keys.
+static bool rows_free = false;
+// Presses held back, in order, and their keys.
+static keyrecord_t held[POSITION_COMBOS_MAX_KEYS];
+static uint8_t num_held = 0;
+static uint64_t held_keys = 0;
+// Layer active when the first of them went down, the layer of their combos.
+static uint8_t held_layer = 0;
+// Layer-tap keys down and their layers. Tap-hold handling may not have
+// turned their layers on yet, but the keys pressed while they are down will
+// be on them once it settles them as holds.
+static struct {
+  uint64_t key;
+  uint8_t layer;
+} layer_taps[POSITION_COMBOS_LAYER_TAPS];
+// Keys of the fired combos not released yet, and the position the last combo
+// pressed while it is down.
+static uint64_t fired_keys = 0;
+static bool fired_down = false;
+static keypos_t fired_at;
+// Keycode each combo position reads as, left hand first.
+static uint16_t fired_keycodes[2][MATRIX_COLS];
+
+static uint64_t key_bit(keypos_t key) {
+  if (key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+    return 0;
+  }
+  const uint8_t position = pgm_read_byte(&layout_positions[key.row][key.col]);
+  return position ? POSITION_COMBO_KEY(position - 1) : 0;
+}
+
+static uint64_t combo_keys(uint8_t combo) {
+  uint64_t keys;
+  memcpy_P(&keys, &position_combos[combo].keys, sizeof(keys));
+  return keys;
+}
+
+static uint8_t active_layer(void) {
+  layer_state_t state = layer_state | default_layer_state;
+  for (uint8_t i = 0; i < POSITION_COMBOS_LAYER_TAPS; ++i) {
+    if (layer_taps[i].key) {
+      state |= (layer_state_t)1 << layer_taps[i].layer;
+    }
+  }
+  return get_highest_layer(state);
+}
+
+// Replaces the layer-tap entry of `key`, or a free one for a key of 0, with
+// `new_key` on `layer`. More layer-tap keys down at once are not tracked.
+static void set_layer_tap(uint64_t key, uint64_t new_key, uint8_t layer) {
+  for (uint8_t i = 0; i < POSITION_COMBOS_LAYER_TAPS; ++i) {
+    if (layer_taps[i].key == key) {
+      layer_taps[i].key = new_key;
+      layer_taps[i].layer = layer;
+      return;
+    }
+  }
+}
+
+// Looks up the combos of `layer` with all of `keys`. Returns the index of the
+// one with exactly those keys, or -1, and sets `*larger` if some have more.
+static int16_t find(uint64_t keys, uint8_t layer, bool* larger) {
+  // A combo with all of `keys` has a mask at least as high, so the search
+  // starts from the first such mask.
+  uint8_t lo = 0;
+  uint8_t hi = position_combos_count;
+  while (lo < hi) {
+    const uint8_t mid = (lo + hi) / 2;
+    if (combo_keys(mid) < keys) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  int16_t exact = -1;
+  *larger = false;
+  for (uint8_t i = lo; i < position_combos_count; ++i) {
+    if (pgm_read_byte(&position_combos[i].layer) != layer) {
+      continue;
+    }
+    const uint64_t combo = combo_keys(i);
+    if (combo == keys) {
+      exact = i;
+    } else if ((combo & keys) == keys) {
+      *larger = true;
+      break;
+    }
+  }
+  return exact;
+}
+
+// Processes `record` from the top of the pipeline, in order with the events
+// Achordion plumbs.
+static void replay(const keyrecord_t* record) {
+  event_queue_push_raw(record);
+  event_queue_drain();
+}
+
+static void press_fired(bool pressed, uint16_t time) {
+  const keyrecord_t record = {
+      .event = {.key = fired_at,
+                .time = time,
+                .type = KEY_EVENT,
+                .pressed = pressed},
+  };
+  fired_down = pressed;
+  replay(&record);
+}
+
+// Ends the held back set: fires the combo of exactly its keys, if any, or
+// replays its presses otherwise.
+static void settle(uint16_t time) {
+  if (!num_held) {
+    return;
+  }
+  bool larger;
+  const int16_t combo = find(held_keys, held_layer, &larger);
+  if (combo >= 0) {
+    const bool right = held[0].event.key.row >= MATRIX_ROWS / 2;
+    fired_at = (keypos_t){
+        .row = right ? POSITION_COMBOS_RIGHT_ROW : POSITION_COMBOS_LEFT_ROW,
+        .col = combo % MATRIX_COLS,
+    };
+    fired_keycodes[right][fired_at.col] =
+        pgm_read_word(&position_combos[combo].keycode);
+    fired_keys |= held_keys;
+    num_held = 0;
+    held_keys = 0;
+    press_fired(true, time);
+    return;
+  }
+
+  // Replaying may call back here, so the set is emptied first.
+  keyrecord_t presses[POSITION_COMBOS_MAX_KEYS];
+  const uint8_t count = num_held;
+  memcpy(presses, held, count * sizeof(keyrecord_t));
+  num_held = 0;
+  held_keys = 0;
+  for (uint8_t i = 0; i < count; ++i) {
+    replay(&presses[i]);
+  }
+}
+
+// Event times are odd, so the timer can read one less than the latest one.
+static bool term_expired(uint16_t time) {
+  return timer_expired(time, held[0].event.time + POSITION_COMBOS_TERM);
+}
+
+// Holds back `record` if its key and the held ones are in a combo together,
+// and fires the combo this completes when no larger one is possible.
+static bool hold(keyrecord_t* record, uint64_t bit) {
+  if (!bit || fired_down || num_held == POSITION_COMBOS_MAX_KEYS) {
+    return false;
+  }
+  const uint8_t layer = num_held ? held_layer : active_layer();
+  bool larger;
+  const int16_t combo = find(held_keys | bit, layer, &larger);
+  if (combo < 0 && !larger) {
+    return false;
+  }
+  held_layer = layer;
+  held[num_held++] = *record;
+  held_keys |= bit;
+  if (!larger) {
+    settle(record->event.time);
+  }
+  return true;
+}
+
+void position_combos_init(void) {
+  rows_free = true;
+  for (uint8_t col = 0; col < MATRIX_COLS; ++col) {
+    if (pgm_read_byte(&layout_positions[POSITION_COMBOS_LEFT_ROW][col]) ||
+        pgm_read_byte(&layout_positions[POSITION_COMBOS_RIGHT_ROW][col])) {
+      dprintln("position_combos: Combo rows have keys, combos off.");
+      rows_free = false;
+    }
+  }
+}
+
+bool process_position_combos(uint16_t keycode, keyrecord_t* record) {
+  if (!rows_free || !IS_KEYEVENT(record->event) ||
+      event_queue_is_replaying()) {
+    return true;
+  }
+  const uint64_t bit = key_bit(record->event.key);
+  const uint16_t time = record->event.time;
+  if (num_held && term_expired(time)) {
+    settle(time);
+  }
+
+  if (record->event.pressed) {
+    bool pass = !hold(record, bit);
+    if (pass && num_held) {
+      // The held keys and this one are in no combo together: settle the held
+      // ones, then start over from this one.
+      settle(time);
+      pass = !hold(record, bit);
+    }
+    // Only now, so that this press itself was looked up on the layer below.
+    if (IS_QK_LAYER_TAP(keycode) && bit) {
+      set_layer_tap(0, bit, QK_LAYER_TAP_GET_LAYER(keycode));
+    }
+    return pass;
+  }
+  if (bit) {
+    set_layer_tap(bit, 0, 0);
+  }
+
+  // Releases settle the held keys first, so tap-hold keys see the presses
+  // before the releases that follow them.
+  settle(time);
+  if (fired_keys & bit) {
+    fired_keys &= ~bit;
+    if (fired_down) {
+      press_fired(false, time);
+    }
+    return false;
+  }
+  return true;
+}
+
+void position_combos_task(void) {
+  const uint16_t time = timer_read() | 1;
+  if (num_held && term_expired(time)) {
+    settle(time);
+  }
+}
+
+uint16_t position_combos_keycode(keypos_t key) {
+  if (key.col >= MATRIX_COLS) {
+    return KC_NO;
+  } else if (key.row == POSITION_COMBOS_LEFT_ROW) {
+    return fired_keycodes[0][key.col];
+  } else if (key.row == POSITION_COMBOS_RIGHT_ROW) {
+    return fired_keycodes[1][key.col];
+  }
+  return KC_NO;
+}
+#endif  // POSITION_COMBOS_ENABLE
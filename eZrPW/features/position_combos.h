@@ -0,0 +1,136 @@
+/**
+ * @file position_combos.h
+ * @brief Combos matched on key positions, ahead of the tap-hold keys.
+ *
+ * QMK's Combos hold back every key of every combo for COMBO_TERM and handle
+ * events before the point Achordion sees them (see achordion.h). This engine
+ * is made for this keymap instead. It watches raw key events in
+ * `pre_process_record_user()`, before QMK's tap-hold handling, and keeps the
+ * keys currently pressed as a bitmask of layout positions, the argument
+ * order of LAYOUT_voyager(). The keymap's combo table, sorted by mask, is
+ * searched for combos containing that set on the layer that was active when
+ * the first of the keys went down, the highest of `layer_state` and
+ * `default_layer_state`. Layer-tap keys already down count as held, since
+ * their layers come on only once the tap-hold handling settles them, after
+ * it saw the next press. On every other layer, a combo's keys type their own
+ * keycodes:
+ *
+ *  * A press of a key in no combo goes through at once, after any presses
+ *    held back before it.
+ *  * A press that completes a combo with no larger combo still possible
+ *    fires the combo at once, without waiting out the term.
+ *  * Otherwise the press is held back until the set can no longer grow: a
+ *    key outside the candidates is pressed, any key is released or
+ *    POSITION_COMBOS_TERM ms pass. The combo matching the set exactly, if
+ *    any, then fires, and the held back presses replay otherwise.
+ *
+ * Held back events replay through the pipeline from the top, tap-hold
+ * handling included, through Achordion's event queue (event_queue.h), so
+ * they keep their order with the events Achordion plumbs. A combo fires as a
+ * press of a matrix position no physical key uses, on the hand of its first
+ * key, which reads as the combo's keycode (see `position_combos_keycode()`).
+ * QMK and Achordion treat it as any other key, and it is released with the
+ * first of the combo's keys. Combo n takes column n % MATRIX_COLS of
+ * POSITION_COMBOS_LEFT_ROW or POSITION_COMBOS_RIGHT_ROW, so combos
+ * MATRIX_COLS apart on one hand share a position and must not be held
+ * together.
+ *
+ * Enable in custom.mk with
+ *
+ *     POSITION_COMBOS_ENABLE = yes
+ *
+ * define `position_combos[]` and `position_combos_count` in the keymap, call
+ * `position_combos_init()` from `keyboard_post_init_user()`,
+ * `process_position_combos()` from `pre_process_record_user()` and
+ * `position_combos_task()` from `housekeeping_task_user()`, and have
+ * `keymap_key_to_keycode()` ask `position_combos_keycode()` first.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Longest time between the first and last press of a combo, in ms. */
+#ifndef POSITION_COMBOS_TERM
+#define POSITION_COMBOS_TERM 30
+#endif
+
+/** Most keys in one combo. */
+#ifndef POSITION_COMBOS_MAX_KEYS
+#define POSITION_COMBOS_MAX_KEYS 4
+#endif
+
+/** Most layer-tap keys down at once whose layers combos are looked up on. */
+#ifndef POSITION_COMBOS_LAYER_TAPS
+#define POSITION_COMBOS_LAYER_TAPS 4
+#endif
+
+/**
+ * Matrix rows without keys, which fired combos press on each hand. In the
+ * Voyager's matrix, each half has six rows of seven columns, and
+ * LAYOUT_voyager() puts its thumb keys on the fifth row of each half, so the
+ * sixth rows are free. `position_combos_init()` checks this against the
+ * keyboard's LAYOUT_voyager() and leaves combos off if a key is there.
+ */
+#ifndef POSITION_COMBOS_LEFT_ROW
+#define POSITION_COMBOS_LEFT_ROW 5
+#endif
+#ifndef POSITION_COMBOS_RIGHT_ROW
+#define POSITION_COMBOS_RIGHT_ROW 11
+#endif
+
+/** Mask bit of the key at argument `index` of LAYOUT_voyager(), from 0. */
+#define POSITION_COMBO_KEY(index) ((uint64_t)1 << (index))
+
+typedef struct {
+  /** Keys of the combo, as POSITION_COMBO_KEY() bits. */
+  uint64_t keys;
+  /** Keycode the combo sends. */
+  uint16_t keycode;
+  /** Layer the combo is on. */
+  uint8_t layer;
+} position_combo_t;
+
+#ifdef POSITION_COMBOS_ENABLE
+/** The keymap's combos, in ascending order of `keys`. */
+extern const position_combo_t PROGMEM position_combos[];
+extern const uint8_t position_combos_count;
+
+/**
+ * Checks that no key uses the rows combos fire on, and leaves combos off
+ * otherwise. Call from `keyboard_post_init_user()`.
+ */
+void position_combos_init(void);
+
+/**
+ * Holds back, replays and fires events. Call from `pre_process_record_user()`
+ * and return false when this does. Replayed and fired events come through
+ * `pre_process_record_user()` again, while event_queue_is_replaying().
+ */
+bool process_position_combos(uint16_t keycode, keyrecord_t* record);
+
+/** Ends combos whose term ran out. Call from `housekeeping_task_user()`. */
+void position_combos_task(void);
+
+/**
+ * Keycode of the combo last fired at `key`, or KC_NO for a physical key. Call
+ * from `keymap_key_to_keycode()`.
+ */
+uint16_t position_combos_keycode(keypos_t key);
+#else
+static inline void position_combos_init(void) {}
+static inline bool process_position_combos(uint16_t keycode,
+                                           keyrecord_t* record) {
+  return true;
+}
+static inline void position_combos_task(void) {}
+static inline uint16_t position_combos_keycode(keypos_t key) { return KC_NO; }
+#endif  // POSITION_COMBOS_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
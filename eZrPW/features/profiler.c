@@ -0,0 +1,118 @@
+/**
+ * @file profiler.c
+ * @brief Scan-loop cost profiler for user hooks.
+ */
+
+#include "profiler.h"
+
+#ifdef PROFILER_ENABLE
+#include "user_hid.h"
+
+typedef struct {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  // Log2 histogram of samples, used to estimate p99.
+  uint16_t buckets[CYCLE_COUNTER_BUCKETS];
+} profile_entry_t;
+
+static profile_entry_t entries[PROFILE_HOOK_COUNT];
+
+void profiler_init(void) {
+  cycle_counter_init();
+  profiler_reset();
+}
+
+void profiler_reset(void) {
+  memset(entries, 0, sizeof(entries));
+  for (uint8_t i = 0; i < PROFILE_HOOK_COUNT; ++i) {
+    entries[i].min = UINT32_MAX;
+  }
+}
+
+void profiler_record(uint8_t hook, uint32_t cycles) {
+  profile_entry_t* e = &entries[hook];
+  if (e->count == UINT32_MAX) {
+    return;  // Saturated, keep the statistics we have.
+  }
+  ++e->count;
+  e->sum += cycles;
+  if (cycles < e->min) {
+    e->min = cycles;
+  }
+  if (cycles > e->max) {
+    e->max = cycles;
+  }
+
+  uint16_t* bucket = &e->buckets[cycle_counter_bucket(cycles)];
+  if (*bucket == UINT16_MAX) {
+    // Halve the histogram rather than saturate it, which keeps its shape.
+    for (uint8_t i = 0; i < CYCLE_COUNTER_BUCKETS; ++i) {
+      e->buckets[i] >>= 1;
+    }
+  }
+  ++*bucket;
+}
+
+// Returns the upper edge of the bucket holding the 99th percentile.
+static uint32_t estimate_p99(const profile_entry_t* e) {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < CYCLE_COUNTER_BUCKETS; ++i) {
+    total += e->buckets[i];
+  }
+  const uint32_t tail = total / 100;
+  uint32_t seen = 0;
+  for (int8_t i = CYCLE_COUNTER_BUCKETS - 1; i >= 0; --i) {
+    seen += e->buckets[i];
+    if (seen > tail) {
+      const uint32_t edge = (i == 31) ? UINT32_MAX : (UINT32_C(2) << i) - 1;
+      return edge < e->max ? edge : e->max;
+    }
+  }
+  return 0;
+}
+
+void profiler_get_stats(uint8_t hook, profile_stats_t* stats) {
+  const profile_entry_t* e = &entries[hook];
+  stats->count = e->count;
+  stats->min = e->count ? e->min : 0;
+  stats->mean = e->count ? (uint32_t)(e->sum / e->count) : 0;
+  stats->max = e->max;
+  stats->p99 = estimate_p99(e);
+}
+
+bool process_profiler_hid(uint8_t* data, uint8_t length) {
+  if (data[0] != USER_HID_PROFILER) {
+    return true;
+  }
+
+  switch (data[1]) {
+    case 0x00: {  // Read one hook.
+      const uint8_t hook = data[2];
+      if (hook >= PROFILE_HOOK_COUNT) {
+        user_hid_reply(data, length, USER_HID_ERROR);
+        break;
+      }
+      profile_stats_t stats;
+      profiler_get_stats(hook, &stats);
+      data[3] = PROFILE_HOOK_COUNT;
+      user_hid_put32(data + 4, stats.count);
+      user_hid_put32(data + 8, stats.min);
+      user_hid_put32(data + 12, stats.mean);
+      user_hid_put32(data + 16, stats.max);
+      user_hid_put32(data + 20, stats.p99);
+      user_hid_reply(data, length, USER_HID_OK);
+    } break;
+
+    case 0x01:  // Reset.
+      profiler_reset();
+      user_hid_reply(data, length, USER_HID_OK);
+      break;
+
+    default:
+      user_hid_reply(data, length, USER_HID_ERROR);
+  }
+  return false;
+}
+#endif  // PROFILER_ENABLE
@@ -0,0 +1,123 @@
+/**
+ * @file profiler.h
+ * @brief Scan-loop cost profiler for user hooks.
+ *
+ * Times selected hooks with the cycle counter (see cycle_counter.h) and keeps
+ * count, min, mean, max and an approximate p99 per hook in a fixed table. The
+ * table is read over raw HID with `scripts/user_hid.py profile`.
+ *
+ * Enable in custom.mk with
+ *
+ *     PROFILER_ENABLE = yes
+ *
+ * When disabled, `PROFILE_SCOPE()` and `PROFILE_CALL()` expand to nothing
+ * beyond the wrapped call, so instrumentation can stay in the keymap.
+ *
+ * Timings are inclusive: the `process_record_user()` figure contains the
+ * `process_achordion()` call made from it.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Profiled hooks. Keep in sync with PROFILE_HOOKS in scripts/user_hid.py. */
+enum profile_hook {
+  PROFILE_PROCESS_RECORD_USER,
+  PROFILE_PROCESS_ACHORDION,
+  PROFILE_ACHORDION_TASK,
+  PROFILE_RGB_INDICATORS,
+  PROFILE_DANCE_EACH,
+  PROFILE_DANCE_FINISHED,
+  PROFILE_DANCE_RESET,
+  PROFILE_HOOK_COUNT,
+};
+
+#ifdef PROFILER_ENABLE
+#include "cycle_counter.h"
+
+typedef struct {
+  uint8_t hook;
+  uint32_t start;
+} profile_scope_t;
+
+/** Summary of one hook's timings, in cycle counter units. */
+typedef struct {
+  uint32_t count;
+  uint32_t min;
+  uint32_t mean;
+  uint32_t max;
+  uint32_t p99;
+} profile_stats_t;
+
+/** Starts the cycle counter. Call from `keyboard_post_init_user()`. */
+void profiler_init(void);
+
+/** Adds one sample of `cycles` to `hook`'s statistics. */
+void profiler_record(uint8_t hook, uint32_t cycles);
+
+/** Clears all statistics. */
+void profiler_reset(void);
+
+/** Fills `stats` for `hook`. */
+void profiler_get_stats(uint8_t hook, profile_stats_t* stats);
+
+/**
+ * Raw HID handler for `USER_HID_PROFILER`, see user_hid.h.
+ *
+ * Subcommand 0x00 reads the hook in byte 2, replying with the hook, the hook
+ * count and the five `profile_stats_t` fields. Subcommand 0x01 resets.
+ */
+bool process_profiler_hid(uint8_t* data, uint8_t length);
+
+static inline profile_scope_t profiler_scope_begin(uint8_t hook) {
+  return (profile_scope_t){.hook = hook, .start = cycle_counter_read()};
+}
+
+static inline void profiler_scope_end(profile_scope_t* scope) {
+  profiler_record(scope->hook, cycle_counter_read() - scope->start);
+}
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+/**
+ * Times the rest of the enclosing block, including every return path.
+ *
+ *     bool rgb_matrix_indicators_user(void) {
+ *       PROFILE_SCOPE(PROFILE_RGB_INDICATORS);
+ *       // ...
+ *     }
+ */
+#define PROFILE_SCOPE(hook)                                         \
+  profile_scope_t PROFILE_CONCAT(profile_scope_, __LINE__)          \
+      __attribute__((cleanup(profiler_scope_end))) =                \
+          profiler_scope_begin(hook)
+
+/**
+ * Times a single call, evaluating to its result.
+ *
+ *     if (!PROFILE_CALL(PROFILE_PROCESS_ACHORDION,
+ *                       process_achordion(keycode, record))) {
+ *       return false;
+ *     }
+ */
+#define PROFILE_CALL(hook, call) \
+  ({                             \
+    PROFILE_SCOPE(hook);         \
+    call;                        \
+  })
+#else
+static inline void profiler_init(void) {}
+
+#define PROFILE_SCOPE(hook)
+#define PROFILE_CALL(hook, call) (call)
+#endif  // PROFILER_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,103 @@
+/**
+ * @file scan_stats.c
+ * @brief Scan rate and housekeeping interval histogram.
+ */
+
+#include "scan_stats.h"
+
+#ifdef SCAN_STATS_ENABLE
+#include "cycle_counter.h"
+#include "user_hid.h"
+
+// Cycle count at the previous call, or 0 before the first one.
+static uint32_t last_cycles = 0;
+// Start of the current one-second window and scans counted in it.
+static uint32_t window_start = 0;
+static uint32_t window_scans = 0;
+// Scans in the last complete window.
+static uint32_t scan_rate = 0;
+static uint32_t max_interval = 0;
+static uint32_t total_intervals = 0;
+static uint16_t buckets[CYCLE_COUNTER_BUCKETS];
+
+void scan_stats_task(void) {
+  const uint32_t now = cycle_counter_read();
+  if (last_cycles) {
+    const uint32_t interval = now - last_cycles;
+    uint16_t* bucket = &buckets[cycle_counter_bucket(interval)];
+    if (*bucket == UINT16_MAX) {
+      // Halve the histogram rather than saturate it, which keeps its shape.
+      for (uint8_t i = 0; i < CYCLE_COUNTER_BUCKETS; ++i) {
+        buckets[i] >>= 1;
+      }
+    }
+    ++*bucket;
+    if (interval > max_interval) {
+      max_interval = interval;
+    }
+    ++total_intervals;
+  } else {
+    cycle_counter_init();
+    window_start = timer_read32();
+  }
+  // We use 0 to represent an unset counter, so `| 1` to force a nonzero value.
+  last_cycles = now | 1;
+
+  ++window_scans;
+  const uint32_t elapsed = timer_elapsed32(window_start);
+  if (elapsed >= 1000) {
+    scan_rate = window_scans;
+    window_scans = 0;
+    // After a stall of a second or more, the next window starts now, rather
+    // than with a run of windows already over that each count one scan.
+    window_start = elapsed < 2000 ? window_start + 1000 : timer_read32();
+  }
+}
+
+uint32_t scan_stats_rate(void) { return scan_rate; }
+
+void scan_stats_reset(void) {
+  memset(buckets, 0, sizeof(buckets));
+  max_interval = 0;
+  total_intervals = 0;
+  last_cycles = 0;
+  window_scans = 0;
+}
+
+bool process_scan_stats_hid(uint8_t* data, uint8_t length) {
+  if (data[0] != USER_HID_SCAN_STATS) {
+    return true;
+  }
+
+  switch (data[1]) {
+    case 0x00:  // Summary.
+      user_hid_put32(data + 2, scan_rate);
+      user_hid_put32(data + 6, max_interval);
+      user_hid_put32(data + 10, total_intervals);
+      user_hid_reply(data, length, USER_HID_OK);
+      break;
+
+    case 0x01: {  // Histogram buckets from data[2].
+      const uint8_t first = data[2];
+      if (first >= CYCLE_COUNTER_BUCKETS) {
+        user_hid_reply(data, length, USER_HID_ERROR);
+        break;
+      }
+      data[3] = CYCLE_COUNTER_BUCKETS;
+      for (uint8_t i = 0; i < 14 && first + i < CYCLE_COUNTER_BUCKETS; ++i) {
+        user_hid_put16(data + 4 + 2 * i, buckets[first + i]);
+      }
+      user_hid_reply(data, length, USER_HID_OK);
+    } break;
+
+    case 0x02:  // Reset.
+      scan_stats_reset();
+      user_hid_reply(data, length, USER_HID_OK);
+      break;
+
+    default:
+      user_hid_reply(data, length, USER_HID_ERROR);
+  }
+  return false;
+}
+#endif  // SCAN_STATS_ENABLE
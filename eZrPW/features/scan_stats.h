@@ -0,0 +1,53 @@
+/**
+ * @file scan_stats.h
+ * @brief Scan rate and housekeeping interval histogram.
+ *
+ * `housekeeping_task_user()` runs once per pass of the main loop, right after
+ * the matrix scan, so timing its calls measures the scan loop as a whole:
+ * everything QMK, RGB Matrix, Achordion and tap dance do per scan shows up as
+ * a longer interval. This module counts scans per second and keeps a log2
+ * histogram of the intervals in cycle counter units (see cycle_counter.h).
+ *
+ * Enable in custom.mk with
+ *
+ *     SCAN_STATS_ENABLE = yes
+ *
+ * then call `scan_stats_task()` first thing in `housekeeping_task_user()`.
+ * Read the results with `scripts/user_hid.py scanrate`.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef SCAN_STATS_ENABLE
+/** Records one scan. Call from `housekeeping_task_user()`. */
+void scan_stats_task(void);
+
+/** Scans counted in the last complete one-second window. */
+uint32_t scan_stats_rate(void);
+
+/** Clears the histogram and counters. */
+void scan_stats_reset(void);
+
+/**
+ * Raw HID handler for `USER_HID_SCAN_STATS`, see user_hid.h.
+ *
+ * Subcommand 0x00 replies with the scan rate, the longest interval and the
+ * total number of intervals histogrammed. Subcommand 0x01 reads up to 14
+ * histogram buckets starting at the index in byte 2; the buckets are halved
+ * whenever one would overflow, so they give proportions rather than counts.
+ * Subcommand 0x02 resets.
+ */
+bool process_scan_stats_hid(uint8_t* data, uint8_t length);
+#else
+static inline void scan_stats_task(void) {}
+#endif  // SCAN_STATS_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,78 @@
+/**
+ * @file stack_usage.c
+ * @brief Stack high-water marks, by painting the stacks at boot.
+ */
+
+#include "stack_usage.h"
+
+#ifdef STACK_USAGE_ENABLE
+#include "user_hid.h"
+
+#ifndef PROTOCOL_CHIBIOS
+#error "stack_usage: Needs the stack symbols of ChibiOS's linker scripts."
+#endif
+
+// Stack bounds from ChibiOS's rules_stacks.ld. Stacks grow down from `end`.
+extern uint32_t __main_stack_base__[], __main_stack_end__[];
+extern uint32_t __main_thread_stack_base__[], __main_thread_stack_end__[];
+
+// Words left unpainted below the current frame. An interrupt taken while
+// painting stacks its context, up to 26 words with the FPU's, on the process
+// stack before switching to the exception stack.
+#define PAINT_MARGIN_WORDS 32
+
+static inline uint32_t* stack_pointer(void) {
+  return (uint32_t*)__builtin_frame_address(0);
+}
+
+void stack_usage_init(void) {
+  uint32_t* const top = stack_pointer() - PAINT_MARGIN_WORDS;
+  for (uint32_t* p = __main_thread_stack_base__; p < top; ++p) {
+    *p = STACK_USAGE_PATTERN;
+  }
+}
+
+// Finds the lowest word of [base, end) the stack has overwritten.
+static stack_usage_t measure(const uint32_t* base, const uint32_t* end) {
+  const uint32_t* p = base;
+  while (p < end && *p == STACK_USAGE_PATTERN) {
+    ++p;
+  }
+  return (stack_usage_t){
+      .size = (end - base) * sizeof(uint32_t),
+      .peak = (end - p) * sizeof(uint32_t),
+  };
+}
+
+stack_usage_t stack_usage_process(void) {
+  return measure(__main_thread_stack_base__, __main_thread_stack_end__);
+}
+
+stack_usage_t stack_usage_exceptions(void) {
+  return measure(__main_stack_base__, __main_stack_end__);
+}
+
+uint32_t stack_usage_current(void) {
+  return ((uintptr_t)__main_thread_stack_end__ - (uintptr_t)stack_pointer());
+}
+
+bool process_stack_usage_hid(uint8_t* data, uint8_t length) {
+  if (data[0] != USER_HID_STACK) {
+    return true;
+  }
+
+  if (data[1] == 0x00) {
+    const stack_usage_t process = stack_usage_process();
+    const stack_usage_t exceptions = stack_usage_exceptions();
+    user_hid_put32(data + 2, process.size);
+    user_hid_put32(data + 6, process.peak);
+    user_hid_put32(data + 10, exceptions.size);
+    user_hid_put32(data + 14, exceptions.peak);
+    user_hid_put32(data + 18, stack_usage_current());
+    user_hid_reply(data, length, USER_HID_OK);
+  } else {
+    user_hid_reply(data, length, USER_HID_ERROR);
+  }
+  return false;
+}
+#endif  // STACK_USAGE_ENABLE
@@ -0,0 +1,67 @@
+/**
+ * @file stack_usage.h
+ * @brief Stack high-water marks, by painting the stacks at boot.
+ *
+ * On ChibiOS, QMK's main loop runs on the main thread's process stack, and
+ * interrupts run on the separate exception stack, both sized by the linker
+ * script. `stack_usage_init()` fills the unused part of the process stack
+ * with a known pattern; the deepest point either stack has ever reached is
+ * then the lowest word no longer holding it. The exception stack is not
+ * painted here, since interrupts may be using it, but ChibiOS's startup code
+ * fills both stacks with the same pattern before main() (CRT0_INIT_STACKS).
+ *
+ * Enable in custom.mk with
+ *
+ *     STACK_USAGE_ENABLE = yes
+ *
+ * call `stack_usage_init()` from `keyboard_pre_init_user()`, and read the
+ * marks with `scripts/user_hid.py stack`. For the static RAM and flash each
+ * module takes, see scripts/footprint.py.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Word the stacks are painted with, as ChibiOS's CRT0_STACKS_FILL_PATTERN. */
+#define STACK_USAGE_PATTERN 0x55555555u
+
+#ifdef STACK_USAGE_ENABLE
+typedef struct {
+  /** Stack size in bytes. */
+  uint32_t size;
+  /** Most bytes ever in use, as far as the paint shows. */
+  uint32_t peak;
+} stack_usage_t;
+
+/** Paints the free process stack. Call from `keyboard_pre_init_user()`. */
+void stack_usage_init(void);
+
+/** High-water mark of the process stack, the one QMK's main loop runs on. */
+stack_usage_t stack_usage_process(void);
+
+/** High-water mark of the exception stack, the one interrupts run on. */
+stack_usage_t stack_usage_exceptions(void);
+
+/** Bytes of process stack in use at the call. */
+uint32_t stack_usage_current(void);
+
+/**
+ * Raw HID handler for `USER_HID_STACK`, see user_hid.h.
+ *
+ * Subcommand 0x00 replies with the process stack's size and peak, the
+ * exception stack's size and peak, and the process stack in use while
+ * answering.
+ */
+bool process_stack_usage_hid(uint8_t* data, uint8_t length);
+#else
+static inline void stack_usage_init(void) {}
+#endif  // STACK_USAGE_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
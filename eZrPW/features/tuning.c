@@ -0,0 +1,184 @@
+/**
+ * @file tuning.c
+ * @brief Achordion settings in RAM, tuned over raw HID without reflashing.
+ */
+
+#include "tuning.h"
+
+#ifdef TUNING_ENABLE
+#include "achordion.h"
+#include "user_hid.h"
+
+// Blocks as saved in EEPROM. A version of 0, as after an EEPROM reset, means
+// nothing is saved.
+typedef struct {
+  uint16_t version;
+  tuning_params_t profiles[TUNING_PROFILES];
+} tuning_saved_t;
+
+_Static_assert(sizeof(tuning_saved_t) == EECONFIG_USER_DATA_SIZE,
+               "Set EECONFIG_USER_DATA_SIZE in config.h to the saved size.");
+
+static tuning_params_t profiles[TUNING_PROFILES];
+// The active profile, which the callbacks below read.
+static tuning_params_t* params = &profiles[0];
+
+static void reset(void) {
+  memset(profiles, 0, sizeof(profiles));
+  for (uint8_t p = 0; p < TUNING_PROFILES; ++p) {
+    profiles[p].timeout = TUNING_KEYMAP;
+    for (uint8_t i = 0; i < TUNING_STREAK_CLASSES; ++i) {
+      profiles[p].streak_timeout[i] = TUNING_KEYMAP;
+    }
+    profiles[p].max_streak_timeout = TUNING_KEYMAP;
+    profiles[p].eager_mods = TUNING_KEYMAP;
+  }
+}
+
+// The saved blocks are too large for the stack, so they are read and written
+// through a static copy.
+static tuning_saved_t saved;
+
+static bool load(void) {
+  eeconfig_read_user_datablock(&saved);
+  if (saved.version != TUNING_VERSION) {
+    return false;
+  }
+  memcpy(profiles, saved.profiles, sizeof(profiles));
+  return true;
+}
+
+static void save(void) {
+  saved.version = TUNING_VERSION;
+  memcpy(saved.profiles, profiles, sizeof(profiles));
+  eeconfig_update_user_datablock(&saved);
+}
+
+void tuning_init(void) {
+  if (!load()) {
+    reset();
+  }
+}
+
+tuning_params_t* tuning_params(void) { return params; }
+
+void tuning_select(uint8_t profile) {
+  if (profile < TUNING_PROFILES) {
+    params = &profiles[profile];
+  }
+}
+
+uint8_t tuning_profile(void) { return params - profiles; }
+
+static uint8_t streak_class(uint16_t keycode) {
+  if (IS_QK_LAYER_TAP(keycode)) {
+    return TUNING_STREAK_LAYER;
+  }
+  const uint8_t mod = mod_config(QK_MOD_TAP_GET_MODS(keycode));
+  if (mod & MOD_LSFT) {
+    return TUNING_STREAK_SHIFT;
+  } else if (mod & MOD_LGUI) {
+    return TUNING_STREAK_GUI;
+  } else if (mod & MOD_LALT) {
+    return TUNING_STREAK_ALT;
+  }
+  return TUNING_STREAK_CTRL;
+}
+
+uint16_t tuning_streak_chord_timeout(uint16_t tap_hold_keycode) {
+  return params->streak_timeout[streak_class(tap_hold_keycode)];
+}
+
+bool tuning_has_streak_keys(void) { return params->streak_keys_set; }
+
+bool tuning_is_streak_key(uint16_t keycode) {
+  return keycode <= 0xFF &&
+         (params->streak_keys[keycode >> 3] & (1 << (keycode & 7)));
+}
+
+uint16_t achordion_timeout(uint16_t tap_hold_keycode) {
+  for (uint8_t i = 0; i < TUNING_KEYS && params->keys[i].keycode != KC_NO;
+       ++i) {
+    if (params->keys[i].keycode == tap_hold_keycode) {
+      return params->keys[i].timeout;
+    }
+  }
+  return params->timeout != TUNING_KEYMAP
+             ? params->timeout
+             : achordion_default_timeout(tap_hold_keycode);
+}
+
+bool achordion_eager_mod(uint8_t mod) {
+  if (params->eager_mods == TUNING_KEYMAP) {
+    return achordion_default_eager_mod(mod);
+  }
+  // 5-bit mod to 8-bit mods.
+  const uint8_t mods = (mod & 0x10) ? (mod & 0x0F) << 4 : (mod & 0x0F);
+  return mods && (mods & ~params->eager_mods) == 0;
+}
+
+uint16_t achordion_max_streak_timeout(void) {
+  return params->max_streak_timeout != TUNING_KEYMAP
+             ? params->max_streak_timeout
+             : achordion_default_max_streak_timeout();
+}
+
+bool process_tuning_hid(uint8_t* data, uint8_t length) {
+  if (data[0] != USER_HID_TUNING) {
+    return true;
+  }
+
+  const uint16_t offset = user_hid_get16(data + 2);
+  const uint8_t count = data[4];
+  switch (data[1]) {
+    case 0x06:  // Activate.
+      if (data[2] >= TUNING_PROFILES) {
+        user_hid_reply(data, length, USER_HID_ERROR);
+        return false;
+      }
+      tuning_select(data[2]);
+      data[3] = TUNING_PROFILES;
+      break;
+    case 0x00:  // Info.
+      eeconfig_read_user_datablock(&saved);
+      user_hid_put16(data + 2, sizeof(tuning_params_t));
+      data[4] = TUNING_VERSION;
+      data[5] = TUNING_KEYS;
+      data[6] = saved.version == TUNING_VERSION;
+      data[7] = TUNING_PROFILES;
+      data[8] = tuning_profile();
+      break;
+    case 0x01:  // Read.
+      if (count > length - 2 || offset + count > sizeof(profiles)) {
+        user_hid_reply(data, length, USER_HID_ERROR);
+        return false;
+      }
+      memcpy(data + 2, (const uint8_t*)profiles + offset, count);
+      break;
+    case 0x02:  // Write.
+      if (count > length - 5 || offset + count > sizeof(profiles)) {
+        user_hid_reply(data, length, USER_HID_ERROR);
+        return false;
+      }
+      memcpy((uint8_t*)profiles + offset, data + 5, count);
+      break;
+    case 0x03:  // Save.
+      save();
+      break;
+    case 0x04:  // Load.
+      if (!load()) {
+        user_hid_reply(data, length, USER_HID_ERROR);
+        return false;
+      }
+      break;
+    case 0x05:  // Reset.
+      reset();
+      break;
+    default:
+      user_hid_reply(data, length, USER_HID_ERROR);
+      return false;
+  }
+  user_hid_reply(data, length, USER_HID_OK);
+  return false;
+}
+#endif  // TUNING_ENABLE
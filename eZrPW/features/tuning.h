@@ -0,0 +1,143 @@
+/**
+ * @file tuning.h
+ * @brief Achordion settings in RAM, tuned over raw HID without reflashing.
+ *
+ * The settings Achordion reads through its callbacks are kept in a parameter
+ * block, `tuning_params_t`, which `scripts/user_hid.py tune` reads and writes
+ * while the keyboard runs, so a change takes effect with the next key press
+ * instead of the next firmware build. The block can be saved to the EEPROM
+ * user datablock and is loaded from it at boot.
+ *
+ * There are TUNING_PROFILES blocks, and Achordion reads the active one, so a
+ * switch between profiles tuned for different applications is a pointer
+ * change. `scripts/profile_daemon.py` switches as the focused window changes.
+ *
+ * A field holding TUNING_KEYMAP keeps what the keymap does without tuning, so
+ * a fresh block changes nothing. This module defines `achordion_timeout()`,
+ * `achordion_eager_mod()` and `achordion_max_streak_timeout()` with
+ * Achordion's defaults as fallback, so the keymap must not define them; the
+ * keymap's own `achordion_streak_chord_timeout()` and
+ * `achordion_streak_continue()` ask `tuning_streak_chord_timeout()` and
+ * `tuning_is_streak_key()` first.
+ *
+ * Enable in custom.mk with
+ *
+ *     TUNING_ENABLE = yes
+ *
+ * and call `tuning_init()` from `keyboard_post_init_user()`.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Keeps the keymap's setting for a field of tuning_params_t. */
+#define TUNING_KEYMAP 0xFFFF
+
+/** Per-key timeout entries. */
+#define TUNING_KEYS 16
+
+/** Parameter blocks to switch between. */
+#ifndef TUNING_PROFILES
+#define TUNING_PROFILES 4
+#endif
+
+/** Classes of tap-hold keys with a streak timeout each. */
+enum tuning_streak_class {
+  TUNING_STREAK_CTRL,
+  TUNING_STREAK_SHIFT,
+  TUNING_STREAK_ALT,
+  TUNING_STREAK_GUI,
+  TUNING_STREAK_LAYER,
+  TUNING_STREAK_CLASSES,
+};
+
+/**
+ * Parameter block, transferred byte for byte over raw HID and kept in the
+ * EEPROM user datablock. Keep the layout in sync with TUNING_FORMAT in
+ * scripts/user_hid.py; change TUNING_VERSION when it changes.
+ */
+typedef struct {
+  /** achordion_timeout() for keys without an entry in `keys`. */
+  uint16_t timeout;
+  /**
+   * achordion_streak_chord_timeout() per class of the tap-hold key. A mod-tap
+   * with several mods takes the first of Shift, GUI, Alt and Ctrl it has.
+   */
+  uint16_t streak_timeout[TUNING_STREAK_CLASSES];
+  /** achordion_max_streak_timeout(). */
+  uint16_t max_streak_timeout;
+  /**
+   * Mods achordion_eager_mod() applies eagerly, as 8-bit mods (left hand in
+   * the low nibble). A mod-tap is eager if all its mods are in the set.
+   */
+  uint16_t eager_mods;
+  /** achordion_timeout() per tap-hold keycode; KC_NO ends the list. */
+  struct {
+    uint16_t keycode;
+    uint16_t timeout;
+  } keys[TUNING_KEYS];
+  /** Nonzero to replace the keymap's streak keys with `streak_keys`. */
+  uint8_t streak_keys_set;
+  uint8_t reserved;
+  /** Bitmap of the basic keycodes that continue a typing streak. */
+  uint8_t streak_keys[32];
+} tuning_params_t;
+
+#define TUNING_VERSION 2
+
+#ifdef TUNING_ENABLE
+/** Loads the saved blocks, if any. Call from `keyboard_post_init_user()`. */
+void tuning_init(void);
+
+/** The block in effect. */
+tuning_params_t* tuning_params(void);
+
+/** Makes `profile` the block in effect, if it exists. */
+void tuning_select(uint8_t profile);
+
+/** Index of the block in effect. */
+uint8_t tuning_profile(void);
+
+/**
+ * Streak timeout for `tap_hold_keycode`, or TUNING_KEYMAP to use the keymap's.
+ */
+uint16_t tuning_streak_chord_timeout(uint16_t tap_hold_keycode);
+
+/** Returns true if the block replaces the keymap's streak keys. */
+bool tuning_has_streak_keys(void);
+
+/** Returns true if the basic keycode `keycode` continues a typing streak. */
+bool tuning_is_streak_key(uint16_t keycode);
+
+/**
+ * Raw HID handler for `USER_HID_TUNING`, see user_hid.h.
+ *
+ * Subcommand 0x00 replies with the block size, TUNING_VERSION, TUNING_KEYS,
+ * whether EEPROM holds saved blocks, TUNING_PROFILES and the active profile.
+ * Reads and writes address the blocks back to back, profile n at n times the
+ * block size. 0x01 reads up to 30 bytes from the offset in bytes 2-3, the
+ * count in byte 4, into the reply's payload. 0x02 writes the count in byte 4,
+ * up to 27, of bytes from byte 5 at the offset in bytes 2-3. 0x03 saves all
+ * blocks to EEPROM, 0x04 loads them back and 0x05 resets them to the keymap's
+ * settings without touching EEPROM. 0x06 activates the profile in byte 2,
+ * without reading EEPROM, and replies with the profile in byte 2 and
+ * TUNING_PROFILES in byte 3.
+ */
+bool process_tuning_hid(uint8_t* data, uint8_t length);
+#else
+static inline void tuning_init(void) {}
+static inline uint16_t tuning_streak_chord_timeout(uint16_t tap_hold_keycode) {
+  return TUNING_KEYMAP;
+}
+static inline bool tuning_has_streak_keys(void) { return false; }
+static inline bool tuning_is_streak_key(uint16_t keycode) { return false; }
+#endif  // TUNING_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
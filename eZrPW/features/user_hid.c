@@ -0,0 +1,31 @@
+/**
+ * @file user_hid.c
+ * @brief Keymap-level raw HID commands alongside Oryx's.
+ */
+
+#include "user_hid.h"
+
+#ifdef RAW_ENABLE
+#include "raw_hid.h"
+
+void __real_raw_hid_receive(uint8_t* data, uint8_t length);
+
+// Linked in place of `raw_hid_receive()` by `--wrap`, see custom.mk.
+void __wrap_raw_hid_receive(uint8_t* data, uint8_t length) {
+  if (length < 2 || process_raw_hid_user(data, length)) {
+    __real_raw_hid_receive(data, length);
+  }
+}
+
+void user_hid_reply(uint8_t* data, uint8_t length, uint8_t status) {
+  data[1] = status;
+  raw_hid_send(data, length);
+}
+#else
+void user_hid_reply(uint8_t* data, uint8_t length, uint8_t status) {}
+#endif  // RAW_ENABLE
+
+__attribute__((weak)) bool process_raw_hid_user(uint8_t* data,
+                                                uint8_t length) {
+  return true;
+}
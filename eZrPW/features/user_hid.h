@@ -0,0 +1,85 @@
+/**
+ * @file user_hid.h
+ * @brief Keymap-level raw HID commands alongside Oryx's.
+ *
+ * Oryx owns `raw_hid_receive()`, so keymap code has no hook of its own into
+ * the raw HID channel. custom.mk links with `-Wl,--wrap=raw_hid_receive`, which
+ * routes every incoming packet through this module first: packets whose
+ * command byte is one of ours are answered here, and all others fall through
+ * to Oryx untouched.
+ *
+ * Packets are RAW_EPSIZE (32) bytes. Byte 0 is the command, byte 1 the
+ * subcommand. Replies echo the command byte followed by a status byte, then the
+ * command's payload; multi-byte values are little endian.
+ *
+ * The host side of these commands is scripts/user_hid.py.
+ */
+
+#pragma once
+
+#include "quantum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Command bytes, in a block Oryx does not use. */
+enum user_hid_command {
+  USER_HID_PROFILER = 0xA0,
+  USER_HID_SCAN_STATS = 0xA1,
+  USER_HID_LATENCY = 0xA2,
+  USER_HID_KEY_TRACE = 0xA3,
+  USER_HID_STACK = 0xA4,
+  USER_HID_BYPASS = 0xA5,
+  USER_HID_TUNING = 0xA6,
+  USER_HID_HEATMAP = 0xA7,
+};
+
+/** Reply status byte. */
+enum user_hid_status {
+  USER_HID_OK = 0x00,
+  USER_HID_ERROR = 0x01,
+};
+
+/**
+ * Optional callback for handling raw HID packets.
+ *
+ * In your keymap.c, chain module handlers as
+ *
+ *     bool process_raw_hid_user(uint8_t* data, uint8_t length) {
+ *       if (!process_profiler_hid(data, length)) { return false; }
+ *       return true;
+ *     }
+ *
+ * Return false once a packet has been handled, or true to pass it on to Oryx.
+ */
+bool process_raw_hid_user(uint8_t* data, uint8_t length);
+
+/**
+ * Sends `data` back to the host as a reply with the given status, in place.
+ *
+ * Byte 0 (the command) is kept, byte 1 is overwritten with `status`. Handlers
+ * fill their payload from byte 2 before calling this.
+ */
+void user_hid_reply(uint8_t* data, uint8_t length, uint8_t status);
+
+/** Stores `value` little endian at `dest`. */
+static inline void user_hid_put16(uint8_t* dest, uint16_t value) {
+  dest[0] = value & 0xff;
+  dest[1] = value >> 8;
+}
+
+/** Stores `value` little endian at `dest`. */
+static inline void user_hid_put32(uint8_t* dest, uint32_t value) {
+  user_hid_put16(dest, value & 0xffff);
+  user_hid_put16(dest + 2, value >> 16);
+}
+
+/** Loads a little-endian value from `src`. */
+static inline uint16_t user_hid_get16(const uint8_t* src) {
+  return src[0] | (src[1] << 8);
+}
+
+#ifdef __cplusplus
+}
+#endif
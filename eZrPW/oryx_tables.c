@@ -0,0 +1,51 @@
+// Generated by scripts/oryx_codegen.py from the Oryx export. Do not
+// edit; rerun the generator (scripts/apply-custom-qmk.sh does).
+
+#include "oryx_tables.h"
+
+// 6 colors: 174 bytes in place of Oryx's 468.
+const uint8_t PROGMEM ledmap_palette[LEDMAP_PALETTE_SIZE][3] = {
+    {0, 0, 0}, {36, 249, 255}, {0, 0, 255}, {139, 218, 194},
+    {246, 227, 194}, {212, 227, 194},
+};
+
+const uint8_t PROGMEM
+    ledmap_colors[LEDMAP_LAYERS][RGB_MATRIX_LED_COUNT] = {
+    [1] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 2,
+        3, 3, 3, 3, 1, 0, 2, 2, 2, 2, 1, 0, 2, 3, 3, 2,
+        1, 0, 0, 0,
+    },
+    [2] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        4, 5, 5, 5, 4, 0, 4, 5, 5, 5, 4, 0, 4, 5, 5, 5,
+        4, 0, 5, 4,
+    },
+};
+
+#ifdef TAP_DANCE_ENABLE
+// Keycodes of single tap, single hold, double tap, double hold and tap then
+// tap, and of taps from the third on.
+const oryx_dance_t PROGMEM oryx_dances[ORYX_DANCES] = {
+    {{KC_BSLS, KC_NO, KC_BSLS, KC_PIPE, KC_BSLS}, KC_BSLS},
+    {{KC_QUOTE, KC_NO, KC_QUOTE, KC_DQUO, KC_QUOTE}, KC_QUOTE},
+    {{KC_GRAVE, KC_NO, KC_GRAVE, KC_TILD, KC_GRAVE}, KC_GRAVE},
+};
+
+tap_dance_action_t tap_dance_actions[] = {
+    ORYX_DANCE(0),
+    ORYX_DANCE(1),
+    ORYX_DANCE(2),
+};
+#endif  // TAP_DANCE_ENABLE
+
+// clang-format off
+const char PROGMEM tap_hold_hands[MATRIX_ROWS][MATRIX_COLS] = LAYOUT_voyager(
+    'L', 'L', 'L', 'L', 'L', 'L',    'R', 'R', 'R', 'R', 'R', 'R',
+    'L', 'L', 'L', 'L', 'L', 'L',    'R', 'R', 'R', 'R', 'R', 'R',
+    'L', 'L', 'L', 'L', 'L', 'L',    'R', 'R', 'R', 'R', 'R', 'R',
+    'L', 'L', 'L', 'L', 'L', 'L',    'R', 'R', 'R', 'R', 'R', 'R',
+                        'L', 'L',    'R', 'R');
+// clang-format on
@@ -0,0 +1,29 @@
+// Generated by scripts/oryx_codegen.py from the Oryx export. Do not
+// edit; rerun the generator (scripts/apply-custom-qmk.sh does).
+
+#pragma once
+
+#include "quantum.h"
+
+/** Layers in `ledmap_colors`, and colors in `ledmap_palette`. */
+#define LEDMAP_LAYERS 3
+#define LEDMAP_PALETTE_SIZE 6
+
+/** Oryx's layer colors as HSV, black first. */
+extern const uint8_t PROGMEM ledmap_palette[LEDMAP_PALETTE_SIZE][3];
+/** Index into `ledmap_palette` of each LED's color per layer. */
+extern const uint8_t PROGMEM
+    ledmap_colors[LEDMAP_LAYERS][RGB_MATRIX_LED_COUNT];
+
+#include "features/oryx_dance.h"
+
+/** Dances in `oryx_dances`, in Oryx's tap_dance_codes order. */
+#define ORYX_DANCES 3
+
+extern const oryx_dance_t PROGMEM oryx_dances[ORYX_DANCES];
+
+/**
+ * Hand of each key for Achordion: 'L', 'R', or '*' to chord with either.
+ * 0 at the matrix positions no key uses.
+ */
+extern const char PROGMEM tap_hold_hands[MATRIX_ROWS][MATRIX_COLS];
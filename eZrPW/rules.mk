@@ -7,4 +7,4 @@ TAP_DANCE_ENABLE = yes
 SPACE_CADET_ENABLE = no
 CAPS_WORD_ENABLE = yes
 
-SRC += features/achordion.c
+include $(dir $(lastword $(MAKEFILE_LIST)))custom.mk
@@ -5,6 +5,8 @@
 set -e  # Exit immediately on error
 
 KEYMAP_DIR="eZrPW"
+# Options for oryx_codegen.py, such as hand overrides: (--hand 48='*')
+ORYX_CODEGEN_ARGS=()
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 
 # Colors for output
@@ -31,16 +33,19 @@ has_pattern() {
 }
 
 ##############################################################################
-# 1. PATCH rules.mk - Add achordion source file
+# 1. PATCH rules.mk - Include custom.mk, the custom features' build rules
 ##############################################################################
 patch_rules_mk() {
     local file="${KEYMAP_DIR}/rules.mk"
     validate_file "$file"
+    validate_file "${KEYMAP_DIR}/custom.mk"
 
-    local pattern="SRC += features/achordion.c"
+    # Oryx rewrites rules.mk, so the custom rules live in custom.mk, which
+    # the merge leaves alone, and only this line has to come back.
+    local pattern='include $(dir $(lastword $(MAKEFILE_LIST)))custom.mk'
 
     if has_pattern "$pattern" "$file"; then
-        log_info "rules.mk: achordion already enabled"
+        log_info "rules.mk: custom.mk already included"
         return 0
     fi
 
@@ -50,22 +55,28 @@ patch_rules_mk() {
         exit 1
     fi
 
-    echo "" >> "$file"
-    echo "$pattern" >> "$file"
-    log_info "rules.mk: Added achordion source"
+    # Older merges added the achordion source here, which custom.mk has now.
+    if has_pattern "SRC += features/achordion.c" "$file"; then
+        sed -i 's|^SRC += features/achordion.c$|'"$pattern"'|' "$file"
+    else
+        echo "" >> "$file"
+        echo "$pattern" >> "$file"
+    fi
+    log_info "rules.mk: Included custom.mk"
 }
 
 ##############################################################################
-# 2. PATCH config.h - Add achordion configuration
+# 2. PATCH config.h - Include custom_config.h, the custom features' options
 ##############################################################################
 patch_config_h() {
     local file="${KEYMAP_DIR}/config.h"
     validate_file "$file"
+    validate_file "${KEYMAP_DIR}/custom_config.h"
 
-    local pattern="#define ACHORDION_STREAK"
+    local pattern='#include "custom_config.h"'
 
-    if has_pattern "ACHORDION_STREAK" "$file"; then
-        log_info "config.h: ACHORDION_STREAK already defined"
+    if has_pattern "$pattern" "$file"; then
+        log_info "config.h: custom_config.h already included"
         return 0
     fi
 
@@ -75,133 +86,146 @@ patch_config_h() {
         exit 1
     fi
 
-    echo "$pattern" >> "$file"
-    log_info "config.h: Added ACHORDION_STREAK define"
+    # Older merges defined this here, which custom_config.h does now.
+    if has_pattern "#define ACHORDION_STREAK" "$file"; then
+        sed -i 's|^#define ACHORDION_STREAK$|'"$pattern"'|' "$file"
+    else
+        echo "" >> "$file"
+        echo "$pattern" >> "$file"
+    fi
+    log_info "config.h: Included custom_config.h"
 }
 
 ##############################################################################
-# 3. PATCH keymap.c - Integrate achordion
+# 3. PATCH keymap.c - Include custom_keymap.c and call it from Oryx's hooks
 ##############################################################################
-patch_keymap_c() {
-    local file="${KEYMAP_DIR}/keymap.c"
-    local temp_file="${file}.tmp"
-    validate_file "$file"
+# The custom hooks live in custom_keymap.c, which the merge leaves alone.
+# keymap.c includes it, and the hooks Oryx also writes call into it first.
+CUSTOM_INCLUDE='#include "custom_keymap.c"'
+CUSTOM_CALLS=(
+    "keyboard_post_init_user|void keyboard_post_init_user(void)|  keyboard_post_init_custom();"
+    "process_record_user|bool process_record_user(uint16_t keycode, keyrecord_t *record)|  if (!process_record_custom(keycode, record)) { return false; }"
+)
+
+# Makes `line` the first statement of function `name` in `file`, adding the
+# function with `signature` if Oryx did not write it.
+ensure_call() {
+    local file="$1" name="$2" signature="$3" line="$4"
+
+    if has_pattern "$line" "$file"; then
+        log_info "keymap.c: ${name}() already calls custom_keymap.c"
+        return 0
+    fi
 
-    # Check if already patched
-    if has_pattern "process_achordion" "$file"; then
-        log_info "keymap.c: Already patched with achordion"
+    if ! grep -qE "^[a-z_0-9]+ ${name}\(.*\{$" "$file"; then
+        printf '\n%s {\n%s\n}\n' "$signature" "$line" >> "$file"
+        log_info "keymap.c: Added ${name}()"
         return 0
     fi
 
-    # Validate expected structure exists
-    if ! has_pattern 'bool process_record_user' "$file"; then
-        log_error "keymap.c: process_record_user function not found"
+    awk -v name="$name" -v line="$line" '
+        !done && $0 ~ "^[a-z_0-9]+ " name "\\(.*\\{$" {
+            print
+            print line
+            done = 1
+            next
+        }
+        { print }
+    ' "$file" > "${file}.tmp"
+    mv "${file}.tmp" "$file"
+    log_info "keymap.c: ${name}() calls custom_keymap.c"
+}
+
+patch_keymap_c() {
+    local file="${KEYMAP_DIR}/keymap.c"
+    validate_file "$file"
+    validate_file "${KEYMAP_DIR}/custom_keymap.c"
+
+    if has_pattern "$CUSTOM_INCLUDE" "$file"; then
+        log_info "keymap.c: custom_keymap.c already included"
+    elif has_pattern '#include "features/achordion.h"' "$file"; then
+        # Older merges included Achordion here, which custom_keymap.c does now.
+        sed -i 's|^#include "features/achordion.h"$|'"$CUSTOM_INCLUDE"'|' "$file"
+        log_info "keymap.c: Included custom_keymap.c"
+    elif has_pattern '#include "version.h"' "$file"; then
+        sed -i '0,/^#include "version.h"$/s||&\n'"$CUSTOM_INCLUDE"'|' "$file"
+        log_info "keymap.c: Included custom_keymap.c"
+    else
+        log_error "keymap.c: #include \"version.h\" not found"
         log_error "Oryx may have changed their code structure"
         exit 1
     fi
 
-    log_info "keymap.c: Applying achordion patches..."
-
-    # Create patched version
-    awk '
-    BEGIN {
-        in_process_record = 0
-        process_record_patched = 0
-        added_include = 0
-    }
-
-    # Add achordion include after version.h
-    /#include "version.h"/ && !added_include {
-        print
-        print "#include \"features/achordion.h\""
-        added_include = 1
-        next
-    }
-
-    # Detect start of process_record_user function
-    /^bool process_record_user.*\{$/ {
-        in_process_record = 1
-        print  # Print the function declaration
-        print "  if (!process_achordion(keycode, record)) { return false; }"
-        process_record_patched = 1
-        next
-    }
-
-    # Print all other lines
-    { print }
-
-    # At end of file, add custom achordion functions
-    END {
-        if (!process_record_patched) {
-            print "ERROR: Could not patch process_record_user" > "/dev/stderr"
-            exit 1
-        }
+    # Older merges called Achordion here, which process_record_custom() does.
+    sed -i '/^  if (!process_achordion(keycode, record)) { return false; }$/d' \
+        "$file"
 
-        print ""
-        print "void housekeeping_task_user(void) {"
-        print "  achordion_task();"
-        print "}"
-        print ""
-        print "uint16_t achordion_streak_chord_timeout("
-        print "    uint16_t tap_hold_keycode, uint16_t next_keycode) {"
-        print "  if (IS_QK_LAYER_TAP(tap_hold_keycode)) {"
-        print "    return 0;  // Disable streak detection on layer-tap keys."
-        print "  }"
-        print ""
-        print "  // Otherwise, tap_hold_keycode is a mod-tap key."
-        print "  uint8_t mod = mod_config(QK_MOD_TAP_GET_MODS(tap_hold_keycode));"
-        print "  if ((mod & (MOD_LSFT | MOD_RSFT)) != 0) {"
-        print "    return 0;  // Exclude left and right shift from typing streak."
-        print "  } else {"
-        print "    return 400;  // Longer timeout for other mod-tap keys."
-        print "  }"
-        print "}"
-        print ""
-        print "bool achordion_streak_continue(uint16_t keycode) {"
-        print "  // If mods other than shift or AltGr are held, dont continue the streak."
-        print "  if (get_mods() & (MOD_MASK_CG | MOD_BIT_LALT)) return false;"
-        print "  // Convert to tap keycodes."
-        print "  if (IS_QK_MOD_TAP(keycode)) {"
-        print "    keycode = QK_MOD_TAP_GET_TAP_KEYCODE(keycode);"
-        print "  }"
-        print "  if (IS_QK_LAYER_TAP(keycode)) {"
-        print "    keycode = QK_LAYER_TAP_GET_TAP_KEYCODE(keycode);"
-        print "  }"
-        print "  // Regular letters and punctuation continue the streak."
-        print "  if (keycode >= KC_A && keycode <= KC_Z) return true;"
-        print "  switch (keycode) {"
-        print "    case KC_DOT:"
-        print "    case KC_COMMA:"
-        print "    case KC_QUOTE:"
-        print "    case KC_SPACE:"
-        print "    case KC_EXLM:  // !"
-        print "    case KC_QUES:  // ?"
-        print "    case KC_AT:    // @"
-        print "    case KC_DLR:   // $"
-        print "      return true;"
-        print "  }"
-        print "  return false;  // All other keys end the streak."
-        print "}"
-    }
-    ' "$file" > "$temp_file"
-
-    # Validate the patched file was created successfully
-    if [[ ! -s "$temp_file" ]]; then
-        log_error "Failed to create patched keymap.c"
-        rm -f "$temp_file"
-        exit 1
+    local entry name signature line
+    for entry in "${CUSTOM_CALLS[@]}"; do
+        IFS='|' read -r name signature line <<< "$entry"
+        ensure_call "$file" "$name" "$signature" "$line"
+    done
+}
+
+##############################################################################
+# 4. GENERATE oryx_tables.c - Compile Oryx's ledmap and tap dances to tables
+##############################################################################
+generate_oryx_tables() {
+    local file="${KEYMAP_DIR}/keymap.c"
+    validate_file "$file"
+
+    # The merge only brings back the Oryx code it changed, so the tables are
+    # generated from the full export on the oryx branch when there is one.
+    local source="$file"
+    if git rev-parse --verify -q "oryx:${file}" > /dev/null; then
+        source="-"
+    elif ! has_pattern "PROGMEM ledmap[]" "$file"; then
+        log_info "oryx_tables.c: No Oryx export to regenerate from"
+        return 0
     fi
 
-    # Verify critical patterns exist in patched file
-    if ! has_pattern "process_achordion" "$temp_file"; then
-        log_error "Patching failed - process_achordion not found in result"
-        rm -f "$temp_file"
+    if ! git show "oryx:${file}" 2>/dev/null | \
+            python3 "${SCRIPT_DIR}/oryx_codegen.py" "$source" \
+                -o "$KEYMAP_DIR" --strip "$file" "${ORYX_CODEGEN_ARGS[@]}"; then
+        log_error "oryx_codegen.py failed"
         exit 1
     fi
+    log_info "oryx_tables.c: Generated from the Oryx export"
+}
+
+##############################################################################
+# 5. VERIFY keymap.c - Every custom hook in place, none defined twice
+##############################################################################
+verify_keymap_c() {
+    local file="${KEYMAP_DIR}/keymap.c"
+    local custom="${KEYMAP_DIR}/custom_keymap.c"
+    local failed=0 entry name signature line
 
-    # Replace original with patched version
-    mv "$temp_file" "$file"
-    log_info "keymap.c: Successfully integrated achordion"
+    if ! has_pattern "$CUSTOM_INCLUDE" "$file"; then
+        log_error "keymap.c: custom_keymap.c is not included"
+        failed=1
+    fi
+    for entry in "${CUSTOM_CALLS[@]}"; do
+        IFS='|' read -r name signature line <<< "$entry"
+        if ! has_pattern "$line" "$file"; then
+            log_error "keymap.c: ${name}() does not call custom_keymap.c"
+            failed=1
+        fi
+    done
+
+    # Oryx code the merge brought back, or hooks older merges added here.
+    for name in $(sed -nE 's/^(static )?[a-z_0-9]+ \**([a-z_0-9]+)\(.*/\2/p' \
+                      "$custom"); do
+        if grep -qE "^(static )?[a-z_0-9]+ \**${name}\(" "$file"; then
+            log_error "keymap.c: ${name}() is defined in custom_keymap.c too"
+            failed=1
+        fi
+    done
+
+    if (( failed )); then
+        exit 1
+    fi
+    log_info "keymap.c: All custom hooks in place"
 }
 
 ##############################################################################
@@ -229,6 +253,8 @@ main() {
     patch_rules_mk
     patch_config_h
     patch_keymap_c
+    generate_oryx_tables
+    verify_keymap_c
 
     echo "=========================================="
     log_info "All modifications applied successfully"
@@ -0,0 +1,223 @@
+#!/usr/bin/env python3
+"""Reports what the keymap's custom code costs and compares it to a baseline.
+
+Two measurements, each left out when it cannot be made:
+
+  * Size: flash and RAM per function and variable of Achordion, keymap.c and
+    the generated Oryx tables with their tap dance callbacks, read from the
+    linker map of a firmware build (see scripts/footprint.py). --build runs
+    scripts/build.sh first; otherwise the newest map in qmk_firmware/.build
+    is read, if any.
+  * Instructions: the host simulator, built into sim/build/bench, replays
+    sim/bench_trace.txt under icount, which counts the instructions executed
+    in each measured function, callees included. These are x86-64
+    instructions of the host build, not the keyboard's, but they are exact
+    and the same on every run, so any change in them is a change in the work
+    done.
+
+The measured functions are process_achordion() for each key event,
+layer_lighting_show() for each frame that shows a layer's colors (what
+Oryx's set_layer_color() did) and oryx_dance_finished() for each tap dance,
+which picks the dance's step with oryx_dance_step() (Oryx's dance_step()).
+
+Each figure is printed next to the baseline in sim/bench_baseline.json and
+the difference. --save writes the current figures as the new baseline;
+--max-growth fails the run when a module's size or a function's instruction
+total grew by more than the given percentage.
+
+Usage:
+    make -C sim bench
+    scripts/bench.py [--build] [--map MAPFILE] [--save]
+                     [--max-growth PCT] [--all]
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+import footprint
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                     ".."))
+SIM = os.path.join(ROOT, "sim")
+TRACE = os.path.join(SIM, "bench_trace.txt")
+BASELINE = os.path.join(SIM, "bench_baseline.json")
+MODULES = ["features/achordion.c", "keymap.c", "oryx_tables.c",
+           "features/oryx_dance.c"]
+FUNCTIONS = ["process_achordion", "layer_lighting_show", "oryx_dance_finished"]
+# The host's cycle counter is a clock, so layer lighting's time budget would
+# make the work per frame vary; without it, LAYER_LIGHTING_CHUNK_LEDS alone
+# bounds it, as on a keyboard fast enough to stay within the budget.
+BENCH_DEFS = "-DLAYER_LIGHTING_BUDGET_CYCLES=0"
+
+
+def measure_size(args):
+    """Returns {module: {symbol: [flash, ram]}}, or None without a map."""
+    if args.build:
+        subprocess.run([os.path.join(ROOT, "scripts", "build.sh"),
+                        "--keymap", args.keymap], check=True)
+    path = args.map or footprint.newest_map()
+    if path is None:
+        return None
+    regions, _, inputs = footprint.parse_map(path)
+    symbols = footprint.symbol_sizes(regions, inputs, args.keymap)
+    if not symbols:
+        sys.exit(f"{path}: no objects from keymaps/{args.keymap}/; "
+                 "was the build made with LTO_ENABLE = yes?")
+    return {module: {symbol: [flash, data + bss]
+                     for symbol, (flash, data, bss) in symbols[module].items()}
+            for module in MODULES if module in symbols}
+
+
+def measure_instructions():
+    """Returns {function: {"calls", "instructions", "max"}}."""
+    build = os.path.join(SIM, "build", "bench")
+    subprocess.run(["make", "-C", SIM, "-s", f"BUILD={build}",
+                    f"SIM_DEFS={BENCH_DEFS}", "all", "icount"], check=True)
+    sim = os.path.join(build, "sim_replay")
+    nm = subprocess.run(["nm", sim], check=True, capture_output=True,
+                        text=True).stdout
+    addresses = {}
+    for line in nm.splitlines():
+        fields = line.split()
+        if (len(fields) == 3 and fields[1] in ("t", "T") and
+                fields[2] in FUNCTIONS):
+            addresses[fields[2]] = fields[0]
+    missing = [f for f in FUNCTIONS if f not in addresses]
+    if missing:
+        sys.exit(f"{sim}: no symbol for {', '.join(missing)}")
+    out = subprocess.run(
+        [os.path.join(build, "icount")] +
+        [f"{f}={addresses[f]}" for f in FUNCTIONS] + ["--", sim, TRACE],
+        check=True, capture_output=True, text=True).stdout
+    counts = {}
+    for line in out.splitlines():
+        name, calls, total, most = line.split()
+        counts[name] = {"calls": int(calls), "instructions": int(total),
+                        "max": int(most)}
+    return counts
+
+
+def delta(now, before):
+    if before is None:
+        return "new"
+    if now == before:
+        return ""
+    percent = f" ({(now - before) / before:+.1%})" if before else ""
+    return f"{now - before:+}{percent}"
+
+
+def blank(value):
+    return "" if value is None else value
+
+
+def grew(now, before, limit):
+    return (limit is not None and before is not None and
+            now > before * (1 + limit / 100))
+
+
+def report_size(size, base, show_all, limit):
+    """Prints size per module and changed symbol; returns the modules over
+    the growth limit."""
+    row = "{:<36}{:>9}{:>9}{:>18}{:>9}{:>9}{:>18}"
+    print(row.format("size", "flash", "was", "", "RAM", "was", ""))
+    failed = []
+    for module in MODULES:
+        before = base.get(module)
+        if module not in size and before is None:
+            continue
+        symbols = size.get(module, {})
+        flash = sum(s[0] for s in symbols.values())
+        ram = sum(s[1] for s in symbols.values())
+        was_flash = sum(s[0] for s in before.values()) if before else None
+        was_ram = sum(s[1] for s in before.values()) if before else None
+        print(row.format(module, flash, "" if before is None else was_flash,
+                         delta(flash, was_flash), ram,
+                         "" if before is None else was_ram,
+                         delta(ram, was_ram)))
+        if grew(flash, was_flash, limit) or grew(ram, was_ram, limit):
+            failed.append(module)
+        for symbol in sorted(set(symbols) | set(before or {})):
+            now = symbols.get(symbol, [0, 0])
+            was = (before or {}).get(symbol)
+            if not show_all and was == now:
+                continue
+            was = was or [None, None]
+            print(row.format("  " + symbol, now[0], blank(was[0]),
+                             delta(now[0], was[0]), now[1], blank(was[1]),
+                             delta(now[1], was[1])))
+    return failed
+
+
+def report_instructions(counts, base, limit):
+    """Prints instructions per function; returns the functions over the
+    growth limit."""
+    row = "{:<36}{:>7}{:>12}{:>12}{:>18}{:>9}{:>9}"
+    print(row.format("instructions", "calls", "total", "was", "", "max",
+                     "was"))
+    failed = []
+    for function in FUNCTIONS:
+        now = counts[function]
+        was = base.get(function, {})
+        print(row.format(function, now["calls"], now["instructions"],
+                         blank(was.get("instructions")),
+                         delta(now["instructions"], was.get("instructions")),
+                         now["max"], blank(was.get("max"))))
+        if grew(now["instructions"], was.get("instructions"), limit):
+            failed.append(function)
+    return failed
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--keymap", default="eZrPW")
+    parser.add_argument("--build", action="store_true",
+                        help="build the firmware first with scripts/build.sh")
+    parser.add_argument("--map", help="linker map (default: newest "
+                        "qmk_firmware/.build/*.map)")
+    parser.add_argument("--baseline", default=BASELINE)
+    parser.add_argument("--save", action="store_true",
+                        help="write the figures as the new baseline")
+    parser.add_argument("--max-growth", type=float, metavar="PCT",
+                        help="fail if anything grew by more than PCT percent")
+    parser.add_argument("--all", action="store_true",
+                        help="list unchanged symbols too")
+    args = parser.parse_args()
+
+    baseline = {}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    size = measure_size(args)
+    counts = measure_instructions()
+
+    failed = []
+    if size is None:
+        print("size: no firmware map; build with scripts/build.sh or pass "
+              "--build")
+    else:
+        failed += report_size(size, baseline.get("size", {}), args.all,
+                              args.max_growth)
+    print()
+    failed += report_instructions(counts, baseline.get("instructions", {}),
+                                  args.max_growth)
+
+    if args.save:
+        # A run without a map keeps the baseline's sizes.
+        if size is not None:
+            baseline["size"] = size
+        baseline["instructions"] = counts
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print(f"\nbaseline saved to {os.path.relpath(args.baseline)}")
+    if failed:
+        sys.exit(f"\ngrew by more than {args.max_growth:g}%: "
+                 f"{', '.join(failed)}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,235 @@
+#!/bin/bash
+# Build the layout's firmware locally, reusing earlier builds where possible
+#
+# The inputs of a build are hashed: every file of the keymap directory
+# (custom features included), the qmk_firmware commit with its submodules and
+# any local changes to it, the Dockerfile and this script. A build whose hash
+# is in the cache is restored from it without starting Docker at all. Any
+# other build compiles in the toolchain image, which is made once per
+# Dockerfile and qmk_firmware commit, into qmk_firmware/.build, so make only
+# recompiles what changed since the last build. Once the toolchain image
+# exists, builds need no network.
+#
+# The firmware and its linker map end up where QMK's make puts them
+# (qmk_firmware/ and qmk_firmware/.build/), so scripts/footprint.py works
+# after a cache hit too.
+#
+# Usage:
+#     scripts/build.sh [--keymap eZrPW] [--geometry voyager] [--no-cache]
+#     scripts/build.sh --hash      # print the input hash and exit
+#
+# BUILD_CACHE_DIR (default .build-cache) sets where firmware is cached and
+# BUILD_CACHE_KEEP (default 8) how many builds are kept there.
+
+set -e  # Exit immediately on error
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+ROOT="$(cd "${SCRIPT_DIR}/.." && pwd)"
+QMK_DIR="${ROOT}/qmk_firmware"
+KEYMAP="eZrPW"
+GEOMETRY="voyager"
+USE_CACHE=1
+PRINT_HASH=0
+CACHE_DIR="${BUILD_CACHE_DIR:-${ROOT}/.build-cache}"
+CACHE_KEEP="${BUILD_CACHE_KEEP:-8}"
+
+# Colors for output
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+log_info() { echo -e "${GREEN}✓${NC} $1"; }
+log_warn() { echo -e "${YELLOW}⚠${NC} $1"; }
+log_error() { echo -e "${RED}✗${NC} $1"; }
+
+usage() {
+    sed -n 's/^#     //p' "${BASH_SOURCE[0]}"
+    exit "${1:-0}"
+}
+
+parse_args() {
+    while [[ $# -gt 0 ]]; do
+        case "$1" in
+            --keymap) KEYMAP="$2"; shift 2 ;;
+            --geometry) GEOMETRY="$2"; shift 2 ;;
+            --no-cache) USE_CACHE=0; shift ;;
+            --hash) PRINT_HASH=1; shift ;;
+            -h|--help) usage ;;
+            *) log_error "Unknown option: $1"; usage 2 ;;
+        esac
+    done
+}
+
+##############################################################################
+# 1. INPUTS - Hash everything the firmware is built from
+##############################################################################
+
+# Firmware version 24 on moved ZSA's keyboards under keyboards/zsa.
+make_target() {
+    if [[ -d "${QMK_DIR}/keyboards/zsa/${GEOMETRY}" ]]; then
+        echo "zsa/${GEOMETRY}"
+    else
+        echo "${GEOMETRY}"
+    fi
+}
+
+input_hash() {
+    {
+        echo "target $(make_target):${KEYMAP}"
+        (cd "$ROOT" && find "$KEYMAP" -type f -print0 | LC_ALL=C sort -z |
+            xargs -0 sha256sum)
+        (cd "$ROOT" && sha256sum Dockerfile scripts/build.sh)
+        git -C "$QMK_DIR" rev-parse HEAD
+        git -C "$QMK_DIR" submodule status --recursive
+        git -C "$QMK_DIR" diff HEAD
+    } | sha256sum | cut -c1-16
+}
+
+# Hash of the toolchain: the Dockerfile and the qmk_firmware commit, whose
+# install script picks the compiler.
+toolchain_hash() {
+    {
+        sha256sum < "${ROOT}/Dockerfile"
+        git -C "$QMK_DIR" rev-parse HEAD
+    } | sha256sum | cut -c1-12
+}
+
+##############################################################################
+# 2. CACHE - Restore or store a build's firmware and linker map
+##############################################################################
+restore_cached() {
+    local entry="${CACHE_DIR}/$1"
+    [[ -d "$entry" ]] || return 1
+
+    cp "$entry"/*.bin "$entry"/*.hex "$QMK_DIR"/ 2>/dev/null || true
+    if compgen -G "$entry/*.map" > /dev/null; then
+        mkdir -p "${QMK_DIR}/.build"
+        cp "$entry"/*.map "${QMK_DIR}/.build/"
+    fi
+    touch "$entry"
+    log_info "Restored $(basename "$(artifact)") from cache ($1)"
+}
+
+store_cached() {
+    local entry="${CACHE_DIR}/$1"
+    local map="${QMK_DIR}/.build/$(make_target | tr / _)_${KEYMAP}.map"
+
+    rm -rf "$entry" "${entry}.tmp"
+    mkdir -p "${entry}.tmp"
+    cp "$(artifact)" "${entry}.tmp/"
+    [[ -f "$map" ]] && cp "$map" "${entry}.tmp/"
+    mv "${entry}.tmp" "$entry"
+
+    # Keep the most recently built or restored entries only.
+    ls -1t "$CACHE_DIR" | tail -n +"$((CACHE_KEEP + 1))" |
+        while read -r old; do rm -rf "${CACHE_DIR:?}/${old}"; done
+}
+
+# The firmware file make writes for the target, if any.
+artifact() {
+    local name
+    name="$(make_target | tr / _)_${KEYMAP}"
+    find "$QMK_DIR" -maxdepth 1 -type f \
+        \( -name "${name}.bin" -o -name "${name}.hex" \) | head -n 1
+}
+
+##############################################################################
+# 3. TOOLCHAIN - Docker images with QMK's dependencies installed
+##############################################################################
+has_image() {
+    docker image inspect "$1" > /dev/null 2>&1
+}
+
+# The Dockerfile's image with `qmk doctor` run once, which installs the ARM
+# toolchain. The workflow reinstalls that in every build.
+toolchain_image() {
+    local hash base image container
+    hash="$(toolchain_hash)"
+    base="qmk:$(sha256sum < "${ROOT}/Dockerfile" | cut -c1-12)"
+    image="qmk-toolchain:${hash}"
+
+    if has_image "$image"; then
+        echo "$image"
+        return 0
+    fi
+    if ! has_image "$base"; then
+        docker build -t "$base" "$ROOT" >&2
+    fi
+
+    container="qmk-toolchain-${hash}-$$"
+    docker run --name "$container" -v "${QMK_DIR}:/qmk_firmware" \
+        -w /qmk_firmware -e QMK_HOME=/qmk_firmware "$base" \
+        sh -c 'qmk doctor -y; arm-none-eabi-gcc --version' >&2 || {
+        docker rm "$container" > /dev/null
+        log_error "Installing the QMK toolchain failed" >&2
+        exit 1
+    }
+    docker commit "$container" "$image" > /dev/null
+    docker rm "$container" > /dev/null
+    echo "$image"
+}
+
+##############################################################################
+# 4. BUILD - Compile the keymap in the toolchain image
+##############################################################################
+build() {
+    local target keyboard_dir image
+    target="$(make_target)"
+    keyboard_dir="${QMK_DIR}/keyboards/${target}"
+
+    # Copy the keymap keeping modification times, so that make leaves the
+    # objects of unchanged files alone.
+    rm -rf "${keyboard_dir}/keymaps/${KEYMAP}"
+    mkdir -p "${keyboard_dir}/keymaps"
+    cp -a "${ROOT}/${KEYMAP}" "${keyboard_dir}/keymaps/"
+
+    image="$(toolchain_image)"
+    rm -f "$(artifact)"
+    docker run --rm -v "${QMK_DIR}:/qmk_firmware" -w /qmk_firmware \
+        -e QMK_HOME=/qmk_firmware "$image" sh -c "
+            make -j$(nproc) ${target}:${KEYMAP} && status=0 || status=\$?
+            chown -R $(id -u):$(id -g) .build ${target//\//_}_${KEYMAP}.* \
+                2>/dev/null
+            exit \$status
+        "
+
+    if [[ -z "$(artifact)" ]]; then
+        log_error "make did not produce a firmware file"
+        exit 1
+    fi
+}
+
+##############################################################################
+# Main execution
+##############################################################################
+main() {
+    parse_args "$@"
+
+    if [[ ! -f "${QMK_DIR}/Makefile" ]]; then
+        log_error "qmk_firmware is empty"
+        log_error "Run: git submodule update --init --recursive"
+        exit 1
+    fi
+    if [[ ! -d "${ROOT}/${KEYMAP}" ]]; then
+        log_error "Keymap directory not found: ${KEYMAP}"
+        exit 1
+    fi
+
+    local hash
+    hash="$(input_hash)"
+    if [[ "$PRINT_HASH" -eq 1 ]]; then
+        echo "$hash"
+        return 0
+    fi
+
+    if [[ "$USE_CACHE" -eq 1 ]] && restore_cached "$hash"; then
+        return 0
+    fi
+
+    build
+    store_cached "$hash"
+    log_info "Built $(basename "$(artifact)") ($hash)"
+}
+
+main "$@"
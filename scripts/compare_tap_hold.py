@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""Compares tap-hold policies by replaying a trace through the host simulator.
+
+Runs sim/build/sim_replay once with Achordion and once with QMK core Chordal
+Hold and Flow Tap (see sim/sim.h), then reports where the typed text differs,
+misfires against the trace's intents, latency per key class and the CPU cost
+per event. With --overlap, the second run is Achordion settling at the other
+key's release (ACHORDION_OVERLAP) with that threshold instead of core.
+
+Usage:
+    make -C sim
+    scripts/compare_tap_hold.py [--sim sim/build/sim_replay]
+                                [--flow-tap-term MS] [--no-chordal-hold]
+                                [--overlap PERCENT] [--context 5] [--json]
+                                TRACE
+"""
+
+import argparse
+from difflib import SequenceMatcher
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+POLICIES = ["achordion", "core"]
+LATENCY_CLASSES = ["plain", "mod_tap", "layer_tap", "tap_dance"]
+DEFAULT_SIM = os.path.join(
+    os.path.dirname(os.path.abspath(__file__)), "..", "sim", "build", "sim_replay"
+)
+
+
+def replay(args, policy, strokes_path):
+    cmd = [args.sim, "--strokes", strokes_path]
+    if policy == "overlap":
+        cmd += ["--policy", "achordion", "--overlap", str(args.overlap)]
+    else:
+        cmd += ["--policy", policy]
+    if args.flow_tap_term is not None:
+        cmd += ["--flow-tap-term", str(args.flow_tap_term)]
+    if args.no_chordal_hold:
+        cmd.append("--no-chordal-hold")
+    cmd.append(args.trace)
+    result = subprocess.run(cmd, capture_output=True, text=True)
+    if result.returncode != 0:
+        sys.exit(f"{' '.join(cmd)} failed:\n{result.stderr}")
+    with open(strokes_path) as f:
+        strokes = [line.rstrip("\n").split(" ", 1) for line in f]
+    return json.loads(result.stdout), [(int(t), s) for t, s in strokes]
+
+
+def first_difference(a, b):
+    """Index of the first stroke the two runs type differently, or None."""
+    for i, (x, y) in enumerate(zip(a, b)):
+        if x[1] != y[1]:
+            return i
+    return None if len(a) == len(b) else min(len(a), len(b))
+
+
+def count_differences(a, b):
+    """Strokes typed by only one of the runs, ignoring timing."""
+    matcher = SequenceMatcher(None, [s for _, s in a], [s for _, s in b],
+                              autojunk=False)
+    same = sum(block.size for block in matcher.get_matching_blocks())
+    return len(a) - same, len(b) - same
+
+
+def print_report(args, results):
+    stats = {p: results[p][0] for p in POLICIES}
+    print(f"{'':<22}" + "".join(f"{p:>12}" for p in POLICIES))
+    for field in ["strokes", "reports", "false_taps", "false_holds",
+                  "misfires", "max_depth", "stuck_keys", "max_holdback_ms"]:
+        print(f"{field:<22}" + "".join(f"{stats[p][field]:>12}" for p in POLICIES))
+    print(f"{'cpu ns/event':<22}"
+          + "".join(f"{stats[p]['cpu_ns_per_event']:>12.1f}" for p in POLICIES))
+    if stats[POLICIES[0]]["intended"]:
+        print(f"(misfires out of {stats[POLICIES[0]]['intended']} tap-hold "
+              "presses with an intent)")
+
+    print("\nlatency ms, press to effect (mean / p50 / p90 / p99 / max)")
+    for cls in LATENCY_CLASSES:
+        if not any(stats[p]["latency"][cls]["count"] for p in POLICIES):
+            continue
+        print(f"  {cls}")
+        for p in POLICIES:
+            l = stats[p]["latency"][cls]
+            print(f"    {p:<12}{l['count']:>8}  {l['mean_ms']:8.1f} "
+                  f"{l['p50_ms']:6} {l['p90_ms']:6} {l['p99_ms']:6} "
+                  f"{l['max_ms']:6}")
+
+    a, b = results[POLICIES[0]][1], results[POLICIES[1]][1]
+    only_a, only_b = count_differences(a, b)
+    print(f"\nstrokes only under {POLICIES[0]}: {only_a}, "
+          f"only under {POLICIES[1]}: {only_b}")
+    i = first_difference(a, b)
+    if i is not None:
+        lo, hi = max(0, i - args.context), i + args.context + 1
+        print(f"first difference at stroke {i}:")
+        for p, strokes in zip(POLICIES, (a, b)):
+            text = " ".join(s for _, s in strokes[lo:hi])
+            time = strokes[i][0] if i < len(strokes) else "end"
+            print(f"  {p:<12}@{time}: {text}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("trace")
+    parser.add_argument("--sim", default=DEFAULT_SIM)
+    parser.add_argument("--flow-tap-term", type=int)
+    parser.add_argument("--no-chordal-hold", action="store_true")
+    parser.add_argument("--overlap", type=int, metavar="PERCENT",
+                        help="compare with Achordion's overlap policy "
+                        "instead of core")
+    parser.add_argument("--context", type=int, default=5,
+                        help="strokes shown around the first difference")
+    parser.add_argument("--json", action="store_true",
+                        help="print both runs' statistics as JSON")
+    args = parser.parse_args()
+    if args.overlap is not None:
+        POLICIES[1] = "overlap"
+
+    if not os.path.exists(args.sim):
+        sys.exit(f"{args.sim} not found; run `make -C sim` first")
+
+    results = {}
+    with tempfile.TemporaryDirectory() as tmp:
+        for policy in POLICIES:
+            results[policy] = replay(args, policy,
+                                     os.path.join(tmp, f"{policy}.strokes"))
+
+    if args.json:
+        json.dump({p: results[p][0] for p in POLICIES}, sys.stdout, indent=2)
+        print()
+    else:
+        print_report(args, results)
+
+
+if __name__ == "__main__":
+    main()
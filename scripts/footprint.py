@@ -0,0 +1,242 @@
+#!/usr/bin/env python3
+"""Reports the flash and static RAM each keymap module takes in a firmware build.
+
+Reads the linker map QMK writes next to the firmware (.build/<target>.map)
+and sums the input sections the link kept per object file: code and
+constants count as flash, initialized data as both flash and RAM, and zeroed
+data as RAM. Objects from eZrPW/features/ are listed one per module, keymap.c
+(which QMK compiles through quantum/keymap_introspection.c) as "keymap.c",
+and everything else together. The totals per memory region, including the
+stacks the linker script reserves, show how much budget is left.
+
+Builds with LTO_ENABLE = yes merge objects before the link, so the map can no
+longer tell modules apart; build with LTO off to get the breakdown.
+
+With --symbols, each module's functions and variables are listed too, from
+the per-symbol sections QMK compiles with (-ffunction-sections and
+-fdata-sections).
+
+Usage:
+    scripts/footprint.py [--keymap eZrPW] [--symbols] [MAPFILE]
+"""
+
+import argparse
+from collections import defaultdict
+import glob
+import os
+import re
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+# An input or output section with its address and size, possibly after a
+# name on the line before.
+SECTION_RE = re.compile(
+    r"^(?P<indent> ?)(?P<name>[.\w*][^\s]*)?\s+0x(?P<addr>[0-9a-f]+)\s+"
+    r"0x(?P<size>[0-9a-f]+)(?:\s+(?P<rest>.*))?$")
+NAME_RE = re.compile(r"^(?P<indent> ?)(?P<name>[.\w][^\s]*)$")
+REGION_RE = re.compile(
+    r"^(?P<name>\S+)\s+0x(?P<origin>[0-9a-f]+)\s+0x(?P<length>[0-9a-f]+)"
+    r"(?:\s+(?P<attrs>\S+))?$")
+LOAD_RE = re.compile(r"load address 0x([0-9a-f]+)")
+SYMBOL_SECTION_RE = re.compile(r"^\.(?:text|rodata|data|bss|ramfunc)\.(.+)$")
+REST = "(QMK, ChibiOS and libraries)"
+
+
+class Region:
+    def __init__(self, name, origin, length, attrs):
+        self.name = name
+        self.origin = origin
+        self.length = length
+        self.flash = "w" not in attrs or name.startswith("flash")
+        self.used = 0
+
+    def __contains__(self, addr):
+        return self.origin <= addr < self.origin + self.length
+
+
+def parse_map(path):
+    """Returns the memory regions, the output sections and the input sections.
+
+    Output sections are (name, addr, size, load_addr or None), input sections
+    (output section, input section, addr, size, object).
+    """
+    regions, outputs, inputs = [], [], []
+    part = None
+    output = None
+    pending = None  # Name on a line of its own, waiting for its numbers.
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if line.startswith("Memory Configuration"):
+                part = "memory"
+                continue
+            if line.startswith("Linker script and memory map"):
+                part = "map"
+                continue
+            if part == "memory":
+                m = REGION_RE.match(line)
+                if m and m["name"] != "Name" and m["name"] != "*default*":
+                    regions.append(Region(m["name"], int(m["origin"], 16),
+                                          int(m["length"], 16),
+                                          m["attrs"] or ""))
+                continue
+            if part != "map":
+                continue
+
+            m = NAME_RE.match(line)
+            if m:
+                pending = (m["indent"], m["name"])
+                continue
+            m = SECTION_RE.match(line)
+            if not m:
+                pending = None
+                continue
+            indent, name = m["indent"], m["name"]
+            if name is None:
+                if pending is None:
+                    continue  # A symbol or fill inside a section.
+                indent, name = pending
+            pending = None
+            addr, size = int(m["addr"], 16), int(m["size"], 16)
+            if not indent:
+                load = LOAD_RE.search(m["rest"] or "")
+                output = name
+                outputs.append((name, addr, size,
+                                int(load.group(1), 16) if load else None))
+            elif output != "/DISCARD/" and name != "*fill*" and m["rest"]:
+                inputs.append((output, name, addr, size, m["rest"].strip()))
+    return regions, outputs, inputs
+
+
+def module_of(obj, keymap):
+    """Groups an object file path as a keymap module or the rest."""
+    path = obj.replace("\\", "/")
+    marker = f"/keymaps/{keymap}/"
+    if marker in path:
+        rel = path.split(marker, 1)[1]
+        return re.sub(r"\.o$", ".c", rel)
+    if path.endswith("/keymap_introspection.o"):
+        return "keymap.c"
+    return None
+
+
+def region_of(regions, addr):
+    for region in regions:
+        if addr in region:
+            return region
+    return None
+
+
+def sized_sections(regions, inputs, keymap):
+    """Yields (module, section, [flash, data, bss]) per kept input section."""
+    for _, section, addr, size, obj in inputs:
+        region = region_of(regions, addr)
+        if region is None or not size:
+            continue
+        module = module_of(obj, keymap) or REST
+        if region.flash:
+            yield module, section, [size, 0, 0]
+        elif section.startswith(".data") or section.startswith(".ramfunc"):
+            yield module, section, [size, size, 0]
+        else:
+            yield module, section, [0, 0, size]
+
+
+def symbol_of(section):
+    """The function or variable of a -ffunction-sections/-fdata-sections
+    input section, such as process_achordion for .text.process_achordion."""
+    m = SYMBOL_SECTION_RE.match(section)
+    return m.group(1) if m else section
+
+
+def symbol_sizes(regions, inputs, keymap):
+    """Returns {module: {symbol: [flash, data, bss]}} for the keymap modules."""
+    symbols = defaultdict(lambda: defaultdict(lambda: [0, 0, 0]))
+    for module, section, sizes in sized_sections(regions, inputs, keymap):
+        if module == REST:
+            continue
+        entry = symbols[module][symbol_of(section)]
+        for i in range(3):
+            entry[i] += sizes[i]
+    return symbols
+
+
+def newest_map():
+    maps = glob.glob(os.path.join(ROOT, "qmk_firmware", ".build", "*.map"))
+    return max(maps, key=os.path.getmtime) if maps else None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("map", nargs="?", help="linker map (default: newest "
+                        "qmk_firmware/.build/*.map)")
+    parser.add_argument("--keymap", default="eZrPW")
+    parser.add_argument("--symbols", action="store_true",
+                        help="also list each keymap module's functions and "
+                        "variables")
+    args = parser.parse_args()
+
+    path = args.map or newest_map()
+    if path is None:
+        sys.exit("no map file found; build the firmware first or pass one")
+
+    regions, outputs, inputs = parse_map(path)
+    if not outputs:
+        sys.exit(f"{path}: no memory map found")
+
+    # flash, data, bss bytes per module.
+    modules = defaultdict(lambda: [0, 0, 0])
+    for module, _, sizes in sized_sections(regions, inputs, args.keymap):
+        for i in range(3):
+            modules[module][i] += sizes[i]
+
+    stacks = []
+    for name, addr, size, load in outputs:
+        region = region_of(regions, addr)
+        if region is not None:
+            region.used += size
+        if load is not None and load != addr:
+            load_region = region_of(regions, load)
+            if load_region is not None:
+                load_region.used += size
+        if name in (".mstack", ".pstack"):
+            stacks.append((name, size))
+
+    print(f"{path}\n")
+    row = "{:<32}{:>9}{:>9}{:>9}{:>9}"
+    print(row.format("module", "flash", "data", "bss", "RAM"))
+    keymap_modules = sorted(m for m in modules if m != REST)
+    total = [sum(modules[m][i] for m in keymap_modules) for i in range(3)]
+    for module in keymap_modules:
+        flash, data, bss = modules[module]
+        print(row.format(module, flash, data, bss, data + bss))
+    if keymap_modules:
+        print(row.format("  all keymap modules", total[0], total[1], total[2],
+                         total[1] + total[2]))
+    else:
+        print(f"no objects from keymaps/{args.keymap}/ in the map; "
+              "was the build made with LTO_ENABLE = yes?")
+    flash, data, bss = modules[REST]
+    print(row.format(REST, flash, data, bss, data + bss))
+
+    if args.symbols:
+        symbols_per_module = symbol_sizes(regions, inputs, args.keymap)
+        for module, symbols in sorted(symbols_per_module.items()):
+            print(f"\n{module}")
+            for symbol, (flash, data, bss) in sorted(
+                    symbols.items(), key=lambda item: -sum(item[1])):
+                print(row.format("  " + symbol, flash, data, bss, data + bss))
+
+    print(f"\n{'region':<12}{'used':>9}{'size':>9}{'free':>9}")
+    for region in regions:
+        if region.length and region.used:
+            print(f"{region.name:<12}{region.used:>9}{region.length:>9}"
+                  f"{region.length - region.used:>9}")
+    for name, size in stacks:
+        label = {".mstack": "exception stack", ".pstack": "main loop stack"}
+        print(f"  of which {label[name]}: {size} bytes")
+
+
+if __name__ == "__main__":
+    main()
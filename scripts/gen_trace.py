@@ -0,0 +1,468 @@
+#!/usr/bin/env python3
+"""Generates timed key event traces from plain text for the host simulator.
+
+Each character of the input is typed on the eZrPW layout, read from
+eZrPW/keymap.c: letters and symbols on the base layer, uppercase through the
+home-row Shift mod-taps, and the rest through the layer-tap thumb keys that
+reach them. Shortcuts (Ctrl/Alt/GUI + letter) held on home-row mods are
+injected at word boundaries. Timing follows a simple typist model:
+
+  * log-normal inter-key intervals, scaled by bigram class (same finger,
+    same-hand roll, hand alternation) and lengthened after words, sentences
+    and lines, with occasional long pauses;
+  * log-normal key hold durations, with rolls overlapping the next press;
+  * mod and layer keys pressed a lead time before the key they modify and
+    released a little after it.
+
+Tap-hold presses are annotated with the intended tap (t) or hold (h), so the
+simulator can count misfires. The output is a text trace (sim/trace.h) or, for
+--binary or a .ktr output, the binary format of
+eZrPW/features/key_trace_format.h. With the same --seed and inputs, the output
+is identical.
+
+Usage:
+    scripts/gen_trace.py [options] [CORPUS ...] > trace.txt
+    scripts/gen_trace.py --repeat 50 README.md eZrPW/keymap.c -o big.ktr
+"""
+
+import argparse
+import heapq
+import math
+import os
+import random
+import re
+import struct
+import sys
+
+KEYMAP = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..",
+                      "eZrPW", "keymap.c")
+
+# LAYOUT_voyager argument index to matrix (row, col), as in sim/qmk/quantum.h.
+def layout_position(i):
+    if i < 48:
+        row, col = divmod(i, 12)
+        return (row, col + 1) if col < 6 else (row + 6, col - 6)
+    return [(4, 0), (4, 1), (10, 5), (10, 6)][i - 48]
+
+
+def layout_finger(i):
+    """Hand (0 left, 1 right) and finger (0 pinky .. 3 index, 4 thumb)."""
+    if i >= 48:
+        return (0 if i < 50 else 1, 4)
+    col = i % 12
+    if col < 6:
+        return (0, [0, 0, 1, 2, 3, 3][col])
+    return (1, [3, 3, 2, 1, 0, 0][col - 6])
+
+
+# Characters of the US layout's basic keycodes, unshifted and shifted.
+BASIC_CHARS = {f"KC_{c.upper()}": (c, c.upper()) for c in
+               "abcdefghijklmnopqrstuvwxyz"}
+BASIC_CHARS.update({f"KC_{d}": (d, s) for d, s in zip("1234567890",
+                                                      "!@#$%^&*()")})
+BASIC_CHARS.update({
+    "KC_MINUS": ("-", "_"), "KC_EQUAL": ("=", "+"), "KC_LBRC": ("[", "{"),
+    "KC_RBRC": ("]", "}"), "KC_BSLS": ("\\", "|"), "KC_SCLN": (";", ":"),
+    "KC_QUOTE": ("'", '"'), "KC_QUOT": ("'", '"'), "KC_GRAVE": ("`", "~"),
+    "KC_GRV": ("`", "~"), "KC_COMMA": (",", "<"), "KC_COMM": (",", "<"),
+    "KC_DOT": (".", ">"), "KC_SLASH": ("/", "?"), "KC_SLSH": ("/", "?"),
+    "KC_SPACE": (" ", None), "KC_SPC": (" ", None), "KC_ENTER": ("\n", None),
+    "KC_ENT": ("\n", None), "KC_TAB": ("\t", None),
+})
+SHIFTED_ALIASES = {
+    "KC_EXLM": "1", "KC_AT": "2", "KC_HASH": "3", "KC_DLR": "4",
+    "KC_PERC": "5", "KC_CIRC": "6", "KC_AMPR": "7", "KC_ASTR": "8",
+    "KC_LPRN": "9", "KC_RPRN": "0", "KC_UNDS": "MINUS", "KC_PLUS": "EQUAL",
+    "KC_LCBR": "LBRC", "KC_RCBR": "RBRC", "KC_PIPE": "BSLS", "KC_COLN": "SCLN",
+    "KC_DQUO": "QUOTE", "KC_TILD": "GRAVE", "KC_QUES": "SLASH",
+    "KC_LABK": "COMMA", "KC_RABK": "DOT",
+}
+MODS = {"LCTL": "ctrl", "RCTL": "ctrl", "LSFT": "shift", "RSFT": "shift",
+        "LALT": "alt", "RALT": "alt", "LGUI": "gui", "RGUI": "gui"}
+
+
+def split_args(text):
+    """Splits a macro argument list at top-level commas."""
+    args, depth, start = [], 0, 0
+    for i, c in enumerate(text):
+        if c == "(":
+            depth += 1
+        elif c == ")":
+            depth -= 1
+        elif c == "," and depth == 0:
+            args.append(text[start:i].strip())
+            start = i + 1
+    args.append(text[start:].strip())
+    return [a for a in args if a]
+
+
+def parse_keymap(path):
+    """Returns {layer: [keycode text per LAYOUT index]}."""
+    with open(path) as f:
+        source = f.read()
+    layers = {}
+    for match in re.finditer(r"\[(\d+)\]\s*=\s*LAYOUT_voyager\(", source):
+        depth, i = 1, match.end()
+        while depth:
+            depth += {"(": 1, ")": -1}.get(source[i], 0)
+            i += 1
+        layers[int(match.group(1))] = split_args(source[match.end():i - 1])
+    return layers
+
+
+class Key:
+    def __init__(self, index, keycode):
+        self.index = index
+        self.pos = layout_position(index)
+        self.hand, self.finger = layout_finger(index)
+        self.tap_hold = keycode.startswith(("MT(", "LT(", "ALL_T("))
+
+
+class Layout:
+    """Ways to type each character, and the keys holding mods and layers."""
+
+    def __init__(self, layers):
+        self.strokes = {}  # char -> [(cost, key, layer key, needs shift)]
+        self.mods = {}  # mod name -> [Key]
+        self.layer_keys = {}  # layer -> Key
+        for i, keycode in enumerate(layers.get(0, [])):
+            m = re.match(r"LT\((\d+),", keycode)
+            if m:
+                self.layer_keys[int(m.group(1))] = Key(i, keycode)
+            m = re.match(r"MT\(MOD_(\w+),", keycode)
+            if m and m.group(1) in MODS:
+                self.mods.setdefault(MODS[m.group(1)], []).append(
+                    Key(i, keycode))
+        for layer, keycodes in sorted(layers.items()):
+            if layer and layer not in self.layer_keys:
+                continue
+            for i, keycode in enumerate(keycodes):
+                self._add(layer, i, keycode)
+        for options in self.strokes.values():
+            options.sort(key=lambda o: o[0])
+
+    def _add(self, layer, index, keycode):
+        tap = keycode
+        m = re.match(r"(?:MT\(\w+,|LT\(\d+,|ALL_T\()\s*(\w+)\)", keycode)
+        if m:
+            tap = m.group(1)
+        shifted = False
+        m = re.match(r"(?:S|LSFT)\((\w+)\)", tap)
+        if m:
+            tap, shifted = m.group(1), True
+        if tap in SHIFTED_ALIASES:
+            tap, shifted = "KC_" + SHIFTED_ALIASES[tap], True
+        if tap not in BASIC_CHARS:
+            return
+        key = Key(index, keycode)
+        layer_key = self.layer_keys.get(layer) if layer else None
+        plain, shift = BASIC_CHARS[tap]
+        if shifted:
+            self._option(shift, 2 * bool(layer), key, layer_key, False)
+        else:
+            self._option(plain, 2 * bool(layer), key, layer_key, False)
+            if shift and "shift" in self.mods:
+                self._option(shift, 2 * bool(layer) + 1, key, layer_key, True)
+
+    def _option(self, char, cost, key, layer_key, needs_shift):
+        if char is not None:
+            self.strokes.setdefault(char, []).append(
+                (cost, key, layer_key, needs_shift))
+
+    def stroke(self, char):
+        options = self.strokes.get(char)
+        return options[0] if options else None
+
+    def mod_key(self, mod, other_hand_of, rng, same_hand_rate):
+        """A key holding `mod`, on the other hand unless chosen otherwise."""
+        keys = self.mods.get(mod, [])
+        if not keys:
+            return None
+        same = rng.random() < same_hand_rate
+        keys = [k for k in keys if k.pos != other_hand_of.pos]
+        preferred = [k for k in keys
+                     if (k.hand == other_hand_of.hand) == same]
+        return (preferred or keys or [None])[0]
+
+
+# Binary trace format, see eZrPW/features/key_trace_format.h.
+KEY_TRACE_MAGIC = b"KTRC"
+KEY_TRACE_VERSION = 1
+KEY_TRACE_RECORD_SIZE = 4
+KEY_TRACE_NO_KEY = 0xFF
+KEY_TRACE_INTENTS = {None: 0, "t": 1, "h": 2}
+
+
+def key_trace_header(start, count):
+    return KEY_TRACE_MAGIC + struct.pack("<HHII", KEY_TRACE_VERSION,
+                                         KEY_TRACE_RECORD_SIZE, start, count)
+
+
+class TraceWriter:
+    """Buffers events in time order and writes them once no earlier event can
+    follow, as text or in the binary trace format."""
+
+    def __init__(self, out, binary=False):
+        self.out = out
+        self.binary = binary
+        self.heap = []
+        self.seq = 0
+        self.count = 0
+        self.released = {}  # pos -> release time of its latest press
+        self.last_time = None
+
+    def key(self, key, press, release, intent=None):
+        press, release = round(press), round(release)
+        # A key cannot be pressed again before its previous release.
+        press = max(press, self.released.get(key.pos, -1) + 1)
+        release = max(release, press + 1)
+        self.released[key.pos] = release
+        intent = intent if key.tap_hold else None
+        # Releases sort before presses at the same time.
+        self._push(press, 1, (key.pos, 1, intent))
+        self._push(release, 0, (key.pos, 0, None))
+        return press, release
+
+    def _push(self, time, order, event):
+        heapq.heappush(self.heap, (time, order, self.seq, event))
+        self.seq += 1
+
+    def _write(self, time, pos, pressed, intent):
+        if not self.binary:
+            suffix = f" {intent}" if intent else ""
+            self.out.write(f"{time} {pos[0]} {pos[1]} {pressed}{suffix}\n")
+            return
+        if self.last_time is None:
+            self.out.write(key_trace_header(time, 0))
+            self.start = self.last_time = time
+        delta = time - self.last_time
+        while delta > 0xFFFF:
+            self.out.write(struct.pack("<HBB", 0xFFFF, KEY_TRACE_NO_KEY, 0))
+            delta -= 0xFFFF
+        flags = pressed | KEY_TRACE_INTENTS[intent] << 1
+        self.out.write(struct.pack("<HBB", delta, pos[0] << 4 | pos[1], flags))
+        self.last_time = time
+
+    def flush(self, before=math.inf):
+        while self.heap and self.heap[0][0] < before:
+            time, _, _, event = heapq.heappop(self.heap)
+            self._write(time, *event)
+            self.count += 1
+
+    def close(self):
+        """Flushes all events, filling in the binary header's record count
+        when the output can seek."""
+        self.flush()
+        if self.binary and self.last_time is not None and self.out.seekable():
+            records = (self.out.tell() - 16) // KEY_TRACE_RECORD_SIZE
+            self.out.seek(0)
+            self.out.write(key_trace_header(self.start, records))
+
+
+class Typist:
+    def __init__(self, args, layout, writer):
+        self.args = args
+        self.layout = layout
+        self.writer = writer
+        self.rng = random.Random(args.seed)
+        self.last_key = None
+        self.last_press = 1000.0
+        self.last_release = 0.0
+        self.skipped = {}
+
+    def lognormal(self, mean, sigma):
+        # Parameterized by the distribution's mean rather than its median.
+        return self.rng.lognormvariate(math.log(mean) - sigma * sigma / 2,
+                                       sigma)
+
+    def interval(self, key, char):
+        """Time from the previous press to the press of `key`."""
+        a = self.args
+        iki = self.lognormal(a.iki_mean, a.iki_sigma)
+        prev = self.last_key
+        roll = False
+        if prev is None:
+            pass
+        elif prev.pos == key.pos or (prev.hand == key.hand and
+                                     prev.finger == key.finger != 4):
+            iki *= a.same_finger_factor
+        elif prev.hand == key.hand:
+            roll = self.rng.random() < a.roll_rate
+            iki *= a.roll_factor if roll else 1.0
+        else:
+            iki *= a.alternate_factor
+        if self.rng.random() < a.pause_rate:
+            iki += self.rng.expovariate(1.0 / a.pause_mean)
+        return iki, roll
+
+    def press(self, key, char, layer_key=None, mods=()):
+        """Types `key`, with `mods` and `layer_key` held around it."""
+        a = self.args
+        iki, roll = self.interval(key, char)
+        t = self.last_press + iki
+        holders = list(mods) + ([layer_key] if layer_key else [])
+        lead = 0.0
+        if holders:
+            # Mods and layers go down after the previous key and after their
+            # own previous release.
+            lead = self.lognormal(a.mod_lead_mean, a.hold_sigma)
+            t = max(t, self.last_press + lead + 1, self.last_release + lead + 1)
+        hold = self.lognormal(a.hold_mean, a.hold_sigma)
+        if roll:
+            # Rolled keys stay down past the next press.
+            hold = max(hold, iki + self.lognormal(a.overlap_mean, 0.5))
+        press, release = self.writer.key(key, t, t + hold, "t")
+        end = release
+        for holder in holders:
+            tail = self.lognormal(a.mod_tail_mean, a.hold_sigma)
+            _, r = self.writer.key(holder, press - lead, release + tail, "h")
+            end = max(end, r)
+        self.last_key = key
+        self.last_press = press
+        # The next key is pressed after a modified key's holders let go.
+        self.last_release = end if holders else 0.0
+        if holders:
+            self.last_press = max(self.last_press, end - a.iki_mean / 2)
+        self.writer.flush(press - 10 * a.mod_lead_mean)
+
+    def type_char(self, char):
+        stroke = self.layout.stroke(char)
+        if stroke is None:
+            self.skipped[char] = self.skipped.get(char, 0) + 1
+            return
+        _, key, layer_key, needs_shift = stroke
+        mods = []
+        if needs_shift:
+            shift = self.layout.mod_key("shift", key, self.rng, 0.0)
+            if shift is None:
+                self.skipped[char] = self.skipped.get(char, 0) + 1
+                return
+            mods.append(shift)
+        self.press(key, char, layer_key, mods)
+        if char in ".!?\n":
+            self.last_press += self.lognormal(self.args.sentence_pause, 0.5)
+        elif char == " ":
+            self.last_press += self.lognormal(self.args.word_pause, 0.5)
+
+    def shortcut(self):
+        """Ctrl, Alt or GUI + a letter, held on a home-row mod."""
+        a = self.args
+        mod = self.rng.choice([m for m in ("ctrl", "gui", "alt")
+                               if m in self.layout.mods])
+        letter = self.rng.choice(a.shortcut_letters)
+        stroke = self.layout.stroke(letter)
+        if stroke is None:
+            return
+        key = stroke[1]
+        mod_key = self.layout.mod_key(mod, key, self.rng, a.same_hand_rate)
+        if mod_key is None:
+            return
+        self.last_press += self.lognormal(a.sentence_pause, 0.5)
+        self.press(key, letter, None, [mod_key])
+        self.last_press += self.lognormal(a.sentence_pause, 0.5)
+
+    def type_text(self, text):
+        for char in text:
+            if char == "\r":
+                continue
+            if char == " " and self.rng.random() < self.args.shortcut_rate:
+                self.shortcut()
+            self.type_char(char)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("corpus", nargs="*",
+                        help="text files to type (default: stdin)")
+    parser.add_argument("-o", "--output", help="trace file (default: stdout)")
+    parser.add_argument("--binary", action="store_true",
+                        help="write the binary trace format (default for "
+                             ".ktr outputs)")
+    parser.add_argument("--keymap", default=KEYMAP)
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--repeat", type=int, default=1,
+                        help="type the corpus this many times")
+    parser.add_argument("--max-events", type=int,
+                        help="stop after about this many events")
+    timing = parser.add_argument_group("timing model (ms)")
+    timing.add_argument("--iki-mean", type=float, default=160.0,
+                        help="mean inter-key interval")
+    timing.add_argument("--iki-sigma", type=float, default=0.45,
+                        help="log-normal sigma of intervals and pauses")
+    timing.add_argument("--same-finger-factor", type=float, default=1.5)
+    timing.add_argument("--alternate-factor", type=float, default=0.8)
+    timing.add_argument("--roll-rate", type=float, default=0.5,
+                        help="share of same-hand bigrams typed as rolls")
+    timing.add_argument("--roll-factor", type=float, default=0.55,
+                        help="interval scale of rolls")
+    timing.add_argument("--overlap-mean", type=float, default=25.0,
+                        help="mean time a roll's key stays down after the "
+                             "next press")
+    timing.add_argument("--hold-mean", type=float, default=95.0)
+    timing.add_argument("--hold-sigma", type=float, default=0.3)
+    timing.add_argument("--mod-lead-mean", type=float, default=110.0,
+                        help="mod or layer key press before the key it "
+                             "modifies")
+    timing.add_argument("--mod-tail-mean", type=float, default=40.0,
+                        help="mod or layer key release after that key")
+    timing.add_argument("--word-pause", type=float, default=30.0)
+    timing.add_argument("--sentence-pause", type=float, default=300.0)
+    timing.add_argument("--pause-rate", type=float, default=0.01,
+                        help="chance of a long pause before a key")
+    timing.add_argument("--pause-mean", type=float, default=1500.0)
+    shortcuts = parser.add_argument_group("shortcuts")
+    shortcuts.add_argument("--shortcut-rate", type=float, default=0.02,
+                           help="chance of a shortcut at a word boundary")
+    shortcuts.add_argument("--shortcut-letters", default="acvxzstfwr")
+    shortcuts.add_argument("--same-hand-rate", type=float, default=0.1,
+                           help="share of shortcuts holding the mod on the "
+                                "letter's hand")
+    args = parser.parse_args()
+
+    layout = Layout(parse_keymap(args.keymap))
+    if not layout.strokes:
+        sys.exit(f"no LAYOUT_voyager layers found in {args.keymap}")
+    corpus = []
+    for path in args.corpus or ["-"]:
+        if path == "-":
+            corpus.append(sys.stdin.read())
+        else:
+            with open(path, errors="replace") as f:
+                corpus.append(f.read())
+
+    binary = args.binary or (args.output or "").endswith(".ktr")
+    if binary:
+        out = open(args.output, "w+b") if args.output else sys.stdout.buffer
+    else:
+        out = open(args.output, "w") if args.output else sys.stdout
+        out.write(f"# gen_trace.py seed={args.seed} repeat={args.repeat} "
+                  f"iki_mean={args.iki_mean} roll_rate={args.roll_rate} "
+                  f"shortcut_rate={args.shortcut_rate}\n")
+    writer = TraceWriter(out, binary)
+    typist = Typist(args, layout, writer)
+    for _ in range(args.repeat):
+        for text in corpus:
+            for line in text.splitlines(keepends=True):
+                typist.type_text(line)
+                if args.max_events and writer.count >= args.max_events:
+                    break
+            else:
+                continue
+            break
+        if args.max_events and writer.count >= args.max_events:
+            break
+    writer.close()
+
+    skipped = sum(typist.skipped.values())
+    print(f"{writer.count} events", file=sys.stderr, end="")
+    if skipped:
+        chars = "".join(sorted(typist.skipped))
+        print(f", {skipped} characters not on the layout: {chars!r}",
+              file=sys.stderr, end="")
+    print(file=sys.stderr)
+    if args.output:
+        out.close()
+
+
+if __name__ == "__main__":
+    main()
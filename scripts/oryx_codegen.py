@@ -0,0 +1,358 @@
+#!/usr/bin/env python3
+"""Compiles the tables of an Oryx export into eZrPW/oryx_tables.{c,h}.
+
+Oryx writes its layout as C that is simple to generate but not to run: the
+LED colors as an HSV triple per LED per layer, mostly black, and every tap
+dance as three functions that differ only in their keycodes. This reads an
+Oryx export (the source zip Oryx offers for download, its unpacked
+directory, or its keymap.c) and writes instead:
+
+  * the ledmap as a palette of the distinct colors and a byte per LED
+    indexing it, read by features/layer_lighting.c, which converts each
+    palette color once per brightness rather than each LED;
+  * a table of each dance's keycodes, run by the three shared callbacks of
+    features/oryx_dance.c;
+  * the hand of each key position for Achordion's chord rule (see
+    `achordion_chord()` in custom_keymap.c), from the half of the layout it is on
+    unless --hand says otherwise, e.g. --hand 48=* for the left outer thumb
+    key to chord with either hand.
+
+With --strip KEYMAP, the ledmap, the code showing it and the dance code the
+tables replace are also removed from KEYMAP, the keymap.c the firmware
+builds, where merging an Oryx export puts them back.
+scripts/apply-custom-qmk.sh runs both steps on each merge, reading the export
+from the oryx branch, with the options in its ORYX_CODEGEN_ARGS.
+
+Dances whose steps do more than send a keycode (Oryx also writes layer
+switches there) can't be expressed as a table; then all dances stay as Oryx
+wrote them and no dance table is generated.
+
+Usage:
+    scripts/oryx_codegen.py [SOURCE] [-o DIR] [--strip KEYMAP]
+                            [--hand POS=L|R|* ...]
+    git show oryx:eZrPW/keymap.c | scripts/oryx_codegen.py - --strip \\
+        eZrPW/keymap.c
+"""
+
+import argparse
+import io
+import os
+import re
+import sys
+import zipfile
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+LED_COUNT = 52
+LAYOUT_KEYS = 52
+
+LEDMAP_RE = re.compile(
+    r"^const uint8_t PROGMEM ledmap\[\]\[RGB_MATRIX_LED_COUNT\]\[3\] = \{\n"
+    r"(?P<body>.*?)^\};\n\n?", re.M | re.S)
+LEDMAP_LAYER_RE = re.compile(r"\[(\d+)\]\s*=\s*\{(.*?)\}\s*,?\s*(?=\[|$)",
+                             re.S)
+HSV_RE = re.compile(r"\{\s*(\d+)\s*,\s*(\d+)\s*,\s*(\d+)\s*\}")
+# Oryx's code showing the ledmap, which custom_keymap.c replaces with
+# features/layer_lighting.c: its declaration of the RGB Matrix config and
+# its functions, each ending at the first closing brace in column 0.
+LED_CODE_RE = re.compile(
+    r"^extern rgb_config_t rgb_matrix_config;\n\n?|"
+    r"^\w+ (?:hsv_to_rgb_with_value|set_layer_color|rgb_matrix_indicators_user)"
+    r"\([^)]*\) \{\n.*?^\}\n\n?", re.M | re.S)
+# From Oryx's tap state type to the end of tap_dance_actions[].
+DANCE_BLOCK_RE = re.compile(
+    r"^typedef struct \{\n\s*bool is_press_action;.*?"
+    r"^tap_dance_action_t tap_dance_actions\[\] = \{.*?^\};\n\n?",
+    re.M | re.S)
+DANCE_ENUM_RE = re.compile(r"enum tap_dance_codes \{(.*?)\};", re.S)
+FUNCTION_RE = r"^void {name}\(tap_dance_state_t \*state, void \*user_data\) " \
+    r"\{{\n(?P<body>.*?)^\}}"
+CASE_RE = re.compile(r"case (\w+):(.*?)(?=case \w+:|\Z)", re.S)
+STEPS = ["SINGLE_TAP", "SINGLE_HOLD", "DOUBLE_TAP", "DOUBLE_HOLD",
+         "DOUBLE_SINGLE_TAP"]
+# What Oryx's dance_N_finished() does for each step, with X its keycode.
+STEP_CALLS = {
+    "SINGLE_TAP": ["register_code16"],
+    "SINGLE_HOLD": ["register_code16"],
+    "DOUBLE_TAP": ["register_code16", "register_code16"],
+    "DOUBLE_HOLD": ["register_code16"],
+    "DOUBLE_SINGLE_TAP": ["tap_code16", "register_code16"],
+}
+
+
+class Unsupported(Exception):
+    pass
+
+
+def read_source(path):
+    """keymap.c of an Oryx export: a zip, a directory or the file itself."""
+    if path == "-":
+        return sys.stdin.read()
+    if os.path.isdir(path):
+        path = os.path.join(path, "keymap.c")
+    elif zipfile.is_zipfile(path):
+        with zipfile.ZipFile(path) as z:
+            names = [n for n in z.namelist()
+                     if os.path.basename(n) == "keymap.c"]
+            if len(names) != 1:
+                sys.exit(f"{path}: expected one keymap.c, found {len(names)}")
+            return io.TextIOWrapper(z.open(names[0]), encoding="utf-8").read()
+    with open(path) as f:
+        return f.read()
+
+
+def parse_ledmap(source):
+    """Layers of 52 HSV triples, indexed by layer; None if there is none."""
+    m = LEDMAP_RE.search(source)
+    if not m:
+        return None
+    layers = {}
+    for layer in LEDMAP_LAYER_RE.finditer(m.group("body")):
+        colors = [tuple(int(v) for v in c)
+                  for c in HSV_RE.findall(layer.group(2))]
+        if len(colors) != LED_COUNT:
+            sys.exit(f"ledmap layer {layer.group(1)}: {len(colors)} colors, "
+                     f"expected {LED_COUNT}")
+        layers[int(layer.group(1))] = colors
+    return layers
+
+
+def calls(statements):
+    """(function, argument) of each call statement, profiler scopes aside."""
+    result = []
+    for statement in statements.split(";"):
+        statement = statement.replace("}", " ").strip()
+        if not statement or statement == "break" or \
+                statement.startswith("PROFILE_"):
+            continue
+        m = re.fullmatch(r"(\w+)\((.*)\)", statement, re.S)
+        if not m:
+            raise Unsupported(f"statement {statement!r}")
+        result.append((m.group(1), m.group(2).strip()))
+    return result
+
+
+def function_body(source, name):
+    m = re.search(FUNCTION_RE.format(name=name), source, re.M | re.S)
+    if not m:
+        raise Unsupported(f"no {name}()")
+    return m.group("body")
+
+
+def parse_dance(source, index):
+    """Keycodes of dance `index`: one per step, and the multi-tap keycode."""
+    steps = ["KC_NO"] * len(STEPS)
+    finished = function_body(source, f"dance_{index}_finished")
+    switch = finished[finished.index("switch"):]
+    for case in CASE_RE.finditer(switch):
+        step, body = case.group(1), case.group(2).rstrip().rstrip("}")
+        if step not in STEP_CALLS:
+            raise Unsupported(f"dance {index}: step {step}")
+        made = calls(body)
+        keycodes = {arg for _, arg in made}
+        if [f for f, _ in made] != STEP_CALLS[step] or len(keycodes) != 1:
+            raise Unsupported(f"dance {index}: {step} does {body.strip()!r}")
+        steps[STEPS.index(step)] = keycodes.pop()
+
+    # on_dance_N(): nothing, or Oryx's "tap multiple" of one keycode.
+    each = calls(re.sub(r"if\s*\(state->count [=>]+ 3\)\s*\{", "",
+                        function_body(source, f"on_dance_{index}")))
+    multi_tap = {arg for _, arg in each}
+    if any(f != "tap_code16" for f, _ in each) or len(multi_tap) > 1:
+        raise Unsupported(f"dance {index}: on_dance_{index}() does more "
+                          "than tap a keycode")
+    return steps, multi_tap.pop() if multi_tap else "KC_NO"
+
+
+def parse_dances(source):
+    """Dances in tap_dance_codes order; [] if none, None if unsupported."""
+    m = DANCE_ENUM_RE.search(source)
+    if not m or not DANCE_BLOCK_RE.search(source):
+        return []
+    names = [n.strip() for n in m.group(1).split(",") if n.strip()]
+    try:
+        return [parse_dance(source, i) for i in range(len(names))]
+    except Unsupported as e:
+        print(f"oryx_codegen: keeping Oryx's dance code: {e}",
+              file=sys.stderr)
+        return None
+
+
+def parse_hands(overrides):
+    hands = ["L" if i % 12 < 6 else "R" for i in range(48)] + \
+        ["L", "L", "R", "R"]
+    for item in overrides:
+        pos, sep, hand = item.partition("=")
+        if not sep or hand not in ("L", "R", "*") or \
+                not pos.isdigit() or int(pos) >= LAYOUT_KEYS:
+            sys.exit(f"--hand: expected POS=L|R|* with POS under "
+                     f"{LAYOUT_KEYS}, got {item!r}")
+        hands[int(pos)] = hand
+    return hands
+
+
+def c_rows(items, per_row, indent="    "):
+    return "\n".join(indent + ", ".join(items[i:i + per_row]) + ","
+                     for i in range(0, len(items), per_row))
+
+
+def generate(ledmap, dances, hands):
+    header = [
+        "// Generated by scripts/oryx_codegen.py from the Oryx export. Do not",
+        "// edit; rerun the generator (scripts/apply-custom-qmk.sh does).",
+        "",
+        "#pragma once",
+        "",
+        '#include "quantum.h"',
+    ]
+    source = [
+        "// Generated by scripts/oryx_codegen.py from the Oryx export. Do not",
+        "// edit; rerun the generator (scripts/apply-custom-qmk.sh does).",
+        "",
+        '#include "oryx_tables.h"',
+        "",
+    ]
+
+    layers = max(ledmap) + 1 if ledmap else 1
+    black = (0, 0, 0)
+    palette = [black]
+    for layer in sorted(ledmap or {}):
+        for color in ledmap[layer]:
+            if color not in palette:
+                palette.append(color)
+    if len(palette) > 256:
+        sys.exit(f"ledmap has {len(palette)} colors, at most 256 fit a byte")
+    header += [
+        "",
+        "/** Layers in `ledmap_colors`, and colors in `ledmap_palette`. */",
+        f"#define LEDMAP_LAYERS {layers}",
+        f"#define LEDMAP_PALETTE_SIZE {len(palette)}",
+        "",
+        "/** Oryx's layer colors as HSV, black first. */",
+        "extern const uint8_t PROGMEM "
+        "ledmap_palette[LEDMAP_PALETTE_SIZE][3];",
+        "/** Index into `ledmap_palette` of each LED's color per layer. */",
+        "extern const uint8_t PROGMEM",
+        "    ledmap_colors[LEDMAP_LAYERS][RGB_MATRIX_LED_COUNT];",
+    ]
+    source += [
+        f"// {len(palette)} colors: {len(palette) * 3 + layers * LED_COUNT} "
+        f"bytes in place of Oryx's {layers * LED_COUNT * 3}.",
+        "const uint8_t PROGMEM ledmap_palette[LEDMAP_PALETTE_SIZE][3] = {",
+        c_rows(["{%d, %d, %d}" % c for c in palette], 4),
+        "};",
+        "",
+        "const uint8_t PROGMEM",
+        "    ledmap_colors[LEDMAP_LAYERS][RGB_MATRIX_LED_COUNT] = {",
+    ]
+    for layer in sorted(ledmap or {}):
+        indices = [str(palette.index(c)) for c in ledmap[layer]]
+        source += [f"    [{layer}] = {{", c_rows(indices, 16, " " * 8),
+                   "    },"]
+    source += ["};"]
+
+    if dances:
+        header += [
+            "",
+            '#include "features/oryx_dance.h"',
+            "",
+            "/** Dances in `oryx_dances`, in Oryx's tap_dance_codes order. */",
+            f"#define ORYX_DANCES {len(dances)}",
+            "",
+            "extern const oryx_dance_t PROGMEM oryx_dances[ORYX_DANCES];",
+        ]
+        source += [
+            "",
+            "#ifdef TAP_DANCE_ENABLE",
+            "// Keycodes of single tap, single hold, double tap, double hold "
+            "and tap then",
+            "// tap, and of taps from the third on.",
+            "const oryx_dance_t PROGMEM oryx_dances[ORYX_DANCES] = {",
+        ]
+        source += [f"    {{{{{', '.join(steps)}}}, {multi}}},"
+                   for steps, multi in dances]
+        source += [
+            "};",
+            "",
+            "tap_dance_action_t tap_dance_actions[] = {",
+        ]
+        source += [f"    ORYX_DANCE({i})," for i in range(len(dances))]
+        source += ["};", "#endif  // TAP_DANCE_ENABLE"]
+
+    header += [
+        "",
+        "/**",
+        " * Hand of each key for Achordion: 'L', 'R', or '*' to chord with "
+        "either.",
+        " * 0 at the matrix positions no key uses.",
+        " */",
+        "extern const char PROGMEM tap_hold_hands[MATRIX_ROWS][MATRIX_COLS];",
+    ]
+    quoted = [f"'{h}'" for h in hands]
+    source += [
+        "",
+        "// clang-format off",
+        "const char PROGMEM tap_hold_hands[MATRIX_ROWS][MATRIX_COLS] = "
+        "LAYOUT_voyager(",
+        "    " + ", ".join(quoted[0:6]) + ",    " + ", ".join(quoted[6:12]) +
+        ",",
+        "    " + ", ".join(quoted[12:18]) + ",    " +
+        ", ".join(quoted[18:24]) + ",",
+        "    " + ", ".join(quoted[24:30]) + ",    " +
+        ", ".join(quoted[30:36]) + ",",
+        "    " + ", ".join(quoted[36:42]) + ",    " +
+        ", ".join(quoted[42:48]) + ",",
+        " " * 24 + ", ".join(quoted[48:50]) + ",    " +
+        ", ".join(quoted[50:52]) + ");",
+        "// clang-format on",
+    ]
+    return "\n".join(header) + "\n", "\n".join(source) + "\n"
+
+
+def strip(path, dances_compiled):
+    """Removes the ledmap and the code showing it, and the dance code if
+    compiled, from `path`."""
+    with open(path) as f:
+        text = f.read()
+    stripped = LED_CODE_RE.sub("", LEDMAP_RE.sub("", text))
+    if dances_compiled:
+        stripped = DANCE_BLOCK_RE.sub("", stripped)
+    if stripped != text:
+        with open(path, "w") as f:
+            f.write(stripped)
+        print(f"oryx_codegen: removed Oryx's tables from {path}",
+              file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("source", nargs="?",
+                        default=os.path.join(ROOT, "eZrPW", "keymap.c"),
+                        help="Oryx source zip, directory or keymap.c, '-' "
+                        "for stdin (default: eZrPW/keymap.c)")
+    parser.add_argument("-o", "--output", default=os.path.join(ROOT, "eZrPW"),
+                        help="directory of oryx_tables.c and .h "
+                        "(default: eZrPW)")
+    parser.add_argument("--strip", metavar="KEYMAP",
+                        help="remove the code the tables replace from KEYMAP")
+    parser.add_argument("--hand", action="append", default=[],
+                        metavar="POS=L|R|*",
+                        help="hand of LAYOUT_voyager key POS, from 0")
+    args = parser.parse_args()
+
+    source = read_source(args.source)
+    ledmap = parse_ledmap(source)
+    if ledmap is None:
+        sys.exit(f"{args.source}: no Oryx ledmap; is this an Oryx export "
+                 "that was not stripped yet?")
+    dances = parse_dances(source)
+    header, body = generate(ledmap, dances, parse_hands(args.hand))
+    for name, text in (("oryx_tables.h", header), ("oryx_tables.c", body)):
+        with open(os.path.join(args.output, name), "w") as f:
+            f.write(text)
+    if args.strip:
+        strip(args.strip, bool(dances))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
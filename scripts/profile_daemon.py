@@ -0,0 +1,191 @@
+#!/usr/bin/env python3
+"""Switches the keyboard's tuning profile as the focused window changes.
+
+Follows the focused window's class (WM_CLASS on X11, the app id on Sway) and
+activates the tuning profile of the first rule whose pattern matches it, or
+the default profile, with the raw HID command of eZrPW/features/tuning.h.
+Profiles are set up beforehand with `scripts/user_hid.py tune --profile N
+... --save`; this only picks one, and only sends when the pick changes.
+
+Rules are GLOB=PROFILE, matched case-insensitively against the class, given
+with --rule or one per line in a --config file (# starts a comment):
+
+    # Terminals and editors: shortcut-heavy, short timeouts.
+    kitty=1
+    *term*=1
+    code=1
+    # Games.
+    steam_app_*=2
+
+--fake reads window classes, one per line, from a file or "-" for stdin
+instead of watching the desktop, and --dry-run prints the switches instead of
+sending them, so rules can be tried without a window system or a keyboard:
+
+    printf 'firefox\\nkitty\\nsteam_app_570\\n' | \\
+        scripts/profile_daemon.py --config profiles.conf --fake - --dry-run
+
+Usage:
+    scripts/profile_daemon.py [--config FILE] [--rule GLOB=N ...]
+                              [--default N] [--source x11|sway]
+                              [--fake FILE] [--dry-run]
+"""
+
+import argparse
+import fnmatch
+import json
+import os
+import re
+import subprocess
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from user_hid import HidError, Keyboard, select_profile  # noqa: E402
+
+WINDOW_ID_RE = re.compile(r"window id # (0x[0-9a-fA-F]+)")
+WM_CLASS_RE = re.compile(r'"([^"]*)"')
+
+
+def parse_rule(text):
+    pattern, sep, profile = text.rpartition("=")
+    if not sep or not pattern:
+        raise ValueError(f"expected GLOB=PROFILE, got {text!r}")
+    return pattern.strip().lower(), int(profile)
+
+
+def read_rules(path):
+    rules = []
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            try:
+                rules.append(parse_rule(line))
+            except ValueError as e:
+                sys.exit(f"{path}:{number}: {e}")
+    return rules
+
+
+def pick_profile(rules, default, window_class):
+    for pattern, profile in rules:
+        if fnmatch.fnmatchcase(window_class.lower(), pattern):
+            return profile
+    return default
+
+
+def fake_windows(path):
+    """Window classes from a file, one per line."""
+    f = sys.stdin if path == "-" else open(path)
+    with f:
+        for line in f:
+            line = line.strip()
+            if line and not line.startswith("#"):
+                yield line
+
+
+def x11_windows():
+    """Classes of the focused window on X11, on each focus change."""
+    spy = subprocess.Popen(["xprop", "-root", "-spy", "_NET_ACTIVE_WINDOW"],
+                           stdout=subprocess.PIPE, text=True)
+    for line in spy.stdout:
+        m = WINDOW_ID_RE.search(line)
+        if not m or int(m.group(1), 16) == 0:
+            continue
+        result = subprocess.run(["xprop", "-id", m.group(1), "WM_CLASS"],
+                                capture_output=True, text=True)
+        # WM_CLASS(STRING) = "instance", "class"
+        names = WM_CLASS_RE.findall(result.stdout)
+        if names:
+            yield names[-1]
+
+
+def sway_windows():
+    """App ids (or X11 classes under Xwayland) of focused windows on Sway."""
+    sub = subprocess.Popen(["swaymsg", "-t", "subscribe", "-m", '["window"]'],
+                           stdout=subprocess.PIPE, text=True)
+    for line in sub.stdout:
+        try:
+            event = json.loads(line)
+        except json.JSONDecodeError:
+            continue
+        if event.get("change") != "focus":
+            continue
+        container = event.get("container", {})
+        name = container.get("app_id") or \
+            container.get("window_properties", {}).get("class")
+        if name:
+            yield name
+
+
+class Switcher:
+    """Sends profile switches, reopening the keyboard after errors."""
+
+    def __init__(self, device, dry_run):
+        self.device = device
+        self.dry_run = dry_run
+        self.kb = None
+        self.current = None
+
+    def switch(self, profile, window_class):
+        if profile == self.current:
+            return
+        if self.dry_run:
+            print(f"{window_class}: profile {profile}", flush=True)
+            self.current = profile
+            return
+        try:
+            if self.kb is None:
+                self.kb = Keyboard(self.device)
+            select_profile(self.kb, profile)
+            self.current = profile
+            print(f"{window_class}: profile {profile}", file=sys.stderr)
+        except (HidError, OSError) as e:
+            print(f"{window_class}: profile {profile} not set: {e}",
+                  file=sys.stderr)
+            if self.kb is not None:
+                self.kb.close()
+                self.kb = None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--config", help="file of GLOB=PROFILE rules")
+    parser.add_argument("--rule", action="append", default=[],
+                        metavar="GLOB=N", help="rule, after the config's")
+    parser.add_argument("--default", type=int, default=0,
+                        help="profile when no rule matches (default: 0)")
+    parser.add_argument("--source", choices=["x11", "sway"],
+                        help="window system (default: from the environment)")
+    parser.add_argument("--fake", metavar="FILE",
+                        help="read window classes from FILE ('-' for stdin)")
+    parser.add_argument("--dry-run", action="store_true",
+                        help="print switches instead of sending them")
+    parser.add_argument("--device", help="hidraw node (default: autodetect)")
+    args = parser.parse_args()
+
+    rules = read_rules(args.config) if args.config else []
+    try:
+        rules += [parse_rule(rule) for rule in args.rule]
+    except ValueError as e:
+        parser.error(str(e))
+
+    if args.fake:
+        windows = fake_windows(args.fake)
+    elif (args.source or ("sway" if os.environ.get("SWAYSOCK") else "x11")) \
+            == "sway":
+        windows = sway_windows()
+    else:
+        windows = x11_windows()
+
+    switcher = Switcher(args.device, args.dry_run)
+    try:
+        for window_class in windows:
+            switcher.switch(pick_profile(rules, args.default, window_class),
+                            window_class)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+"""Sweeps Achordion settings over a trace corpus and prints the Pareto frontier.
+
+Replays every trace under every combination of the given settings with
+sim/build/sim_replay, running as many replays at once as there are cores, and
+reports the configurations for which no other one has both fewer misfires and
+a lower tap-hold latency. Misfires are tap-hold presses that resolved against
+the trace's intent, summed over the corpus, so the traces need intents (see
+scripts/gen_trace.py). Tap-hold latency is the mean time from pressing a
+mod-tap or layer-tap key to its settled tap or hold, the delay Achordion and
+QMK's tapping term hold keys back by.
+
+Each setting takes a comma-separated list of values; settings left out keep
+the keymap's. Streak timeouts are achordion_streak_chord_timeout() per class
+of tap-hold key; eager mods are sets of letters c, s, a and g (upper case for
+the right hand) or "none". Overlap is the ACHORDION_OVERLAP threshold in
+percent, 0 to settle at the other key's press. The keymap's own configuration is always replayed
+too, as the baseline.
+
+Usage:
+    make -C sim
+    scripts/sweep.py [--sim sim/build/sim_replay] [--jobs N]
+                     [--timeout 500,1000] [--max-streak-timeout 600,800]
+                     [--streak-ctrl 200,300] [--streak-shift 0]
+                     [--streak-alt 150,200] [--streak-gui 150,200]
+                     [--streak-layer 0] [--eager-mods csag,cs,none]
+                     [--overlap 0,50,80] [--csv FILE] TRACE...
+"""
+
+import argparse
+from concurrent.futures import ThreadPoolExecutor, as_completed
+import csv
+import itertools
+import json
+import os
+import subprocess
+import sys
+
+DEFAULT_SIM = os.path.join(
+    os.path.dirname(os.path.abspath(__file__)), "..", "sim", "build", "sim_replay"
+)
+STREAK_CLASSES = ["ctrl", "shift", "alt", "gui", "layer"]
+# Grid axes: (name, sim_replay option, parse one value).
+AXES = [("timeout", "--timeout", int),
+        ("max_streak_timeout", "--max-streak-timeout", int)] + [
+        (f"streak_{c}", "--streak", int) for c in STREAK_CLASSES] + [
+        ("eager_mods", "--eager-mods", str),
+        ("overlap", "--overlap", int)]
+TAP_HOLD_CLASSES = ["mod_tap", "layer_tap"]
+
+
+def sim_args(config):
+    """sim_replay options for a configuration, a dict of axis to value."""
+    args, streak = [], []
+    for name, option, _ in AXES:
+        if name not in config:
+            continue
+        if option == "--streak":
+            streak.append(f"{name[len('streak_'):]}={config[name]}")
+        else:
+            args += [option, str(config[name])]
+    if streak:
+        args += ["--streak", ",".join(streak)]
+    return args
+
+
+def replay(sim, config, trace):
+    cmd = [sim] + sim_args(config) + [trace]
+    result = subprocess.run(cmd, capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RuntimeError(f"{' '.join(cmd)} failed:\n{result.stderr}")
+    return json.loads(result.stdout)
+
+
+class Totals:
+    """Statistics of one configuration, summed over the corpus."""
+
+    def __init__(self):
+        self.misfires = 0
+        self.intended = 0
+        self.tap_holds = 0
+        self.latency_sum = 0.0
+        self.violations = 0
+        self.stuck_keys = 0
+
+    def add(self, stats):
+        self.misfires += stats["misfires"]
+        self.intended += stats["intended"]
+        for cls in TAP_HOLD_CLASSES:
+            l = stats["latency"][cls]
+            self.tap_holds += l["count"]
+            self.latency_sum += l["mean_ms"] * l["count"]
+        self.violations += stats["holdback_violations"]
+        self.stuck_keys += stats["stuck_keys"]
+
+    @property
+    def latency_ms(self):
+        return self.latency_sum / self.tap_holds if self.tap_holds else 0.0
+
+
+def pareto_frontier(results):
+    """Configurations not beaten on both misfires and latency, by latency."""
+    frontier = []
+    for config, totals in sorted(results,
+                                 key=lambda r: (r[1].latency_ms, r[1].misfires)):
+        if not frontier or totals.misfires < frontier[-1][1].misfires:
+            frontier.append((config, totals))
+    return frontier
+
+
+def describe(config):
+    if not config:
+        return "keymap"
+    return " ".join(f"{name}={config[name]}" for name, _, _ in AXES
+                    if name in config)
+
+
+def print_table(title, rows):
+    print(title)
+    print(f"  {'misfires':>9} {'latency ms':>10}  configuration")
+    for config, totals in rows:
+        note = ""
+        if totals.violations or totals.stuck_keys:
+            note = (f"  ({totals.violations} hold-back violations, "
+                    f"{totals.stuck_keys} stuck keys)")
+        print(f"  {totals.misfires:>9} {totals.latency_ms:>10.1f}  "
+              f"{describe(config)}{note}")
+
+
+def write_csv(path, results):
+    with open(path, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow([name for name, _, _ in AXES]
+                        + ["misfires", "intended", "latency_ms",
+                           "holdback_violations", "stuck_keys"])
+        for config, totals in results:
+            writer.writerow([config.get(name, "") for name, _, _ in AXES]
+                            + [totals.misfires, totals.intended,
+                               f"{totals.latency_ms:.3f}", totals.violations,
+                               totals.stuck_keys])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("traces", nargs="+", metavar="TRACE")
+    parser.add_argument("--sim", default=DEFAULT_SIM)
+    parser.add_argument("--jobs", type=int, default=os.cpu_count(),
+                        help="replays run at once (default: all cores)")
+    for name, _, _ in AXES:
+        parser.add_argument("--" + name.replace("_", "-"), dest=name,
+                            metavar="VALUES")
+    parser.add_argument("--csv", help="also write every configuration here")
+    args = parser.parse_args()
+
+    if not os.path.exists(args.sim):
+        sys.exit(f"{args.sim} not found; run `make -C sim` first")
+
+    axes = [(name, [parse(v) for v in getattr(args, name).split(",")])
+            for name, _, parse in AXES if getattr(args, name) is not None]
+    configs = [{}]
+    if axes:
+        configs += [dict(zip([name for name, _ in axes], values))
+                    for values in itertools.product(*(v for _, v in axes))]
+    totals = [Totals() for _ in configs]
+
+    jobs = len(configs) * len(args.traces)
+    print(f"{len(configs)} configurations x {len(args.traces)} traces "
+          f"on {args.jobs} cores", file=sys.stderr)
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = {pool.submit(replay, args.sim, config, trace): i
+                   for i, config in enumerate(configs)
+                   for trace in args.traces}
+        for done, future in enumerate(as_completed(futures), 1):
+            try:
+                totals[futures[future]].add(future.result())
+            except RuntimeError as e:
+                pool.shutdown(cancel_futures=True)
+                sys.exit(str(e))
+            print(f"\r{done}/{jobs}", end="", file=sys.stderr)
+    print(file=sys.stderr)
+
+    results = list(zip(configs, totals))
+    if args.csv:
+        write_csv(args.csv, results)
+    print_table("baseline", results[:1])
+    print(f"(misfires out of {totals[0].intended} tap-hold presses with an "
+          "intent; latency is the mean over tap-hold presses)\n")
+    print_table("Pareto frontier", pareto_frontier(results))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,619 @@
+#!/usr/bin/env python3
+"""Host side of the keymap's raw HID commands (see eZrPW/features/user_hid.h).
+
+Talks to the keyboard through Linux hidraw, with no dependencies beyond the
+standard library. The raw HID interface is found by its vendor-defined usage
+page (0xFF60) in the report descriptor.
+
+Usage:
+    scripts/user_hid.py profile [--reset] [--clock-mhz 72]
+    scripts/user_hid.py scanrate [--reset] [--clock-mhz 72]
+    scripts/user_hid.py latency [--reset] [--csv] [--clock-mhz 72]
+    scripts/user_hid.py trace -o session.ktr [--seconds N]
+    scripts/user_hid.py stack
+    scripts/user_hid.py bypass [on|off|toggle]
+    scripts/user_hid.py heatmap [on|off|toggle] [--clear]
+    scripts/user_hid.py tune [--profile N] [SETTING=VALUE ...]
+                             [--save | --load | --reset] [--use N]
+"""
+
+import argparse
+import glob
+import os
+import select
+import struct
+import sys
+import time
+
+ZSA_VENDOR_ID = 0x3297
+RAW_USAGE_PAGE = b"\x06\x60\xff"  # Usage Page (0xFF60), as QMK declares it.
+PACKET_SIZE = 32
+
+USER_HID_PROFILER = 0xA0
+USER_HID_SCAN_STATS = 0xA1
+USER_HID_LATENCY = 0xA2
+USER_HID_KEY_TRACE = 0xA3
+USER_HID_STACK = 0xA4
+USER_HID_BYPASS = 0xA5
+USER_HID_TUNING = 0xA6
+USER_HID_HEATMAP = 0xA7
+
+USER_HID_OK = 0x00
+
+# Order matches `enum profile_hook` in eZrPW/features/profiler.h.
+PROFILE_HOOKS = [
+    "process_record_user",
+    "process_achordion",
+    "achordion_task",
+    "rgb_matrix_indicators_user",
+    "tap dance on_each",
+    "tap dance finished",
+    "tap dance reset",
+]
+
+# Order matches `enum latency_class` in eZrPW/features/latency_trace.h.
+LATENCY_CLASSES = ["plain", "mod-tap", "layer-tap", "tap dance"]
+
+HISTOGRAM_BUCKETS = 32  # CYCLE_COUNTER_BUCKETS in cycle_counter.h.
+
+# Binary trace format, see eZrPW/features/key_trace_format.h.
+KEY_TRACE_MAGIC = b"KTRC"
+KEY_TRACE_VERSION = 1
+KEY_TRACE_RECORD_SIZE = 4
+
+# tuning_params_t in eZrPW/features/tuning.h, as of TUNING_VERSION.
+TUNING_VERSION = 2
+TUNING_KEYS = 16
+TUNING_KEYMAP = 0xFFFF
+STREAK_CLASSES = ["ctrl", "shift", "alt", "gui", "layer"]
+TUNING_FORMAT = struct.Struct(f"<H{len(STREAK_CLASSES)}HHH"
+                              f"{2 * TUNING_KEYS}HBx32s")
+TUNING_READ_MAX = PACKET_SIZE - 2
+TUNING_WRITE_MAX = PACKET_SIZE - 5
+# Letters of the eager mods sets, as for sim/build/sim_replay --eager-mods.
+MOD_LETTERS = "csag"
+# Basic keycode names for the streak keys, besides a-z and hex numbers.
+KEYCODE_NAMES = {
+    "1": 0x1E, "2": 0x1F, "3": 0x20, "4": 0x21, "5": 0x22, "6": 0x23,
+    "7": 0x24, "8": 0x25, "9": 0x26, "0": 0x27, "enter": 0x28, "esc": 0x29,
+    "bspc": 0x2A, "tab": 0x2B, "space": 0x2C, "minus": 0x2D, "equal": 0x2E,
+    "lbrc": 0x2F, "rbrc": 0x30, "bsls": 0x31, "scln": 0x33, "quote": 0x34,
+    "grave": 0x35, "comma": 0x36, "dot": 0x37, "slash": 0x38,
+}
+
+
+class HidError(Exception):
+    pass
+
+
+def find_device():
+    """Returns the /dev/hidrawN path of the keyboard's raw HID interface."""
+    for node in sorted(glob.glob("/sys/class/hidraw/hidraw*")):
+        try:
+            with open(os.path.join(node, "device", "uevent")) as f:
+                uevent = f.read()
+            with open(os.path.join(node, "device", "report_descriptor"), "rb") as f:
+                descriptor = f.read()
+        except OSError:
+            continue
+        hid_id = next(
+            (line.split("=", 1)[1] for line in uevent.splitlines()
+             if line.startswith("HID_ID=")), "")
+        parts = hid_id.split(":")
+        if len(parts) == 3 and int(parts[1], 16) == ZSA_VENDOR_ID \
+                and RAW_USAGE_PAGE in descriptor:
+            return "/dev/" + os.path.basename(node)
+    raise HidError("no ZSA keyboard with a raw HID interface found")
+
+
+class Keyboard:
+    def __init__(self, path=None, timeout=1.0):
+        self.fd = os.open(path or find_device(), os.O_RDWR)
+        self.timeout = timeout
+
+    def close(self):
+        os.close(self.fd)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def command(self, command, subcommand, payload=b""):
+        """Sends a command and returns the payload of its reply.
+
+        Oryx pushes its own packets over the same interface, so anything not
+        starting with our command byte is skipped.
+        """
+        packet = bytes([command, subcommand]) + payload
+        if len(packet) > PACKET_SIZE:
+            raise HidError("payload too long")
+        # Report ID 0, then the zero-padded packet.
+        os.write(self.fd, b"\x00" + packet.ljust(PACKET_SIZE, b"\x00"))
+        while True:
+            ready, _, _ = select.select([self.fd], [], [], self.timeout)
+            if not ready:
+                raise HidError(f"no reply to command 0x{command:02X}")
+            reply = os.read(self.fd, PACKET_SIZE)
+            if reply and reply[0] == command:
+                break
+        if reply[1] != USER_HID_OK:
+            raise HidError(
+                f"command 0x{command:02X}/0x{subcommand:02X} failed "
+                f"(status 0x{reply[1]:02X}); is the feature enabled?")
+        return reply[2:]
+
+
+def cmd_profile(kb, args):
+    if args.reset:
+        kb.command(USER_HID_PROFILER, 0x01)
+        print("Profiler statistics cleared.")
+        return
+    scale = 1.0 / args.clock_mhz  # Cycles to microseconds.
+    print(f"{'hook':<28}{'count':>10}{'min':>10}{'mean':>10}"
+          f"{'max':>10}{'p99':>10}  (us)")
+    hook, count = 0, len(PROFILE_HOOKS)
+    while hook < count:
+        reply = kb.command(USER_HID_PROFILER, 0x00, bytes([hook]))
+        count = reply[1]
+        n, lo, mean, hi, p99 = struct.unpack_from("<5I", reply, 2)
+        name = PROFILE_HOOKS[hook] if hook < len(PROFILE_HOOKS) else f"#{hook}"
+        if n:
+            print(f"{name:<28}{n:>10}{lo * scale:>10.1f}{mean * scale:>10.1f}"
+                  f"{hi * scale:>10.1f}{p99 * scale:>10.1f}")
+        else:
+            print(f"{name:<28}{0:>10}{'-':>10}{'-':>10}{'-':>10}{'-':>10}")
+        hook += 1
+
+
+def print_histogram(buckets, scale, unit):
+    """Prints a log2 histogram, one row per nonempty bucket."""
+    total = sum(buckets)
+    if not total:
+        print("(no samples)")
+        return
+    peak = max(buckets)
+    for i, n in enumerate(buckets):
+        if not n:
+            continue
+        lo, hi = (1 << i) * scale, (2 << i) * scale
+        bar = "#" * max(1, round(40 * n / peak))
+        print(f"{lo:>10.3f} - {hi:<10.3f}{unit} {n:>8} "
+              f"{100 * n / total:6.2f}% {bar}")
+
+
+def cmd_scanrate(kb, args):
+    if args.reset:
+        kb.command(USER_HID_SCAN_STATS, 0x02)
+        print("Scan statistics cleared.")
+        return
+    scale = 1.0 / args.clock_mhz
+    summary = kb.command(USER_HID_SCAN_STATS, 0x00)
+    rate, longest, total = struct.unpack_from("<3I", summary)
+    print(f"scan rate: {rate} scans/s, longest interval: "
+          f"{longest * scale:.1f} us, intervals: {total}")
+    buckets, count = [], 1
+    while len(buckets) < count:
+        reply = kb.command(USER_HID_SCAN_STATS, 0x01, bytes([len(buckets)]))
+        count = reply[1]
+        n = min(14, count - len(buckets))
+        buckets += struct.unpack_from(f"<{n}H", reply, 2)
+    print_histogram(buckets, scale, "us")
+
+
+def cmd_latency(kb, args):
+    if args.reset:
+        kb.command(USER_HID_LATENCY, 0x02)
+        print("Latency statistics cleared.")
+        return
+    scale = 1000.0 / (args.clock_mhz * 1e6)  # Cycles to milliseconds.
+    if args.csv:
+        print("class,bucket_low_ms,bucket_high_ms,count")
+    cls, count = 0, len(LATENCY_CLASSES)
+    while cls < count:
+        summary = kb.command(USER_HID_LATENCY, 0x00, bytes([cls]))
+        count = summary[1]
+        n, mean, longest, dropped = struct.unpack_from("<4I", summary, 2)
+        buckets = []
+        while len(buckets) < HISTOGRAM_BUCKETS:
+            reply = kb.command(USER_HID_LATENCY, 0x01,
+                               bytes([cls, len(buckets)]))
+            k = min(14, HISTOGRAM_BUCKETS - len(buckets))
+            buckets += struct.unpack_from(f"<{k}H", reply, 2)
+        name = LATENCY_CLASSES[cls] if cls < len(LATENCY_CLASSES) else f"#{cls}"
+        if args.csv:
+            for i, k in enumerate(buckets):
+                if k:
+                    print(f"{name},{(1 << i) * scale:.4f},"
+                          f"{(2 << i) * scale:.4f},{k}")
+        else:
+            print(f"== {name}: {n} presses, mean {mean * scale:.2f} ms, "
+                  f"max {longest * scale:.2f} ms, {dropped} without report")
+            print_histogram(buckets, scale, "ms")
+        cls += 1
+
+
+def cmd_trace(kb, args):
+    """Records key events into a binary trace until Ctrl-C or --seconds."""
+    kb.command(USER_HID_KEY_TRACE, 0x02)
+    records = 0
+    deadline = time.monotonic() + args.seconds if args.seconds else None
+    with open(args.output, "wb") as f:
+        # Record count 0 until known; start the trace at 1 s.
+        f.write(KEY_TRACE_MAGIC + struct.pack(
+            "<HHII", KEY_TRACE_VERSION, KEY_TRACE_RECORD_SIZE, 1000, 0))
+        print(f"Recording to {args.output}, Ctrl-C to stop.", file=sys.stderr)
+        try:
+            while deadline is None or time.monotonic() < deadline:
+                reply = kb.command(USER_HID_KEY_TRACE, 0x01)
+                n = reply[0]
+                f.write(reply[1:1 + n * KEY_TRACE_RECORD_SIZE])
+                records += n
+                if n == 0:
+                    time.sleep(0.05)
+        except KeyboardInterrupt:
+            pass
+        status = kb.command(USER_HID_KEY_TRACE, 0x00)
+        _, dropped = struct.unpack_from("<HI", status)
+        f.seek(12)
+        f.write(struct.pack("<I", records))
+    print(f"{records} records written, {dropped} events dropped.",
+          file=sys.stderr)
+
+
+def cmd_stack(kb, args):
+    reply = kb.command(USER_HID_STACK, 0x00)
+    size, peak, exc_size, exc_peak, current = struct.unpack_from("<5I", reply)
+    for name, size, peak in [("process (main loop)", size, peak),
+                             ("exceptions (interrupts)", exc_size, exc_peak)]:
+        print(f"{name:<24} peak {peak:>6} of {size:>6} bytes, "
+              f"{size - peak:>6} free ({100 * peak / size:.0f}% used)")
+    print(f"process stack in use now: {current} bytes")
+
+
+def cmd_bypass(kb, args):
+    if args.action == "toggle":
+        reply = kb.command(USER_HID_BYPASS, 0x02)
+    elif args.action:
+        reply = kb.command(USER_HID_BYPASS, 0x01,
+                           bytes([args.action == "on"]))
+    else:
+        reply = kb.command(USER_HID_BYPASS, 0x00)
+    on, pending, held = reply[0], reply[1], reply[2]
+    state = "on" if on else "off"
+    if pending:
+        state += (f", switching {'off' if on else 'on'} once the "
+                  f"{held} held key(s) are released")
+    print(f"bypass mode: {state}")
+
+
+HEATMAP_READ_MAX = 30
+# Matrix position (row, col) of each LAYOUT_voyager argument, by row of keys.
+VOYAGER_LAYOUT = [
+    [(0, 1), (0, 2), (0, 3), (0, 4), (0, 5), (0, 6),
+     (6, 0), (6, 1), (6, 2), (6, 3), (6, 4), (6, 5)],
+    [(1, 1), (1, 2), (1, 3), (1, 4), (1, 5), (1, 6),
+     (7, 0), (7, 1), (7, 2), (7, 3), (7, 4), (7, 5)],
+    [(2, 1), (2, 2), (2, 3), (2, 4), (2, 5), (2, 6),
+     (8, 0), (8, 1), (8, 2), (8, 3), (8, 4), (8, 5)],
+    [(3, 1), (3, 2), (3, 3), (3, 4), (3, 5), (3, 6),
+     (9, 0), (9, 1), (9, 2), (9, 3), (9, 4), (9, 5)],
+    [(4, 0), (4, 1), (10, 5), (10, 6)],
+]
+
+
+def cmd_heatmap(kb, args):
+    if args.action == "toggle":
+        reply = kb.command(USER_HID_HEATMAP, 0x02)
+    elif args.action:
+        reply = kb.command(USER_HID_HEATMAP, 0x01,
+                           bytes([args.action == "on"]))
+    else:
+        reply = kb.command(USER_HID_HEATMAP, 0x00)
+    if args.clear:
+        reply = kb.command(USER_HID_HEATMAP, 0x04)
+    on, rows, cols = reply[0], reply[1], reply[2]
+    heat = b""
+    while len(heat) < rows * cols:
+        count = min(HEATMAP_READ_MAX, rows * cols - len(heat))
+        heat += kb.command(USER_HID_HEATMAP, 0x03,
+                           bytes([len(heat), count]))[:count]
+    print(f"heatmap: {'on' if on else 'off'}")
+    width = 0
+    for keys in VOYAGER_LAYOUT:
+        cells = [f"{heat[row * cols + col]:3}" for row, col in keys]
+        half = len(cells) // 2
+        line = " ".join(cells[:half]) + "    " + " ".join(cells[half:])
+        # The thumb keys sit under the inner columns.
+        width = width or len(line)
+        print(line.center(width).rstrip())
+
+
+class Tuning:
+    """A tuning_params_t block. Fields holding TUNING_KEYMAP are None."""
+
+    def __init__(self, raw):
+        fields = TUNING_FORMAT.unpack(raw)
+        n = len(STREAK_CLASSES)
+        keymap = lambda v: None if v == TUNING_KEYMAP else v
+        self.timeout = keymap(fields[0])
+        self.streak = [keymap(v) for v in fields[1:1 + n]]
+        self.max_streak_timeout = keymap(fields[1 + n])
+        self.eager_mods = keymap(fields[2 + n])
+        pairs = fields[3 + n:3 + n + 2 * TUNING_KEYS]
+        self.keys = {}
+        for keycode, timeout in zip(pairs[::2], pairs[1::2]):
+            if keycode == 0:
+                break
+            self.keys[keycode] = timeout
+        streak_keys_set, bitmap = fields[-2:]
+        self.streak_keys = None
+        if streak_keys_set:
+            self.streak_keys = {k for k in range(256)
+                                if bitmap[k >> 3] & (1 << (k & 7))}
+
+    def pack(self):
+        unset = lambda v: TUNING_KEYMAP if v is None else v
+        pairs = []
+        for keycode, timeout in sorted(self.keys.items()):
+            pairs += [keycode, timeout]
+        pairs += [0] * (2 * TUNING_KEYS - len(pairs))
+        bitmap = bytearray(32)
+        for k in self.streak_keys or ():
+            bitmap[k >> 3] |= 1 << (k & 7)
+        return TUNING_FORMAT.pack(
+            unset(self.timeout), *map(unset, self.streak),
+            unset(self.max_streak_timeout), unset(self.eager_mods), *pairs,
+            self.streak_keys is not None, bytes(bitmap))
+
+
+def format_mods(mods):
+    if mods == 0:
+        return "none"
+    return "".join(
+        letter.upper() if right else letter
+        for right in (False, True) for i, letter in enumerate(MOD_LETTERS)
+        if mods & (1 << (i + 4 * right)))
+
+
+def parse_mods(text):
+    if text == "none":
+        return 0
+    mods = 0
+    for letter in text:
+        i = MOD_LETTERS.find(letter.lower())
+        if i < 0:
+            raise ValueError(f"unknown mod letter {letter!r}")
+        mods |= 1 << (i + 4 * letter.isupper())
+    return mods
+
+
+def keycode_name(keycode):
+    if 0x04 <= keycode <= 0x1D:
+        return chr(ord("a") + keycode - 0x04)
+    names = {v: k for k, v in KEYCODE_NAMES.items()}
+    return names.get(keycode, f"0x{keycode:02X}")
+
+
+def parse_keycode(text):
+    if len(text) == 1 and "a" <= text <= "z":
+        return 0x04 + ord(text) - ord("a")
+    if text in KEYCODE_NAMES:
+        return KEYCODE_NAMES[text]
+    return int(text, 0)
+
+
+def apply_setting(tuning, setting):
+    """Applies one SETTING=VALUE argument of `tune` to `tuning`."""
+    name, sep, value = setting.partition("=")
+    if not sep:
+        raise ValueError(f"expected SETTING=VALUE, got {setting!r}")
+    keymap = value == "keymap"
+    if name == "timeout":
+        tuning.timeout = None if keymap else int(value)
+    elif name == "max_streak_timeout":
+        tuning.max_streak_timeout = None if keymap else int(value)
+    elif name.startswith("streak."):
+        cls = name[len("streak."):]
+        if cls not in STREAK_CLASSES:
+            raise ValueError(f"unknown streak class {cls!r}")
+        tuning.streak[STREAK_CLASSES.index(cls)] = \
+            None if keymap else int(value)
+    elif name == "eager_mods":
+        tuning.eager_mods = None if keymap else parse_mods(value)
+    elif name.startswith("key."):
+        keycode = int(name[len("key."):], 0)
+        if keymap:
+            tuning.keys.pop(keycode, None)
+        else:
+            tuning.keys[keycode] = int(value)
+            if len(tuning.keys) > TUNING_KEYS:
+                raise ValueError(f"at most {TUNING_KEYS} per-key timeouts")
+    elif name == "streak_keys":
+        tuning.streak_keys = None if keymap else {
+            k for item in value.split(",") if item
+            for k in parse_range(item)}
+    else:
+        raise ValueError(f"unknown setting {name!r}")
+
+
+def parse_range(item):
+    """Keycodes of a streak_keys item: a keycode, or a range such as a-z."""
+    first, sep, last = item.partition("-")
+    if sep and first and last:
+        return range(parse_keycode(first), parse_keycode(last) + 1)
+    return [parse_keycode(item)]
+
+
+class TuningInfo:
+    """Reply to the tuning info command, checked against this script."""
+
+    def __init__(self, reply):
+        (size, version, keys, self.saved, self.profiles,
+         self.active) = struct.unpack_from("<HBBBBB", reply)
+        if version != TUNING_VERSION or size != TUNING_FORMAT.size \
+                or keys != TUNING_KEYS:
+            raise HidError(f"firmware has tuning version {version} ({size} "
+                           f"bytes); this script knows {TUNING_VERSION}")
+
+
+def tuning_info(kb):
+    return TuningInfo(kb.command(USER_HID_TUNING, 0x00))
+
+
+def select_profile(kb, profile):
+    """Activates tuning profile `profile`, returning the active profile."""
+    reply = kb.command(USER_HID_TUNING, 0x06, bytes([profile]))
+    return reply[0]
+
+
+def read_tuning(kb, profile):
+    base = profile * TUNING_FORMAT.size
+    raw = b""
+    while len(raw) < TUNING_FORMAT.size:
+        count = min(TUNING_READ_MAX, TUNING_FORMAT.size - len(raw))
+        raw += kb.command(USER_HID_TUNING, 0x01,
+                          struct.pack("<HB", base + len(raw), count))[:count]
+    return Tuning(raw)
+
+
+def write_tuning(kb, profile, old, new):
+    """Writes the bytes of `new` that differ from `old`."""
+    base = profile * TUNING_FORMAT.size
+    for offset in range(0, len(new), TUNING_WRITE_MAX):
+        chunk = new[offset:offset + TUNING_WRITE_MAX]
+        if chunk != old[offset:offset + TUNING_WRITE_MAX]:
+            kb.command(USER_HID_TUNING, 0x02,
+                       struct.pack("<HB", base + offset, len(chunk)) + chunk)
+
+
+def print_tuning(tuning):
+    show = lambda v, unit="ms": "keymap" if v is None else f"{v} {unit}"
+    print(f"{'timeout':<22}{show(tuning.timeout)}")
+    for keycode, timeout in sorted(tuning.keys.items()):
+        print(f"  {f'key 0x{keycode:04X}':<20}{timeout} ms")
+    for cls, timeout in zip(STREAK_CLASSES, tuning.streak):
+        print(f"{'streak ' + cls:<22}{show(timeout)}")
+    print(f"{'max_streak_timeout':<22}{show(tuning.max_streak_timeout)}")
+    eager = tuning.eager_mods
+    print(f"{'eager_mods':<22}"
+          f"{'keymap' if eager is None else format_mods(eager)}")
+    if tuning.streak_keys is None:
+        print(f"{'streak_keys':<22}keymap")
+    else:
+        print(f"{'streak_keys':<22}"
+              + ",".join(keycode_name(k) for k in sorted(tuning.streak_keys)))
+
+
+def cmd_tune(kb, args):
+    if args.reset:
+        kb.command(USER_HID_TUNING, 0x05)
+    elif args.load:
+        kb.command(USER_HID_TUNING, 0x04)
+    info = tuning_info(kb)
+    profile = info.active if args.profile is None else args.profile
+    if not 0 <= profile < info.profiles:
+        raise HidError(f"profile {profile} out of range; the firmware has "
+                       f"{info.profiles}")
+    tuning = read_tuning(kb, profile)
+    if args.settings:
+        old = tuning.pack()
+        try:
+            for setting in args.settings:
+                apply_setting(tuning, setting)
+        except ValueError as e:
+            raise HidError(str(e))
+        write_tuning(kb, profile, old, tuning.pack())
+    if args.save:
+        kb.command(USER_HID_TUNING, 0x03)
+        info.saved = True
+    if args.use is not None:
+        info.active = select_profile(kb, args.use)
+    print(f"profile {profile} of {info.profiles}:")
+    print_tuning(tuning)
+    print(f"(profile {info.active} active; EEPROM "
+          f"{'holds saved profiles' if info.saved else 'has none saved'})")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--device", help="hidraw node (default: autodetect)")
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("profile", help="show per-hook timings")
+    p.add_argument("--reset", action="store_true", help="clear statistics")
+    p.add_argument("--clock-mhz", type=float, default=72.0,
+                   help="core clock used to convert cycles (default: 72)")
+    p.set_defaults(func=cmd_profile)
+
+    p = sub.add_parser("scanrate", help="show scan rate and interval histogram")
+    p.add_argument("--reset", action="store_true", help="clear statistics")
+    p.add_argument("--clock-mhz", type=float, default=72.0,
+                   help="core clock used to convert cycles (default: 72)")
+    p.set_defaults(func=cmd_scanrate)
+
+    p = sub.add_parser("latency", help="show key-to-report latency per class")
+    p.add_argument("--reset", action="store_true", help="clear statistics")
+    p.add_argument("--csv", action="store_true",
+                   help="print histogram buckets as CSV for other tools")
+    p.add_argument("--clock-mhz", type=float, default=72.0,
+                   help="core clock used to convert cycles (default: 72)")
+    p.set_defaults(func=cmd_latency)
+
+    p = sub.add_parser("trace", help="record key events for sim/ replay")
+    p.add_argument("-o", "--output", required=True,
+                   help="binary trace file to write")
+    p.add_argument("--seconds", type=float,
+                   help="stop after this long (default: until Ctrl-C)")
+    p.set_defaults(func=cmd_trace)
+
+    p = sub.add_parser("stack", help="show stack high-water marks")
+    p.set_defaults(func=cmd_stack)
+
+    p = sub.add_parser("bypass", help="show or switch bypass (gaming) mode")
+    p.add_argument("action", nargs="?", choices=["on", "off", "toggle"])
+    p.set_defaults(func=cmd_bypass)
+
+    p = sub.add_parser("heatmap", help="show or switch the typing heatmap "
+                       "and print its counters")
+    p.add_argument("action", nargs="?", choices=["on", "off", "toggle"])
+    p.add_argument("--clear", action="store_true",
+                   help="then clear the counters")
+    p.set_defaults(func=cmd_heatmap)
+
+    p = sub.add_parser(
+        "tune", help="show or change Achordion settings at runtime",
+        description="Settings: timeout=MS, key.KEYCODE=MS (per tap-hold "
+        "keycode, e.g. key.0x2104=600), streak.CLASS=MS (ctrl, shift, alt, "
+        "gui, layer), max_streak_timeout=MS, eager_mods=MODS (c, s, a, g, "
+        "upper case for the right hand, or none) and streak_keys=KEYS "
+        "(e.g. a-z,dot,comma,quote,space). VALUE keymap restores the "
+        "keymap's setting.")
+    p.add_argument("settings", nargs="*", metavar="SETTING=VALUE")
+    p.add_argument("--profile", type=int,
+                   help="profile to show or change (default: the active one)")
+    p.add_argument("--use", type=int, metavar="N",
+                   help="then activate profile N")
+    group = p.add_mutually_exclusive_group()
+    group.add_argument("--save", action="store_true",
+                       help="then save all profiles to EEPROM")
+    group.add_argument("--load", action="store_true",
+                       help="first load the profiles saved in EEPROM")
+    group.add_argument("--reset", action="store_true",
+                       help="first reset all profiles to the keymap's "
+                       "settings")
+    p.set_defaults(func=cmd_tune)
+
+    args = parser.parse_args()
+    try:
+        with Keyboard(args.device) as kb:
+            args.func(kb, args)
+    except (HidError, OSError) as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,116 @@
+/**
+ * @file fuzz_achordion.c
+ * @brief Fuzz target driving Achordion through the simulator.
+ *
+ * The input is read as 2-byte steps. The first byte picks one of the 52 keys
+ * (modulo 52) and toggles it, pressing it if up and releasing it if down. The
+ * second byte is the time before the step: 0-127 ms as is, 128-255 as 16 ms
+ * steps up to ~2 s, so both rolls and timeouts are reachable. All keys are
+ * released at the end and the timers run out. Each input is replayed twice,
+ * with the keymap's Achordion settings and with ACHORDION_OVERLAP's policy.
+ *
+ * Invariants checked after each input, aborting on violation:
+ *
+ *  * no key or modifier is left registered;
+ *  * no tap-hold press is held back by Achordion longer than
+ *    achordion_timeout() plus the longest housekeeping tick;
+ *  * process_record() nests at most MAX_DEPTH deep, i.e. events Achordion
+ *    plumbs back through features/event_queue.c are replayed one level down
+ *    from the event that settled them, never further.
+ *
+ * The worst hold-back over the run is printed at exit.
+ *
+ * Build with libFuzzer (`make -C sim fuzz-libfuzzer`, needs clang), with AFL
+ * (`make -C sim fuzz CC=afl-clang-fast`, then `afl-fuzz ... -- build/fuzz @@`)
+ * or standalone with fuzz_main.c (`make -C sim fuzz`).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+// process_record() from the tapping layer, plus one level of Achordion
+// plumbing an event back in.
+#define MAX_DEPTH 2
+
+// LAYOUT_voyager argument index to matrix position, see qmk/quantum.h.
+static const uint8_t positions[52][2] = {
+    {0, 1}, {0, 2}, {0, 3}, {0, 4}, {0, 5}, {0, 6},
+    {6, 0}, {6, 1}, {6, 2}, {6, 3}, {6, 4}, {6, 5},
+    {1, 1}, {1, 2}, {1, 3}, {1, 4}, {1, 5}, {1, 6},
+    {7, 0}, {7, 1}, {7, 2}, {7, 3}, {7, 4}, {7, 5},
+    {2, 1}, {2, 2}, {2, 3}, {2, 4}, {2, 5}, {2, 6},
+    {8, 0}, {8, 1}, {8, 2}, {8, 3}, {8, 4}, {8, 5},
+    {3, 1}, {3, 2}, {3, 3}, {3, 4}, {3, 5}, {3, 6},
+    {9, 0}, {9, 1}, {9, 2}, {9, 3}, {9, 4}, {9, 5},
+    {4, 0}, {4, 1}, {10, 5}, {10, 6},
+};
+
+static uint32_t worst_holdback = 0;
+
+static void report_worst(void) {
+  fprintf(stderr, "fuzz_achordion: worst hold-back %u ms\n", worst_holdback);
+}
+
+static void check(bool ok, const char* invariant, const sim_stats_t* stats) {
+  if (!ok) {
+    fprintf(stderr,
+            "fuzz_achordion: %s (stuck_keys=%u max_holdback_ms=%u "
+            "max_tick_ms=%u max_depth=%u)\n",
+            invariant, stats->stuck_keys, stats->max_holdback_ms,
+            stats->max_tick_ms, stats->max_depth);
+    abort();
+  }
+}
+
+static void run(const uint8_t* data, size_t size,
+                const sim_achordion_params_t* achordion) {
+  const sim_options_t options = {.policy = SIM_POLICY_ACHORDION,
+                                 .achordion = achordion};
+  sim_init(&options);
+  bool down[52] = {false};
+  uint32_t time = sim_time();
+
+  for (size_t i = 0; i + 1 < size; i += 2) {
+    const uint8_t key = data[i] % 52;
+    const uint8_t delay = data[i + 1];
+    time += delay < 128 ? delay : (delay - 127) * 16;
+    down[key] = !down[key];
+    sim_key_event(time, positions[key][0], positions[key][1], down[key],
+                  SIM_INTENT_NONE);
+  }
+  for (uint8_t key = 0; key < 52; ++key) {
+    if (down[key]) {
+      sim_key_event(++time, positions[key][0], positions[key][1], false,
+                    SIM_INTENT_NONE);
+    }
+  }
+  sim_finish();
+
+  const sim_stats_t* stats = sim_stats();
+  if (stats->max_holdback_ms > worst_holdback) {
+    worst_holdback = stats->max_holdback_ms;
+  }
+  check(stats->stuck_keys == 0, "key or mod left registered", stats);
+  check(stats->holdback_violations == 0,
+        "press held back past achordion_timeout() + 1 tick", stats);
+  check(stats->max_depth <= MAX_DEPTH, "process_record() nested too deep",
+        stats);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  static bool registered = false;
+  if (!registered) {
+    atexit(report_worst);
+    registered = true;
+  }
+
+  sim_achordion_params_t overlap;
+  memset(&overlap, 0xFF, sizeof(overlap));  // SIM_KEYMAP throughout.
+  overlap.overlap_percent = 50;
+  run(data, size, NULL);
+  run(data, size, &overlap);
+  return 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file fuzz_main.c
+ * @brief Standalone driver for fuzz_achordion.c where libFuzzer is missing.
+ *
+ * Usage: fuzz [-n RUNS] [-s SEED] [-l MAX_LEN] [FILE ...]
+ *
+ * With files, runs each as one input, which is what AFL and crash reproduction
+ * need. Otherwise runs RUNS random inputs; an input that aborts is saved to
+ * crash-input.bin.
+ */
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+// The random input being run, saved if it aborts.
+static const uint8_t* current_data;
+static size_t current_size;
+
+static void save_crash(int signal) {
+  FILE* out = fopen("crash-input.bin", "wb");
+  if (out) {
+    fwrite(current_data, 1, current_size, out);
+    fclose(out);
+    fprintf(stderr, "fuzz: input saved to crash-input.bin\n");
+  }
+}
+
+static int run_file(const char* path) {
+  FILE* in = fopen(path, "rb");
+  if (!in) {
+    perror(path);
+    return 1;
+  }
+  uint8_t* data = NULL;
+  size_t size = 0, capacity = 0;
+  for (;;) {
+    if (size == capacity) {
+      capacity = capacity ? 2 * capacity : 4096;
+      data = realloc(data, capacity);
+    }
+    const size_t n = fread(data + size, 1, capacity - size, in);
+    if (!n) {
+      break;
+    }
+    size += n;
+  }
+  fclose(in);
+  LLVMFuzzerTestOneInput(data, size);
+  free(data);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  unsigned long runs = 100000;
+  unsigned seed = 1;
+  size_t max_len = 512;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:s:l:")) != -1) {
+    switch (opt) {
+      case 'n':
+        runs = strtoul(optarg, NULL, 0);
+        break;
+      case 's':
+        seed = strtoul(optarg, NULL, 0);
+        break;
+      case 'l':
+        max_len = strtoul(optarg, NULL, 0);
+        break;
+      default:
+        fprintf(stderr, "usage: fuzz [-n RUNS] [-s SEED] [-l MAX_LEN] "
+                        "[FILE ...]\n");
+        return 2;
+    }
+  }
+
+  if (optind < argc) {
+    int status = 0;
+    for (int i = optind; i < argc; ++i) {
+      status |= run_file(argv[i]);
+    }
+    return status;
+  }
+
+  srand(seed);
+  uint8_t* data = malloc(max_len);
+  current_data = data;
+  signal(SIGABRT, save_crash);
+  for (unsigned long run = 0; run < runs; ++run) {
+    const size_t size = rand() % (max_len + 1);
+    for (size_t i = 0; i < size; ++i) {
+      // Bias delays short, where tap-hold decisions happen.
+      data[i] = (i & 1) && rand() % 4 ? rand() % 64 : rand();
+    }
+    current_size = size;
+    LLVMFuzzerTestOneInput(data, size);
+  }
+  free(data);
+  fprintf(stderr, "fuzz: %lu runs\n", runs);
+  return 0;
+}
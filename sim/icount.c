@@ -0,0 +1,265 @@
+/**
+ * @file icount.c
+ * @brief Counts the instructions a program executes in selected functions.
+ *
+ * Usage: icount FUNC=ADDR ... -- PROGRAM [ARG ...]
+ *
+ * Runs PROGRAM under ptrace with a breakpoint at each function's entry, ADDR
+ * being its address as `nm` prints it, and single-steps each call from its
+ * entry to its return. Counts are inclusive of callees; a measured function
+ * called from another counts toward both. Prints one line per function:
+ *
+ *     FUNC CALLS INSTRUCTIONS MAX
+ *
+ * with the total over all calls and the most any one call took. PROGRAM's
+ * standard output is discarded.
+ *
+ * Unlike timing, the counts are the same on every run, so they can be
+ * compared against a stored baseline (see scripts/bench.py). They are host
+ * (x86-64) instructions, a proxy for the keyboard's: changes in them track
+ * changes in the work done.
+ */
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "icount reads x86-64 Linux registers"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/personality.h>
+#include <sys/ptrace.h>
+#include <sys/user.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define MAX_FUNCS 16
+#define MAX_DEPTH 64
+
+typedef struct {
+  const char* name;
+  uintptr_t addr;
+  long saved;  // Original word at addr, its first byte replaced by int3.
+  uint64_t calls;
+  uint64_t total;
+  uint64_t max;
+} func_t;
+
+// A call being stepped through.
+typedef struct {
+  func_t* func;
+  uintptr_t ret;
+  uintptr_t sp;
+  uint64_t count;
+} frame_t;
+
+static func_t funcs[MAX_FUNCS];
+static int func_count = 0;
+static pid_t child;
+
+static void die(const char* what) {
+  perror(what);
+  if (child > 0) {
+    kill(child, SIGKILL);
+  }
+  exit(1);
+}
+
+// Load address of the program's first mapping, from /proc/PID/maps.
+static uintptr_t load_base(void) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/maps", (int)child);
+  FILE* maps = fopen(path, "r");
+  if (!maps) {
+    die(path);
+  }
+  unsigned long start = 0;
+  if (fscanf(maps, "%lx", &start) != 1) {
+    fprintf(stderr, "icount: cannot read %s\n", path);
+    exit(1);
+  }
+  fclose(maps);
+  return start;
+}
+
+static void set_breakpoints(bool on) {
+  for (int i = 0; i < func_count; ++i) {
+    long word = on ? (funcs[i].saved & ~0xffL) | 0xcc : funcs[i].saved;
+    if (ptrace(PTRACE_POKETEXT, child, funcs[i].addr, word) < 0) {
+      die("PTRACE_POKETEXT");
+    }
+  }
+}
+
+static func_t* func_at(uintptr_t addr) {
+  for (int i = 0; i < func_count; ++i) {
+    if (funcs[i].addr == addr) {
+      return &funcs[i];
+    }
+  }
+  return NULL;
+}
+
+// Returns false once the child exited.
+static bool wait_child(void) {
+  int status;
+  if (waitpid(child, &status, 0) < 0) {
+    die("waitpid");
+  }
+  if (WIFEXITED(status) || WIFSIGNALED(status)) {
+    if (WIFSIGNALED(status)) {
+      fprintf(stderr, "icount: program killed by signal %d\n",
+              WTERMSIG(status));
+      exit(1);
+    }
+    return false;
+  }
+  return true;
+}
+
+static void push(frame_t* stack, int* depth, func_t* func,
+                 struct user_regs_struct* regs) {
+  if (*depth == MAX_DEPTH) {
+    fprintf(stderr, "icount: calls nested deeper than %d\n", MAX_DEPTH);
+    kill(child, SIGKILL);
+    exit(1);
+  }
+  const long ret = ptrace(PTRACE_PEEKDATA, child, regs->rsp, NULL);
+  stack[(*depth)++] = (frame_t){func, (uintptr_t)ret, regs->rsp, 0};
+}
+
+// Single-steps from the entry of `func`, where the child stopped, until the
+// call and any measured calls made from it returned.
+static bool step_call(func_t* func, struct user_regs_struct* regs) {
+  frame_t stack[MAX_DEPTH];
+  int depth = 0;
+  push(stack, &depth, func, regs);
+  while (depth) {
+    if (ptrace(PTRACE_SINGLESTEP, child, NULL, NULL) < 0) {
+      die("PTRACE_SINGLESTEP");
+    }
+    if (!wait_child()) {
+      return false;
+    }
+    for (int i = 0; i < depth; ++i) {
+      ++stack[i].count;
+    }
+    if (ptrace(PTRACE_GETREGS, child, NULL, regs) < 0) {
+      die("PTRACE_GETREGS");
+    }
+    // Returns pop the stack pointer above the frame's return address.
+    while (depth && regs->rip == stack[depth - 1].ret &&
+           regs->rsp > stack[depth - 1].sp) {
+      const frame_t* done = &stack[--depth];
+      ++done->func->calls;
+      done->func->total += done->count;
+      if (done->count > done->func->max) {
+        done->func->max = done->count;
+      }
+    }
+    func_t* callee = func_at(regs->rip);
+    if (callee) {
+      push(stack, &depth, callee, regs);
+    }
+  }
+  return true;
+}
+
+static int run(char** argv) {
+  child = fork();
+  if (child < 0) {
+    die("fork");
+  }
+  if (child == 0) {
+    const int null = open("/dev/null", O_WRONLY);
+    if (null >= 0) {
+      dup2(null, STDOUT_FILENO);
+    }
+    // Fixed addresses: libc's memcpy() and memset() take paths by alignment.
+    personality(ADDR_NO_RANDOMIZE);
+    ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+    execvp(argv[0], argv);
+    perror(argv[0]);
+    _exit(127);
+  }
+  if (!wait_child()) {
+    fprintf(stderr, "icount: %s did not start\n", argv[0]);
+    return 1;
+  }
+
+  // nm prints offsets for position-independent executables and absolute
+  // addresses otherwise.
+  const uintptr_t base = load_base();
+  for (int i = 0; i < func_count; ++i) {
+    if (funcs[i].addr < base) {
+      funcs[i].addr += base;
+    }
+    errno = 0;
+    funcs[i].saved = ptrace(PTRACE_PEEKTEXT, child, funcs[i].addr, NULL);
+    if (errno) {
+      die(funcs[i].name);
+    }
+  }
+  set_breakpoints(true);
+
+  for (;;) {
+    if (ptrace(PTRACE_CONT, child, NULL, NULL) < 0) {
+      die("PTRACE_CONT");
+    }
+    if (!wait_child()) {
+      return 0;
+    }
+    struct user_regs_struct regs;
+    if (ptrace(PTRACE_GETREGS, child, NULL, &regs) < 0) {
+      die("PTRACE_GETREGS");
+    }
+    func_t* func = func_at(regs.rip - 1);
+    if (!func) {
+      fprintf(stderr, "icount: unexpected stop at %llx\n", regs.rip);
+      kill(child, SIGKILL);
+      return 1;
+    }
+    // Back to the entry, with the original code, until the call returned.
+    regs.rip = func->addr;
+    if (ptrace(PTRACE_SETREGS, child, NULL, &regs) < 0) {
+      die("PTRACE_SETREGS");
+    }
+    set_breakpoints(false);
+    if (!step_call(func, &regs)) {
+      return 0;
+    }
+    set_breakpoints(true);
+  }
+}
+
+int main(int argc, char** argv) {
+  int i = 1;
+  for (; i < argc && strcmp(argv[i], "--"); ++i) {
+    char* eq = strchr(argv[i], '=');
+    if (!eq || func_count == MAX_FUNCS) {
+      fprintf(stderr, "usage: icount FUNC=ADDR ... -- PROGRAM [ARG ...]\n");
+      return 2;
+    }
+    *eq = '\0';
+    funcs[func_count++] =
+        (func_t){.name = argv[i], .addr = strtoull(eq + 1, NULL, 16)};
+  }
+  if (i + 1 >= argc || !func_count) {
+    fprintf(stderr, "usage: icount FUNC=ADDR ... -- PROGRAM [ARG ...]\n");
+    return 2;
+  }
+  if (run(argv + i + 1)) {
+    return 1;
+  }
+  for (int f = 0; f < func_count; ++f) {
+    printf("%s %" PRIu64 " %" PRIu64 " %" PRIu64 "\n", funcs[f].name,
+           funcs[f].calls, funcs[f].total, funcs[f].max);
+  }
+  return 0;
+}
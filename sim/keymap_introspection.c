@@ -0,0 +1,11 @@
+/**
+ * @file keymap_introspection.c
+ * @brief Builds keymap.c into the simulator, as QMK's keymap_introspection.c
+ * does on the keyboard.
+ */
+
+#include "keymap.c"
+
+uint8_t keymap_layer_count(void) {
+  return sizeof(keymaps) / sizeof(keymaps[0]);
+}
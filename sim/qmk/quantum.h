@@ -0,0 +1,427 @@
+/**
+ * @file quantum.h
+ * @brief Host stand-in for the QMK API used by the eZrPW keymap.
+ *
+ * Declares just enough of QMK for keymap.c and features/ to compile on the
+ * host, with keycode values and struct layouts matching QMK's. The behavior
+ * behind the declarations, a model of QMK's record pipeline, is in sim.c.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Voyager matrix: rows 0-5 are the left half, rows 6-11 the right half.
+#define MATRIX_ROWS 12
+#define MATRIX_COLS 7
+#define RGB_MATRIX_LED_COUNT 52
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define memcpy_P memcpy
+
+/* Keycodes ---------------------------------------------------------------- */
+
+enum {
+  KC_NO = 0x0000,
+  KC_TRANSPARENT = 0x0001,
+  KC_A = 0x0004,
+  KC_B, KC_C, KC_D, KC_E, KC_F, KC_G, KC_H, KC_I, KC_J, KC_K, KC_L, KC_M,
+  KC_N, KC_O, KC_P, KC_Q, KC_R, KC_S, KC_T, KC_U, KC_V, KC_W, KC_X, KC_Y,
+  KC_Z,
+  KC_1 = 0x001E,
+  KC_2, KC_3, KC_4, KC_5, KC_6, KC_7, KC_8, KC_9, KC_0,
+  KC_ENTER = 0x0028,
+  KC_ESCAPE, KC_BACKSPACE, KC_TAB, KC_SPACE, KC_MINUS, KC_EQUAL,
+  KC_LEFT_BRACKET, KC_RIGHT_BRACKET, KC_BACKSLASH, KC_NONUS_HASH,
+  KC_SEMICOLON, KC_QUOTE, KC_GRAVE, KC_COMMA, KC_DOT, KC_SLASH, KC_CAPS_LOCK,
+  KC_DELETE = 0x004C,
+  KC_RIGHT = 0x004F,
+  KC_LEFT, KC_DOWN, KC_UP, KC_NUM_LOCK,
+  KC_AUDIO_MUTE = 0x00A8,
+  KC_AUDIO_VOL_UP, KC_AUDIO_VOL_DOWN, KC_MEDIA_NEXT_TRACK,
+  KC_MEDIA_PREV_TRACK, KC_MEDIA_STOP, KC_MEDIA_PLAY_PAUSE,
+  KC_LEFT_CTRL = 0x00E0,
+  KC_LEFT_SHIFT, KC_LEFT_ALT, KC_LEFT_GUI, KC_RIGHT_CTRL, KC_RIGHT_SHIFT,
+  KC_RIGHT_ALT, KC_RIGHT_GUI,
+};
+
+#define KC_TRNS KC_TRANSPARENT
+#define KC_BSPC KC_BACKSPACE
+#define KC_ESC KC_ESCAPE
+#define KC_SPC KC_SPACE
+#define KC_LBRC KC_LEFT_BRACKET
+#define KC_RBRC KC_RIGHT_BRACKET
+#define KC_BSLS KC_BACKSLASH
+#define KC_SCLN KC_SEMICOLON
+#define KC_QUOT KC_QUOTE
+#define KC_GRV KC_GRAVE
+#define KC_COMM KC_COMMA
+#define KC_SLSH KC_SLASH
+#define KC_NUM KC_NUM_LOCK
+#define KC_DEL KC_DELETE
+#define KC_LCTL KC_LEFT_CTRL
+#define KC_LSFT KC_LEFT_SHIFT
+#define KC_LALT KC_LEFT_ALT
+#define KC_LGUI KC_LEFT_GUI
+#define KC_RCTL KC_RIGHT_CTRL
+#define KC_RSFT KC_RIGHT_SHIFT
+#define KC_RALT KC_RIGHT_ALT
+#define KC_RGUI KC_RIGHT_GUI
+
+enum {
+  MOD_LCTL = 0x01,
+  MOD_LSFT = 0x02,
+  MOD_LALT = 0x04,
+  MOD_LGUI = 0x08,
+  MOD_RCTL = 0x11,
+  MOD_RSFT = 0x12,
+  MOD_RALT = 0x14,
+  MOD_RGUI = 0x18,
+  MOD_HYPR = 0x0F,
+};
+
+#define MOD_BIT(kc) (1 << ((kc) & 0x07))
+#define MOD_BIT_LCTRL MOD_BIT(KC_LEFT_CTRL)
+#define MOD_BIT_LSHIFT MOD_BIT(KC_LEFT_SHIFT)
+#define MOD_BIT_LALT MOD_BIT(KC_LEFT_ALT)
+#define MOD_BIT_LGUI MOD_BIT(KC_LEFT_GUI)
+#define MOD_BIT_RCTRL MOD_BIT(KC_RIGHT_CTRL)
+#define MOD_BIT_RSHIFT MOD_BIT(KC_RIGHT_SHIFT)
+#define MOD_BIT_RALT MOD_BIT(KC_RIGHT_ALT)
+#define MOD_BIT_RGUI MOD_BIT(KC_RIGHT_GUI)
+#define MOD_MASK_CTRL (MOD_BIT_LCTRL | MOD_BIT_RCTRL)
+#define MOD_MASK_SHIFT (MOD_BIT_LSHIFT | MOD_BIT_RSHIFT)
+#define MOD_MASK_ALT (MOD_BIT_LALT | MOD_BIT_RALT)
+#define MOD_MASK_GUI (MOD_BIT_LGUI | MOD_BIT_RGUI)
+#define MOD_MASK_CG (MOD_MASK_CTRL | MOD_MASK_GUI)
+
+// Keycode ranges.
+#define QK_BASIC_MAX 0x00FF
+#define QK_MODS 0x0100
+#define QK_MODS_MAX 0x1FFF
+#define QK_MOD_TAP 0x2000
+#define QK_MOD_TAP_MAX 0x3FFF
+#define QK_LAYER_TAP 0x4000
+#define QK_LAYER_TAP_MAX 0x4FFF
+#define QK_MOMENTARY 0x5220
+#define QK_MOMENTARY_MAX 0x523F
+#define QK_TAP_DANCE 0x5700
+#define QK_TAP_DANCE_MAX 0x57FF
+#define QK_BOOT 0x7C00
+#define QK_CAPS_WORD_TOGGLE 0x7C73
+#define QK_USER 0x7E40
+#define SAFE_RANGE QK_USER
+
+#define CW_TOGG QK_CAPS_WORD_TOGGLE
+
+#define IS_BASIC_KEYCODE(kc) ((kc) >= KC_A && (kc) <= 0x00DF)
+#define IS_MODIFIER_KEYCODE(kc) ((kc) >= KC_LEFT_CTRL && (kc) <= KC_RIGHT_GUI)
+#define IS_QK_MODS(kc) ((kc) >= QK_MODS && (kc) <= QK_MODS_MAX)
+#define IS_QK_MOD_TAP(kc) ((kc) >= QK_MOD_TAP && (kc) <= QK_MOD_TAP_MAX)
+#define IS_QK_LAYER_TAP(kc) ((kc) >= QK_LAYER_TAP && (kc) <= QK_LAYER_TAP_MAX)
+#define IS_QK_MOMENTARY(kc) ((kc) >= QK_MOMENTARY && (kc) <= QK_MOMENTARY_MAX)
+#define IS_QK_TAP_DANCE(kc) ((kc) >= QK_TAP_DANCE && (kc) <= QK_TAP_DANCE_MAX)
+
+#define QK_MODS_GET_MODS(kc) (((kc) >> 8) & 0x1F)
+#define QK_MODS_GET_BASIC_KEYCODE(kc) ((kc) & 0xFF)
+#define QK_MOD_TAP_GET_MODS(kc) (((kc) >> 8) & 0x1F)
+#define QK_MOD_TAP_GET_TAP_KEYCODE(kc) ((kc) & 0xFF)
+#define QK_LAYER_TAP_GET_LAYER(kc) (((kc) >> 8) & 0x0F)
+#define QK_LAYER_TAP_GET_TAP_KEYCODE(kc) ((kc) & 0xFF)
+#define QK_MOMENTARY_GET_LAYER(kc) ((kc) & 0x1F)
+#define QK_TAP_DANCE_GET_INDEX(kc) ((kc) & 0xFF)
+
+#define QK_LCTL 0x0100
+#define QK_LSFT 0x0200
+#define LCTL(kc) (QK_LCTL | (kc))
+#define LSFT(kc) (QK_LSFT | (kc))
+#define S(kc) LSFT(kc)
+#define MT(mod, kc) (QK_MOD_TAP | (((mod) & 0x1F) << 8) | ((kc) & 0xFF))
+#define ALL_T(kc) MT(MOD_HYPR, kc)
+#define LT(layer, kc) (QK_LAYER_TAP | (((layer) & 0x0F) << 8) | ((kc) & 0xFF))
+#define MO(layer) (QK_MOMENTARY | ((layer) & 0x1F))
+#define TD(n) (QK_TAP_DANCE | ((n) & 0xFF))
+
+#define KC_EXLM S(KC_1)
+#define KC_AT S(KC_2)
+#define KC_HASH S(KC_3)
+#define KC_DLR S(KC_4)
+#define KC_PERC S(KC_5)
+#define KC_CIRC S(KC_6)
+#define KC_AMPR S(KC_7)
+#define KC_ASTR S(KC_8)
+#define KC_LPRN S(KC_9)
+#define KC_RPRN S(KC_0)
+#define KC_UNDS S(KC_MINUS)
+#define KC_PLUS S(KC_EQUAL)
+#define KC_LCBR S(KC_LEFT_BRACKET)
+#define KC_RCBR S(KC_RIGHT_BRACKET)
+#define KC_PIPE S(KC_BACKSLASH)
+#define KC_COLN S(KC_SEMICOLON)
+#define KC_DQUO S(KC_QUOTE)
+#define KC_TILD S(KC_GRAVE)
+#define KC_QUES S(KC_SLASH)
+
+static inline uint8_t mod_config(uint8_t mod) { return mod; }
+
+/* Events and records ------------------------------------------------------ */
+
+typedef struct {
+  uint8_t col;
+  uint8_t row;
+} keypos_t;
+
+typedef enum {
+  TICK_EVENT = 0,
+  KEY_EVENT = 1,
+  ENCODER_CW_EVENT = 2,
+  ENCODER_CCW_EVENT = 3,
+  COMBO_EVENT = 4,
+} keyevent_type_t;
+
+typedef struct {
+  keypos_t key;
+  uint16_t time;
+  keyevent_type_t type;
+  bool pressed;
+} keyevent_t;
+
+typedef struct {
+  bool interrupted : 1;
+  bool reserved2 : 1;
+  bool reserved1 : 1;
+  bool reserved0 : 1;
+  uint8_t count : 4;
+} tap_t;
+
+typedef struct {
+  keyevent_t event;
+  tap_t tap;
+  uint16_t keycode;
+} keyrecord_t;
+
+#define IS_KEYEVENT(event) ((event).type == KEY_EVENT)
+#define KEYEQ(k1, k2) ((k1).row == (k2).row && (k1).col == (k2).col)
+
+typedef union {
+  uint16_t code;
+} action_t;
+
+enum {
+  ACT_LMODS = 0x0,
+  ACT_RMODS = 0x1,
+  ACT_LMODS_TAP = 0x2,
+  ACT_RMODS_TAP = 0x3,
+  ACT_LAYER_TAP = 0xA,
+};
+
+#define ACTION(kind, param) ((kind) << 12 | (param))
+#define ACTION_MODS_KEY(mods, key) \
+  ACTION(((mods) & 0x10) ? ACT_RMODS : ACT_LMODS, ((mods) & 0xF) << 8 | (key))
+#define ACTION_MODS(mods) ACTION_MODS_KEY(mods, 0)
+#define ACTION_MODS_TAP_KEY(mods, key)                           \
+  ACTION(((mods) & 0x10) ? ACT_RMODS_TAP : ACT_LMODS_TAP,        \
+         ((mods) & 0xF) << 8 | (key))
+#define ACTION_LAYER_TAP_KEY(layer, key) \
+  ACTION(ACT_LAYER_TAP, ((layer) & 0xF) << 8 | (key))
+
+void action_exec(keyevent_t event);
+void process_record(keyrecord_t* record);
+void process_action(keyrecord_t* record, action_t action);
+uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
+uint16_t keycode_at_keymap_location(uint8_t layer, uint8_t row, uint8_t col);
+uint8_t keymap_layer_count(void);
+
+/* Reports and mods -------------------------------------------------------- */
+
+#define KEYBOARD_REPORT_KEYS 6
+
+typedef struct {
+  uint8_t mods;
+  uint8_t reserved;
+  uint8_t keys[KEYBOARD_REPORT_KEYS];
+} report_keyboard_t;
+
+uint8_t get_mods(void);
+void add_mods(uint8_t mods);
+void del_mods(uint8_t mods);
+void register_mods(uint8_t mods);
+void unregister_mods(uint8_t mods);
+uint8_t get_weak_mods(void);
+void add_weak_mods(uint8_t mods);
+void del_weak_mods(uint8_t mods);
+void clear_weak_mods(void);
+void register_code(uint8_t code);
+void unregister_code(uint8_t code);
+void register_code16(uint16_t code);
+void unregister_code16(uint16_t code);
+#ifndef TAP_CODE_DELAY
+#define TAP_CODE_DELAY 0
+#endif
+void tap_code(uint8_t code);
+void tap_code16(uint16_t code);
+void send_keyboard_report(void);
+
+/* Layers ------------------------------------------------------------------ */
+
+#ifdef LAYER_STATE_8BIT
+typedef uint8_t layer_state_t;
+#else
+typedef uint32_t layer_state_t;
+#endif
+
+extern layer_state_t layer_state;
+extern layer_state_t default_layer_state;
+void layer_on(uint8_t layer);
+void layer_off(uint8_t layer);
+bool layer_state_is(uint8_t layer);
+uint8_t get_highest_layer(layer_state_t state);
+#define biton32(state) get_highest_layer(state)
+
+/* Timer ------------------------------------------------------------------- */
+
+uint16_t timer_read(void);
+uint32_t timer_read32(void);
+#define TIMER_DIFF_16(a, b) ((uint16_t)((a) - (b)))
+#define TIMER_DIFF_32(a, b) ((uint32_t)((a) - (b)))
+#define timer_elapsed(last) TIMER_DIFF_16(timer_read(), last)
+#define timer_elapsed32(last) TIMER_DIFF_32(timer_read32(), last)
+#define timer_expired(current, future) \
+  ((uint16_t)((current) - (future)) < UINT16_MAX / 2)
+#define timer_expired32(current, future) \
+  ((uint32_t)((current) - (future)) < UINT32_MAX / 2)
+void wait_ms(uint16_t ms);
+
+#ifndef TAPPING_TERM
+#define TAPPING_TERM 200
+#endif
+uint16_t get_tapping_term(uint16_t keycode, keyrecord_t* record);
+
+/* Features ---------------------------------------------------------------- */
+
+#define dprintln(s)
+#define dprintf(...)
+
+bool is_caps_word_on(void);
+void caps_word_on(void);
+void caps_word_off(void);
+
+typedef struct {
+  uint16_t interrupting_keycode;
+  uint16_t timer;
+  uint8_t count;
+  uint8_t weak_mods;
+  bool pressed : 1;
+  bool finished : 1;
+  bool interrupted : 1;
+} tap_dance_state_t;
+
+typedef void (*tap_dance_user_fn_t)(tap_dance_state_t* state, void* user_data);
+
+typedef struct {
+  tap_dance_state_t state;
+  struct {
+    tap_dance_user_fn_t on_each_tap;
+    tap_dance_user_fn_t on_dance_finished;
+    tap_dance_user_fn_t on_reset;
+    tap_dance_user_fn_t on_each_release;
+  } fn;
+  void* user_data;
+} tap_dance_action_t;
+
+#define ACTION_TAP_DANCE_FN_ADVANCED(on_each, finished, reset) \
+  { .fn = {on_each, finished, reset, NULL}, .user_data = NULL }
+
+extern tap_dance_action_t tap_dance_actions[];
+
+/* RGB Matrix and Oryx ----------------------------------------------------- */
+
+typedef struct {
+  uint8_t h;
+  uint8_t s;
+  uint8_t v;
+} HSV;
+
+typedef struct {
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+} RGB;
+
+typedef struct {
+  uint8_t enable : 2;
+  uint8_t mode : 6;
+  HSV hsv;
+  uint8_t speed;
+  uint8_t flags;
+} rgb_config_t;
+
+#define LED_FLAG_NONE 0x00
+#define LED_FLAG_ALL 0xFF
+
+RGB hsv_to_rgb(HSV hsv);
+void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue);
+void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue);
+uint8_t rgb_matrix_get_flags(void);
+void rgb_matrix_enable(void);
+void rgblight_mode(uint8_t mode);
+
+typedef struct {
+  bool paired;
+  bool rgb_control;
+  bool status_led_control;
+} rawhid_state_t;
+
+extern rawhid_state_t rawhid_state;
+
+typedef struct {
+  bool disable_layer_led;
+} keyboard_config_t;
+
+extern keyboard_config_t keyboard_config;
+
+#define LED_LEVEL 0
+
+/* Keymap ------------------------------------------------------------------ */
+
+extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
+
+// Physical layout in LED order: four rows of 6 + 2 thumb keys per half, left
+// half first. The matrix positions mirror Voyager's split across rows 0-5 and
+// 6-11; scripts/gen_trace.py uses the same table.
+// clang-format off
+#define LAYOUT_voyager(                                                      \
+    k00, k01, k02, k03, k04, k05,   k06, k07, k08, k09, k10, k11,           \
+    k12, k13, k14, k15, k16, k17,   k18, k19, k20, k21, k22, k23,           \
+    k24, k25, k26, k27, k28, k29,   k30, k31, k32, k33, k34, k35,           \
+    k36, k37, k38, k39, k40, k41,   k42, k43, k44, k45, k46, k47,           \
+                   k48, k49,             k50, k51)                          \
+  {                                                                         \
+    {KC_NO, k00, k01, k02, k03, k04, k05},                                  \
+    {KC_NO, k12, k13, k14, k15, k16, k17},                                  \
+    {KC_NO, k24, k25, k26, k27, k28, k29},                                  \
+    {KC_NO, k36, k37, k38, k39, k40, k41},                                  \
+    {k48, k49, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},                          \
+    {KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},                      \
+    {k06, k07, k08, k09, k10, k11, KC_NO},                                  \
+    {k18, k19, k20, k21, k22, k23, KC_NO},                                  \
+    {k30, k31, k32, k33, k34, k35, KC_NO},                                  \
+    {k42, k43, k44, k45, k46, k47, KC_NO},                                  \
+    {KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, k50, k51},                          \
+    {KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},                      \
+  }
+// clang-format on
+
+#ifdef __cplusplus
+}
+#endif
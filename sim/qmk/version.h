@@ -0,0 +1,6 @@
+/**
+ * @file version.h
+ * @brief Host stand-in for QMK's generated version.h.
+ */
+
+#pragma once
@@ -0,0 +1,186 @@
+/**
+ * @file replay.c
+ * @brief Replays a key event trace through the simulator.
+ *
+ * Usage: sim_replay [--policy achordion|core] [--flow-tap-term MS]
+ *                   [--no-chordal-hold] [--timeout MS]
+ *                   [--streak CLASS=MS,...] [--max-streak-timeout MS]
+ *                   [--eager-mods MODS] [--overlap PERCENT]
+ *                   [--strokes FILE] [--tick-cpu] [--write-binary FILE]
+ *                   TRACE
+ *
+ * Prints the statistics of sim.h as JSON, with the host CPU time spent per
+ * event and the replay throughput. See scripts/compare_tap_hold.py for
+ * comparing policies. --write-binary converts TRACE to the binary format
+ * instead of replaying it.
+ *
+ * --timeout, --streak, --max-streak-timeout, --eager-mods and --overlap
+ * replace the keymap's Achordion settings (sim_achordion_params_t), for
+ * scripts/sweep.py. --streak takes the classes ctrl, shift, alt, gui and
+ * layer. --eager-mods takes letters c, s, a and g for the left hand mods, in
+ * upper case for the right hand, or "none". --overlap settles tap-hold keys
+ * at the other key's release (ACHORDION_OVERLAP) with the given threshold,
+ * or at its press if 0.
+ *
+ * --tick-cpu also times each simulated millisecond of the main loop, and
+ * prints the mean per idle state (features/idle.h) under "idle".
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sim.h"
+#include "trace.h"
+
+static void usage(void) {
+  fprintf(stderr,
+          "usage: sim_replay [--policy achordion|core] [--flow-tap-term MS]\n"
+          "                  [--no-chordal-hold] [--timeout MS]\n"
+          "                  [--streak CLASS=MS,...] [--max-streak-timeout MS]\n"
+          "                  [--eager-mods MODS] [--overlap PERCENT]\n"
+          "                  [--strokes FILE] [--tick-cpu]\n"
+          "                  [--write-binary FILE] TRACE\n");
+  exit(2);
+}
+
+// Parses "ctrl=300,shift=0,..." into `params`.
+static bool parse_streak(char* arg, sim_achordion_params_t* params) {
+  static const char* const classes[SIM_STREAK_CLASSES] = {
+      [SIM_STREAK_CTRL] = "ctrl", [SIM_STREAK_SHIFT] = "shift",
+      [SIM_STREAK_ALT] = "alt",   [SIM_STREAK_GUI] = "gui",
+      [SIM_STREAK_LAYER] = "layer",
+  };
+  for (char* item = strtok(arg, ","); item; item = strtok(NULL, ",")) {
+    char* value = strchr(item, '=');
+    if (!value) {
+      return false;
+    }
+    *value++ = '\0';
+    int c = 0;
+    while (c < SIM_STREAK_CLASSES && strcmp(item, classes[c])) {
+      ++c;
+    }
+    if (c == SIM_STREAK_CLASSES) {
+      return false;
+    }
+    params->streak_timeout[c] = atoi(value);
+  }
+  return true;
+}
+
+// Parses a set of mods such as "csag" or "none" into 8-bit mods.
+static bool parse_mods(const char* arg, uint16_t* mods) {
+  static const char letters[] = "csag";
+  *mods = 0;
+  if (!strcmp(arg, "none")) {
+    return true;
+  }
+  for (; *arg; ++arg) {
+    const char* letter = strchr(letters, *arg | 0x20);
+    if (!letter || !*letter) {
+      return false;
+    }
+    const uint8_t bit = 1 << (letter - letters);
+    *mods |= (*arg & 0x20) ? bit : bit << 4;
+  }
+  return true;
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char** argv) {
+  sim_options_t options = {
+      .policy = SIM_POLICY_ACHORDION,
+      .flow_tap_term = 0xFFFF,  // Default term.
+      .chordal_hold = true,
+  };
+  sim_achordion_params_t achordion;
+  memset(&achordion, 0xFF, sizeof(achordion));  // SIM_KEYMAP throughout.
+  const char* strokes_path = NULL;
+  const char* binary_path = NULL;
+  const char* trace_path = NULL;
+
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--policy") && i + 1 < argc) {
+      const char* policy = argv[++i];
+      if (!strcmp(policy, "achordion")) {
+        options.policy = SIM_POLICY_ACHORDION;
+      } else if (!strcmp(policy, "core")) {
+        options.policy = SIM_POLICY_CORE;
+      } else {
+        usage();
+      }
+    } else if (!strcmp(argv[i], "--flow-tap-term") && i + 1 < argc) {
+      options.flow_tap_term = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--no-chordal-hold")) {
+      options.chordal_hold = false;
+    } else if (!strcmp(argv[i], "--timeout") && i + 1 < argc) {
+      achordion.timeout = atoi(argv[++i]);
+      options.achordion = &achordion;
+    } else if (!strcmp(argv[i], "--streak") && i + 1 < argc) {
+      if (!parse_streak(argv[++i], &achordion)) {
+        usage();
+      }
+      options.achordion = &achordion;
+    } else if (!strcmp(argv[i], "--max-streak-timeout") && i + 1 < argc) {
+      achordion.max_streak_timeout = atoi(argv[++i]);
+      options.achordion = &achordion;
+    } else if (!strcmp(argv[i], "--eager-mods") && i + 1 < argc) {
+      if (!parse_mods(argv[++i], &achordion.eager_mods)) {
+        usage();
+      }
+      options.achordion = &achordion;
+    } else if (!strcmp(argv[i], "--overlap") && i + 1 < argc) {
+      achordion.overlap_percent = atoi(argv[++i]);
+      options.achordion = &achordion;
+    } else if (!strcmp(argv[i], "--strokes") && i + 1 < argc) {
+      strokes_path = argv[++i];
+    } else if (!strcmp(argv[i], "--tick-cpu")) {
+      options.time_ticks = true;
+    } else if (!strcmp(argv[i], "--write-binary") && i + 1 < argc) {
+      binary_path = argv[++i];
+    } else if (argv[i][0] != '-' && !trace_path) {
+      trace_path = argv[i];
+    } else {
+      usage();
+    }
+  }
+  if (!trace_path) {
+    usage();
+  }
+
+  trace_t trace;
+  if (!trace_open(trace_path, &trace)) {
+    return 1;
+  }
+  if (binary_path) {
+    const bool ok = trace_write_binary(&trace, binary_path);
+    trace_close(&trace);
+    return ok ? 0 : 1;
+  }
+  if (strokes_path && !(options.strokes = fopen(strokes_path, "w"))) {
+    perror(strokes_path);
+    return 1;
+  }
+
+  const size_t events = trace_num_events(&trace);
+  sim_init(&options);
+  const double start = now_ns();
+  trace_replay(&trace);
+  sim_finish();
+  const double elapsed = now_ns() - start;
+
+  sim_write_json(stdout, events ? elapsed / events : 0.0);
+  if (options.strokes) {
+    fclose(options.strokes);
+  }
+  trace_close(&trace);
+  return 0;
+}
@@ -0,0 +1,1177 @@
+/**
+ * @file sim.c
+ * @brief Host model of QMK's key record pipeline for the eZrPW keymap.
+ */
+
+#include "sim.h"
+
+#include <time.h>
+
+#include "features/achordion.h"
+#include "features/idle.h"
+#include "features/latency_trace.h"
+#include "features/user_hid.h"
+#include "quantum.h"
+
+#define NUM_KEYS (MATRIX_ROWS * MATRIX_COLS)
+#define WAITING_BUFFER_SIZE 8
+#define CAPS_WORD_IDLE_TIMEOUT 5000
+#define DEFAULT_FLOW_TAP_TERM 150
+
+static sim_options_t options;
+static sim_achordion_params_t achordion_params;
+static sim_stats_t stats;
+static uint32_t now = 0;
+
+/* Stand-ins for QMK and Oryx globals ------------------------------------- */
+
+layer_state_t layer_state = 0;
+layer_state_t default_layer_state = 1;
+rgb_config_t rgb_matrix_config = {.enable = 1, .hsv = {0, 255, 255}};
+rawhid_state_t rawhid_state;
+keyboard_config_t keyboard_config;
+
+uint16_t timer_read(void) { return (uint16_t)now; }
+uint32_t timer_read32(void) { return now; }
+void wait_ms(uint16_t ms) { now += ms; }
+
+uint32_t sim_time(void) { return now; }
+const sim_stats_t* sim_stats(void) { return &stats; }
+
+/* Weak user hooks, for keymaps that leave them out ------------------------ */
+
+__attribute__((weak)) void keyboard_post_init_user(void) {}
+__attribute__((weak)) void housekeeping_task_user(void) {}
+__attribute__((weak)) bool pre_process_record_user(uint16_t keycode,
+                                                   keyrecord_t* record) {
+  return true;
+}
+__attribute__((weak)) bool process_record_user(uint16_t keycode,
+                                               keyrecord_t* record) {
+  return true;
+}
+__attribute__((weak)) bool rgb_matrix_indicators_user(void) { return true; }
+__attribute__((weak)) uint16_t get_tapping_term(uint16_t keycode,
+                                                keyrecord_t* record) {
+  return TAPPING_TERM;
+}
+
+/* RGB Matrix -------------------------------------------------------------- */
+
+static RGB leds[RGB_MATRIX_LED_COUNT];
+
+RGB hsv_to_rgb(HSV hsv) {
+  // QMK's integer HSV to RGB conversion.
+  if (hsv.s == 0) {
+    return (RGB){hsv.v, hsv.v, hsv.v};
+  }
+  const uint8_t region = hsv.h / 43;
+  const uint8_t remainder = (hsv.h - (region * 43)) * 6;
+  const uint8_t p = (hsv.v * (255 - hsv.s)) >> 8;
+  const uint8_t q = (hsv.v * (255 - ((hsv.s * remainder) >> 8))) >> 8;
+  const uint8_t t = (hsv.v * (255 - ((hsv.s * (255 - remainder)) >> 8))) >> 8;
+  switch (region) {
+    case 6:
+    case 0:
+      return (RGB){hsv.v, t, p};
+    case 1:
+      return (RGB){q, hsv.v, p};
+    case 2:
+      return (RGB){p, hsv.v, t};
+    case 3:
+      return (RGB){p, q, hsv.v};
+    case 4:
+      return (RGB){t, p, hsv.v};
+    default:
+      return (RGB){hsv.v, p, q};
+  }
+}
+
+void rgb_matrix_set_color(int index, uint8_t red, uint8_t green,
+                          uint8_t blue) {
+  if (index >= 0 && index < RGB_MATRIX_LED_COUNT) {
+    leds[index] = (RGB){red, green, blue};
+  }
+}
+
+void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
+  for (int i = 0; i < RGB_MATRIX_LED_COUNT; ++i) {
+    leds[i] = (RGB){red, green, blue};
+  }
+}
+
+uint8_t rgb_matrix_get_flags(void) { return LED_FLAG_ALL; }
+void rgb_matrix_enable(void) { rgb_matrix_config.enable = 1; }
+void rgblight_mode(uint8_t mode) {}
+
+/* Keymap and layers ------------------------------------------------------- */
+
+// Layer each key was pressed on, as QMK's source layers cache keeps it. The
+// release looks the keycode up again on that layer.
+static uint8_t source_layers[NUM_KEYS];
+
+static uint8_t key_index(keypos_t key) {
+  return key.row * MATRIX_COLS + key.col;
+}
+
+uint16_t keycode_at_keymap_location(uint8_t layer, uint8_t row, uint8_t col) {
+  return keymaps[layer][row][col];
+}
+
+__attribute__((weak)) uint16_t keymap_key_to_keycode(uint8_t layer,
+                                                     keypos_t key) {
+  return keycode_at_keymap_location(layer, key.row, key.col);
+}
+
+uint8_t get_highest_layer(layer_state_t state) {
+  for (int8_t layer = sizeof(layer_state_t) * 8 - 1; layer > 0; --layer) {
+    if (state & ((layer_state_t)1 << layer)) {
+      return layer;
+    }
+  }
+  return 0;
+}
+
+// Model of layer_switch_get_layer(): the highest active layer on which `key`
+// is not transparent.
+static uint8_t switch_layer(keypos_t key) {
+  for (int8_t layer = keymap_layer_count() - 1; layer > 0; --layer) {
+    if ((layer_state & ((layer_state_t)1 << layer)) &&
+        keymap_key_to_keycode(layer, key) != KC_TRANSPARENT) {
+      return layer;
+    }
+  }
+  return 0;
+}
+
+static uint16_t lookup_keycode(keypos_t key) {
+  return keymap_key_to_keycode(switch_layer(key), key);
+}
+
+// Model of get_event_keycode(): a press is looked up on the active layers,
+// and stores its layer if `update_cache`, and a release on the stored layer.
+static uint16_t event_keycode(keyevent_t event, bool update_cache) {
+  const uint8_t i = key_index(event.key);
+  if (!event.pressed) {
+    return keymap_key_to_keycode(source_layers[i], event.key);
+  }
+  const uint8_t layer = switch_layer(event.key);
+  if (update_cache) {
+    source_layers[i] = layer;
+  }
+  return keymap_key_to_keycode(layer, event.key);
+}
+
+/* Press tracking ---------------------------------------------------------- */
+
+typedef struct {
+  bool active;
+  uint8_t cls;
+  int8_t intent;
+  // Physical press time and time of the latest action the press caused.
+  uint32_t time;
+  uint32_t effect_time;
+  bool effect;
+  bool tapped;
+  bool held;
+  // Whether the press woke the keyboard from IDLE_STATE_ASLEEP.
+  bool woke;
+} press_track_t;
+
+static press_track_t presses[NUM_KEYS];
+// Key whose press is responsible for the actions being executed, or -1.
+static int16_t effect_key = -1;
+
+static uint8_t classify(uint16_t keycode) {
+  if (IS_QK_MOD_TAP(keycode)) {
+    return LATENCY_MOD_TAP;
+  } else if (IS_QK_LAYER_TAP(keycode)) {
+    return LATENCY_LAYER_TAP;
+  } else if (IS_QK_TAP_DANCE(keycode)) {
+    return LATENCY_TAP_DANCE;
+  }
+  return LATENCY_PLAIN;
+}
+
+static void mark_effect(void) {
+  if (effect_key >= 0 && presses[effect_key].active) {
+    presses[effect_key].effect = true;
+    presses[effect_key].effect_time = now;
+  }
+}
+
+static void close_press(uint8_t i) {
+  press_track_t* p = &presses[i];
+  if (!p->active) {
+    return;
+  }
+  p->active = false;
+  if (p->effect) {
+    sim_latency_t* l = &stats.latency[p->cls];
+    const uint32_t ms = p->effect_time - p->time;
+    ++l->count;
+    l->sum_ms += ms;
+    if (ms > l->max_ms) {
+      l->max_ms = ms;
+    }
+    ++l->hist[ms < SIM_LATENCY_MAX_MS ? ms : SIM_LATENCY_MAX_MS];
+    if (p->woke && ms > stats.max_wake_ms) {
+      stats.max_wake_ms = ms;
+    }
+  }
+  if (p->intent != SIM_INTENT_NONE && (p->tapped || p->held)) {
+    ++stats.intended;
+    // A tap settled after eager mods were applied still counts as a tap.
+    if (p->tapped && p->intent == SIM_INTENT_HOLD) {
+      ++stats.false_taps;
+    } else if (!p->tapped && p->intent == SIM_INTENT_TAP) {
+      ++stats.false_holds;
+    }
+  }
+}
+
+/* Mods and the HID report ------------------------------------------------- */
+
+static uint8_t real_mods = 0;
+static uint8_t weak_mods = 0;
+// Keys in the report. As in QMK's report, a key is in it or not, however
+// many times it was registered.
+static bool keys_down[256];
+static uint8_t sent_mods = 0;
+static bool sent_keys[256];
+
+uint8_t get_mods(void) { return real_mods; }
+void add_mods(uint8_t mods) { real_mods |= mods; }
+void del_mods(uint8_t mods) { real_mods &= ~mods; }
+uint8_t get_weak_mods(void) { return weak_mods; }
+void add_weak_mods(uint8_t mods) { weak_mods |= mods; }
+void del_weak_mods(uint8_t mods) { weak_mods &= ~mods; }
+void clear_weak_mods(void) { weak_mods = 0; }
+
+static const char* const key_names[256] = {
+    [KC_ENTER] = "<ENT>", [KC_ESCAPE] = "<ESC>", [KC_BACKSPACE] = "<BSPC>",
+    [KC_TAB] = "<TAB>", [KC_SPACE] = "<SPC>", [KC_DELETE] = "<DEL>", [KC_RIGHT] = "<RIGHT>",
+    [KC_LEFT] = "<LEFT>", [KC_DOWN] = "<DOWN>", [KC_UP] = "<UP>",
+    [KC_NUM_LOCK] = "<NUM>", [KC_CAPS_LOCK] = "<CAPS>",
+    [KC_AUDIO_MUTE] = "<MUTE>", [KC_AUDIO_VOL_UP] = "<VOLU>",
+    [KC_AUDIO_VOL_DOWN] = "<VOLD>", [KC_MEDIA_NEXT_TRACK] = "<NEXT>",
+    [KC_MEDIA_PLAY_PAUSE] = "<PLAY>",
+};
+
+// US layout characters for the printable basic keycodes, unshifted and
+// shifted, indexed from KC_1.
+static const char digits_and_symbols[][2] = {
+    {'1', '!'}, {'2', '@'}, {'3', '#'}, {'4', '$'}, {'5', '%'}, {'6', '^'},
+    {'7', '&'}, {'8', '*'}, {'9', '('}, {'0', ')'}, {0, 0},     {0, 0},
+    {0, 0},     {0, 0},     {0, 0},     {'-', '_'}, {'=', '+'}, {'[', '{'},
+    {']', '}'}, {'\\', '|'}, {0, 0},    {';', ':'}, {'\'', '"'}, {'`', '~'},
+    {',', '<'}, {'.', '>'}, {'/', '?'},
+};
+
+// Writes a stroke as the text it types, or as <mods-key> for shortcuts.
+static void write_stroke(uint8_t code, uint8_t mods) {
+  FILE* out = options.strokes;
+  const bool shift = mods & MOD_MASK_SHIFT;
+  char c = 0;
+  if (code >= KC_A && code <= KC_Z) {
+    c = (shift ? 'A' : 'a') + (code - KC_A);
+  } else if (code >= KC_1 && code <= KC_SLASH) {
+    c = digits_and_symbols[code - KC_1][shift];
+  }
+  fprintf(out, "%u ", now);
+  if (mods & ~MOD_MASK_SHIFT || !c) {
+    fputc('<', out);
+    if (mods & MOD_MASK_CTRL) fputs("C-", out);
+    if (mods & MOD_MASK_ALT) fputs("A-", out);
+    if (mods & MOD_MASK_GUI) fputs("G-", out);
+    if (mods & MOD_MASK_SHIFT) fputs("S-", out);
+    if (c) {
+      fputc(shift && code >= KC_A && code <= KC_Z ? c + ('a' - 'A') : c, out);
+    } else if (key_names[code]) {
+      const char* name = key_names[code];
+      fprintf(out, "%.*s", (int)strlen(name) - 2, name + 1);
+    } else {
+      fprintf(out, "0x%02X", code);
+    }
+    fputs(">\n", out);
+  } else {
+    fprintf(out, "%c\n", c);
+  }
+}
+
+void send_keyboard_report(void) {
+  const uint8_t mods = real_mods | weak_mods;
+  bool changed = mods != sent_mods;
+  for (int code = 0; code < 256; ++code) {
+    const bool down = keys_down[code];
+    if (down != sent_keys[code]) {
+      changed = true;
+      if (down) {
+        ++stats.strokes;
+        if (options.strokes) {
+          write_stroke(code, mods);
+        }
+      }
+      sent_keys[code] = down;
+    }
+  }
+  sent_mods = mods;
+  if (changed) {
+    ++stats.reports;
+  }
+}
+
+void register_mods(uint8_t mods) {
+  if (mods) {
+    add_mods(mods);
+    mark_effect();
+    send_keyboard_report();
+  }
+}
+
+void unregister_mods(uint8_t mods) {
+  if (mods) {
+    del_mods(mods);
+    send_keyboard_report();
+  }
+}
+
+void register_code(uint8_t code) {
+  if (code == KC_NO) {
+    return;
+  }
+  mark_effect();
+  if (IS_MODIFIER_KEYCODE(code)) {
+    add_mods(MOD_BIT(code));
+  } else {
+    keys_down[code] = true;
+  }
+  send_keyboard_report();
+}
+
+void unregister_code(uint8_t code) {
+  if (code == KC_NO) {
+    return;
+  }
+  if (IS_MODIFIER_KEYCODE(code)) {
+    del_mods(MOD_BIT(code));
+  } else {
+    keys_down[code] = false;
+  }
+  send_keyboard_report();
+}
+
+// Converts 5-bit `MOD_` bits to 8-bit report mods.
+static uint8_t mod_bits(uint8_t mods) {
+  return (mods & 0x10) ? (mods & 0x0F) << 4 : mods;
+}
+
+void register_code16(uint16_t code) {
+  if (IS_QK_MODS(code)) {
+    add_weak_mods(mod_bits(QK_MODS_GET_MODS(code)));
+  }
+  register_code(code & 0xFF);
+}
+
+void unregister_code16(uint16_t code) {
+  unregister_code(code & 0xFF);
+  if (IS_QK_MODS(code)) {
+    del_weak_mods(mod_bits(QK_MODS_GET_MODS(code)));
+    send_keyboard_report();
+  }
+}
+
+void tap_code(uint8_t code) {
+  register_code(code);
+  unregister_code(code);
+}
+
+void tap_code16(uint16_t code) {
+  register_code16(code);
+  unregister_code16(code);
+}
+
+void layer_on(uint8_t layer) {
+  mark_effect();
+  layer_state |= (layer_state_t)1 << layer;
+}
+
+void layer_off(uint8_t layer) { layer_state &= ~((layer_state_t)1 << layer); }
+
+bool layer_state_is(uint8_t layer) {
+  return layer_state ? (layer_state >> layer) & 1 : layer == 0;
+}
+
+/* Caps Word --------------------------------------------------------------- */
+
+static bool caps_word_active = false;
+static uint16_t caps_word_timer = 0;
+
+bool is_caps_word_on(void) { return caps_word_active; }
+
+void caps_word_on(void) {
+  caps_word_active = true;
+  caps_word_timer = timer_read();
+}
+
+void caps_word_off(void) {
+  caps_word_active = false;
+  clear_weak_mods();
+  send_keyboard_report();
+}
+
+// Model of QMK's process_caps_word() with the default caps_word_press_user().
+static bool process_caps_word(uint16_t keycode, keyrecord_t* record) {
+  if (!caps_word_active || !record->event.pressed ||
+      keycode == QK_CAPS_WORD_TOGGLE) {
+    return true;
+  }
+  if (get_mods() & ~MOD_MASK_SHIFT) {
+    caps_word_off();
+    return true;
+  }
+  caps_word_timer = timer_read();
+
+  if (IS_QK_MOD_TAP(keycode)) {
+    if (record->tap.count == 0) {
+      // Holding a Shift mod-tap continues Caps Word, other mods end it.
+      if (mod_bits(QK_MOD_TAP_GET_MODS(keycode)) & ~MOD_MASK_SHIFT) {
+        caps_word_off();
+      }
+      return true;
+    }
+    keycode = QK_MOD_TAP_GET_TAP_KEYCODE(keycode);
+  } else if (IS_QK_LAYER_TAP(keycode)) {
+    if (record->tap.count == 0) {
+      return true;
+    }
+    keycode = QK_LAYER_TAP_GET_TAP_KEYCODE(keycode);
+  } else if (IS_QK_MOMENTARY(keycode) || IS_QK_TAP_DANCE(keycode) ||
+             keycode == KC_TRANSPARENT || keycode == KC_NO) {
+    return true;
+  }
+
+  clear_weak_mods();
+  if ((keycode >= KC_A && keycode <= KC_Z) || keycode == KC_MINUS) {
+    add_weak_mods(MOD_BIT(KC_LSFT));
+  } else if (!((keycode >= KC_1 && keycode <= KC_0) ||
+               keycode == KC_BACKSPACE || keycode == KC_DELETE ||
+               keycode == KC_UNDS)) {
+    caps_word_off();
+  }
+  return true;
+}
+
+/* Tap dance --------------------------------------------------------------- */
+
+static int16_t td_active = -1;
+static uint16_t td_keycode = KC_NO;
+static int16_t td_key = -1;
+
+static void td_call(tap_dance_user_fn_t fn, tap_dance_action_t* action) {
+  if (fn) {
+    const int16_t saved = effect_key;
+    effect_key = td_key;
+    fn(&action->state, action->user_data);
+    effect_key = saved;
+  }
+}
+
+static void td_reset(tap_dance_action_t* action) {
+  td_call(action->fn.on_reset, action);
+  memset(&action->state, 0, sizeof(action->state));
+  td_active = -1;
+}
+
+static void td_finish(tap_dance_action_t* action) {
+  if (action->state.finished) {
+    return;
+  }
+  action->state.finished = true;
+  td_call(action->fn.on_dance_finished, action);
+  if (!action->state.pressed) {
+    td_reset(action);
+  }
+}
+
+// Any other key press interrupts and finishes the active dance.
+static void preprocess_tap_dance(uint16_t keycode, keyrecord_t* record) {
+  if (td_active >= 0 && record->event.pressed && keycode != td_keycode) {
+    tap_dance_action_t* action = &tap_dance_actions[td_active];
+    action->state.interrupted = true;
+    action->state.interrupting_keycode = keycode;
+    td_finish(action);
+  }
+}
+
+static bool process_tap_dance(uint16_t keycode, keyrecord_t* record) {
+  if (!IS_QK_TAP_DANCE(keycode)) {
+    return true;
+  }
+  const uint8_t index = QK_TAP_DANCE_GET_INDEX(keycode);
+  tap_dance_action_t* action = &tap_dance_actions[index];
+  if (record->event.pressed) {
+    td_active = index;
+    td_keycode = keycode;
+    td_key = key_index(record->event.key);
+    ++action->state.count;
+    action->state.timer = timer_read();
+    action->state.pressed = true;
+    td_call(action->fn.on_each_tap, action);
+  } else {
+    action->state.pressed = false;
+    if (action->state.finished) {
+      td_reset(action);
+    }
+  }
+  return false;
+}
+
+static void tap_dance_task(void) {
+  if (td_active < 0) {
+    return;
+  }
+  tap_dance_action_t* action = &tap_dance_actions[td_active];
+  if (!action->state.finished &&
+      timer_elapsed(action->state.timer) > get_tapping_term(td_keycode, NULL)) {
+    td_finish(action);
+  }
+}
+
+/* Record processing ------------------------------------------------------- */
+
+static uint32_t depth = 0;
+
+static void end_holdback(uint8_t i);
+
+static uint16_t record_keycode(keyrecord_t* record) {
+  if (!IS_KEYEVENT(record->event)) {
+    return record->keycode;
+  }
+  const uint16_t keycode = event_keycode(record->event, true);
+  if (record->event.pressed) {
+    // Classify by the keycode the press resolves to, which for a key pressed
+    // under an unsettled layer-tap key is known only now.
+    presses[key_index(record->event.key)].cls = classify(keycode);
+  }
+  return keycode;
+}
+
+void process_action(keyrecord_t* record, action_t action) {
+  const bool pressed = record->event.pressed;
+  const uint8_t kind = action.code >> 12;
+  const uint8_t key = action.code & 0xFF;
+  const uint8_t mods = ((action.code >> 8) & 0x0F)
+                       << ((kind == ACT_RMODS || kind == ACT_RMODS_TAP) ? 4 : 0);
+  const int16_t saved = effect_key;
+  effect_key = IS_KEYEVENT(record->event) ? key_index(record->event.key) : -1;
+  if (effect_key >= 0 && pressed) {
+    end_holdback(effect_key);
+  }
+  press_track_t* p = effect_key >= 0 ? &presses[effect_key] : NULL;
+
+  switch (kind) {
+    case ACT_LMODS:
+    case ACT_RMODS:
+      if (pressed) {
+        register_mods(mods);
+        register_code(key);
+      } else {
+        unregister_code(key);
+        unregister_mods(mods);
+      }
+      break;
+
+    case ACT_LMODS_TAP:
+    case ACT_RMODS_TAP:
+    case ACT_LAYER_TAP: {
+      const bool tap = record->tap.count > 0;
+      if (pressed && p && p->active) {
+        if (tap) {
+          p->tapped = true;
+        } else {
+          p->held = true;
+        }
+      }
+      if (tap) {
+        if (pressed) {
+          register_code(key);
+        } else {
+          unregister_code(key);
+        }
+      } else if (kind == ACT_LAYER_TAP) {
+        if (pressed) {
+          layer_on((action.code >> 8) & 0x0F);
+        } else {
+          layer_off((action.code >> 8) & 0x0F);
+        }
+      } else if (pressed) {
+        register_mods(mods);
+      } else {
+        unregister_mods(mods);
+      }
+    } break;
+  }
+  effect_key = saved;
+}
+
+static action_t keycode_to_action(uint16_t keycode) {
+  action_t action = {.code = 0};
+  if (IS_BASIC_KEYCODE(keycode) || IS_MODIFIER_KEYCODE(keycode)) {
+    action.code = ACTION_MODS_KEY(0, keycode);
+  } else if (IS_QK_MODS(keycode)) {
+    action.code = ACTION_MODS_KEY(QK_MODS_GET_MODS(keycode),
+                                  QK_MODS_GET_BASIC_KEYCODE(keycode));
+  } else if (IS_QK_MOD_TAP(keycode)) {
+    action.code = ACTION_MODS_TAP_KEY(QK_MOD_TAP_GET_MODS(keycode),
+                                      QK_MOD_TAP_GET_TAP_KEYCODE(keycode));
+  } else if (IS_QK_LAYER_TAP(keycode)) {
+    action.code = ACTION_LAYER_TAP_KEY(QK_LAYER_TAP_GET_LAYER(keycode),
+                                       QK_LAYER_TAP_GET_TAP_KEYCODE(keycode));
+  }
+  return action;
+}
+
+// Model of process_record_quantum(): Caps Word, then the keymap, then tap
+// dance and quantum keycodes. Returns true to run the keycode's action.
+static bool process_record_quantum(uint16_t keycode, keyrecord_t* record) {
+  if (!process_caps_word(keycode, record)) {
+    return false;
+  }
+  preprocess_tap_dance(keycode, record);
+  if (!process_record_user(keycode, record) ||
+      !process_tap_dance(keycode, record)) {
+    return false;
+  }
+  if (keycode == QK_CAPS_WORD_TOGGLE) {
+    if (record->event.pressed) {
+      const int16_t saved = effect_key;
+      effect_key = key_index(record->event.key);
+      mark_effect();
+      effect_key = saved;
+      if (caps_word_active) {
+        caps_word_off();
+      } else {
+        caps_word_on();
+      }
+    }
+    return false;
+  }
+  return keycode < QK_MOMENTARY;
+}
+
+void process_record(keyrecord_t* record) {
+  if (++depth > stats.max_depth) {
+    stats.max_depth = depth;
+  }
+  const uint16_t keycode = record_keycode(record);
+  record->keycode = keycode;
+  // QMK looks the key up again for its action, as store_or_get_action() does.
+  if (process_record_quantum(keycode, record)) {
+    process_action(record,
+                   keycode_to_action(event_keycode(record->event, true)));
+  }
+  --depth;
+}
+
+/* Achordion --------------------------------------------------------------- */
+
+// When Achordion captured a key's press, 0 if it is not holding one back.
+static uint32_t holdback_since[NUM_KEYS];
+static uint16_t holdback_keycode[NUM_KEYS];
+
+// Ends the hold-back of key `i`: Achordion has plumbed an event of the key or
+// applied it as eager mods. The key's release alone does not end it, since
+// under ACHORDION_OVERLAP the key can be released before it is settled.
+static void end_holdback(uint8_t i) {
+  if (!holdback_since[i]) {
+    return;
+  }
+  const uint32_t ms = now - holdback_since[i];
+  holdback_since[i] = 0;
+  if (ms > stats.max_holdback_ms) {
+    stats.max_holdback_ms = ms;
+  }
+  if (ms > achordion_timeout(holdback_keycode[i]) + stats.max_tick_ms) {
+    ++stats.holdback_violations;
+  }
+}
+
+// keymap.c is built with process_achordion() and achordion_task() renamed to
+// these, so the policy can be switched at run time.
+bool sim_process_achordion(uint16_t keycode, keyrecord_t* record) {
+  if (options.policy != SIM_POLICY_ACHORDION) {
+    return true;
+  }
+  if (!IS_KEYEVENT(record->event)) {
+    return process_achordion(keycode, record);
+  }
+  const uint8_t i = key_index(record->event.key);
+  if (depth > 1 || record->event.pressed) {
+    end_holdback(i);
+  }
+  // Only a tap-hold press coming from the tapping layer can be captured.
+  const bool capturable =
+      record->event.pressed && depth == 1 &&
+      (IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode));
+  if (capturable) {
+    holdback_since[i] = now;
+    holdback_keycode[i] = keycode;
+  }
+  const bool result = process_achordion(keycode, record);
+  if (result && capturable) {
+    holdback_since[i] = 0;
+  }
+  return result;
+}
+
+void sim_achordion_task(void) {
+  if (options.policy == SIM_POLICY_ACHORDION) {
+    achordion_task();
+  }
+}
+
+/* Achordion settings ------------------------------------------------------ */
+
+// keymap.c is built with the Achordion callbacks renamed to these, so that
+// sim_achordion_params_t can replace them. Where the keymap does not define
+// one, these weak stand-ins forward to Achordion's defaults.
+
+__attribute__((weak)) uint16_t keymap_achordion_timeout(
+    uint16_t tap_hold_keycode) {
+  return achordion_default_timeout(tap_hold_keycode);
+}
+
+__attribute__((weak)) bool keymap_achordion_eager_mod(uint8_t mod) {
+  return achordion_default_eager_mod(mod);
+}
+
+__attribute__((weak)) uint16_t keymap_achordion_max_streak_timeout(void) {
+  return achordion_default_max_streak_timeout();
+}
+
+__attribute__((weak)) uint16_t keymap_achordion_streak_chord_timeout(
+    uint16_t tap_hold_keycode, uint16_t next_keycode) {
+  return achordion_streak_timeout(tap_hold_keycode);
+}
+
+// Off unless config.h enables it; sim_config.h builds it in regardless.
+__attribute__((weak)) uint8_t keymap_achordion_overlap_percent(
+    uint16_t tap_hold_keycode) {
+#ifdef SIM_ADDED_ACHORDION_OVERLAP
+  return 0;
+#else
+  return ACHORDION_OVERLAP_PERCENT;
+#endif
+}
+
+uint16_t achordion_timeout(uint16_t tap_hold_keycode) {
+  return achordion_params.timeout != SIM_KEYMAP
+             ? achordion_params.timeout
+             : keymap_achordion_timeout(tap_hold_keycode);
+}
+
+bool achordion_eager_mod(uint8_t mod) {
+  if (achordion_params.eager_mods == SIM_KEYMAP) {
+    return keymap_achordion_eager_mod(mod);
+  }
+  // 5-bit mod to 8-bit mods.
+  const uint8_t mods = (mod & 0x10) ? (mod & 0x0F) << 4 : (mod & 0x0F);
+  return mods && (mods & ~achordion_params.eager_mods) == 0;
+}
+
+uint16_t achordion_max_streak_timeout(void) {
+  return achordion_params.max_streak_timeout != SIM_KEYMAP
+             ? achordion_params.max_streak_timeout
+             : keymap_achordion_max_streak_timeout();
+}
+
+uint8_t achordion_overlap_percent(uint16_t tap_hold_keycode) {
+  return achordion_params.overlap_percent != SIM_KEYMAP
+             ? achordion_params.overlap_percent
+             : keymap_achordion_overlap_percent(tap_hold_keycode);
+}
+
+static uint8_t streak_class(uint16_t keycode) {
+  if (IS_QK_LAYER_TAP(keycode)) {
+    return SIM_STREAK_LAYER;
+  }
+  const uint8_t mod = mod_config(QK_MOD_TAP_GET_MODS(keycode));
+  if (mod & MOD_LSFT) {
+    return SIM_STREAK_SHIFT;
+  } else if (mod & MOD_LGUI) {
+    return SIM_STREAK_GUI;
+  } else if (mod & MOD_LALT) {
+    return SIM_STREAK_ALT;
+  }
+  return SIM_STREAK_CTRL;
+}
+
+uint16_t achordion_streak_chord_timeout(uint16_t tap_hold_keycode,
+                                        uint16_t next_keycode) {
+  const uint16_t timeout =
+      achordion_params.streak_timeout[streak_class(tap_hold_keycode)];
+  return timeout != SIM_KEYMAP ? timeout
+                               : keymap_achordion_streak_chord_timeout(
+                                     tap_hold_keycode, next_keycode);
+}
+
+/* Tapping ----------------------------------------------------------------- */
+
+static bool tapping_active = false;
+static keyrecord_t tapping_key;
+static keyrecord_t waiting[WAITING_BUFFER_SIZE];
+static uint8_t num_waiting = 0;
+// Keys whose current press settled as a tap, so their release is a tap too.
+static bool tapped_keys[NUM_KEYS];
+// Time of the last press of a key Flow Tap counts as typing, 0 if none.
+static uint32_t flow_tap_time = 0;
+
+static bool is_tap_hold(uint16_t keycode) {
+  return IS_QK_MOD_TAP(keycode) || IS_QK_LAYER_TAP(keycode);
+}
+
+static bool on_left_hand(keypos_t key) { return key.row < MATRIX_ROWS / 2; }
+
+// Thumb keys are on rows 4 and 10, which Chordal Hold treats as either hand.
+static bool is_thumb(keypos_t key) { return key.row == 4 || key.row == 10; }
+
+// Default `is_flow_tap_key()`: letters, space and common punctuation.
+static bool is_flow_tap_key(uint16_t keycode) {
+  if (is_tap_hold(keycode)) {
+    keycode &= 0xFF;
+  }
+  if (get_mods() & (MOD_MASK_CG | MOD_BIT_LALT)) {
+    return false;
+  }
+  return (keycode >= KC_A && keycode <= KC_Z) || keycode == KC_SPACE ||
+         keycode == KC_DOT || keycode == KC_COMMA || keycode == KC_SEMICOLON ||
+         keycode == KC_SLASH;
+}
+
+static void tapping_feed(keyrecord_t record);
+
+static void flush_waiting(void) {
+  keyrecord_t events[WAITING_BUFFER_SIZE];
+  const uint8_t n = num_waiting;
+  memcpy(events, waiting, n * sizeof(keyrecord_t));
+  num_waiting = 0;
+  for (uint8_t i = 0; i < n; ++i) {
+    tapping_feed(events[i]);
+  }
+}
+
+static void settle_tapping(bool tap) {
+  tapping_active = false;
+  tapping_key.tap.count = tap ? 1 : 0;
+  tapping_key.tap.interrupted = num_waiting > 0;
+  tapped_keys[key_index(tapping_key.event.key)] = tap;
+  process_record(&tapping_key);
+}
+
+static void tapping_feed(keyrecord_t record) {
+  const uint8_t i = key_index(record.event.key);
+
+  if (!tapping_active) {
+    if (record.event.pressed) {
+      const uint16_t keycode = lookup_keycode(record.event.key);
+      const bool flow_tap = options.policy == SIM_POLICY_CORE &&
+                            options.flow_tap_term && flow_tap_time &&
+                            now - flow_tap_time < options.flow_tap_term &&
+                            is_flow_tap_key(keycode);
+      flow_tap_time = is_flow_tap_key(keycode) ? (now | 1) : 0;
+      if (is_tap_hold(keycode)) {
+        tapping_key = record;
+        if (flow_tap) {
+          settle_tapping(true);  // Typing quickly: tap without waiting.
+        } else {
+          tapping_active = true;
+        }
+        return;
+      }
+      tapped_keys[i] = false;
+    } else if (tapped_keys[i]) {
+      record.tap.count = 1;
+    }
+    process_record(&record);
+    return;
+  }
+
+  if (!record.event.pressed && KEYEQ(record.event.key, tapping_key.event.key)) {
+    // Released within the tapping term: a tap.
+    settle_tapping(true);
+    record.tap = tapping_key.tap;
+    process_record(&record);
+    flush_waiting();
+    return;
+  }
+
+  if (num_waiting == WAITING_BUFFER_SIZE) {
+    settle_tapping(false);
+    flush_waiting();
+    tapping_feed(record);
+    return;
+  }
+  waiting[num_waiting++] = record;
+
+  if (record.event.pressed) {
+    const uint16_t keycode = lookup_keycode(record.event.key);
+    if (options.policy == SIM_POLICY_CORE && options.chordal_hold &&
+        !is_tap_hold(keycode) && !is_thumb(record.event.key) &&
+        !is_thumb(tapping_key.event.key) &&
+        on_left_hand(record.event.key) ==
+            on_left_hand(tapping_key.event.key)) {
+      // Chordal Hold: a same-hand key settles the tap-hold key as tapped.
+      settle_tapping(true);
+      flush_waiting();
+    }
+    return;
+  }
+
+#ifdef PERMISSIVE_HOLD
+  // Permissive Hold: a key pressed and released within the tapping key's
+  // hold settles it as held.
+  for (uint8_t j = 0; j + 1 < num_waiting; ++j) {
+    if (waiting[j].event.pressed &&
+        KEYEQ(waiting[j].event.key, record.event.key)) {
+      settle_tapping(false);
+      flush_waiting();
+      return;
+    }
+  }
+#endif
+}
+
+static void tapping_task(void) {
+  if (tapping_active &&
+      TIMER_DIFF_16(timer_read() | 1, tapping_key.event.time) >=
+          get_tapping_term(lookup_keycode(tapping_key.event.key),
+                           &tapping_key)) {
+    settle_tapping(false);
+    flush_waiting();
+  }
+}
+
+/* Main loop --------------------------------------------------------------- */
+
+static uint32_t next_frame = 0;
+static uint32_t last_housekeeping = 0;
+// Time of the last matrix event, which QMK's RGB_MATRIX_TIMEOUT counts from.
+static uint32_t last_matrix_event = 0;
+
+static bool rgb_matrix_timed_out(void) {
+#if defined(RGB_MATRIX_TIMEOUT) && RGB_MATRIX_TIMEOUT > 0
+  return now - last_matrix_event > RGB_MATRIX_TIMEOUT;
+#else
+  return false;
+#endif
+}
+
+static void caps_word_task(void) {
+  if (caps_word_active &&
+      timer_elapsed(caps_word_timer) >= CAPS_WORD_IDLE_TIMEOUT) {
+    caps_word_off();
+  }
+}
+
+static void run_tick(void) {
+  tapping_task();
+  tap_dance_task();
+  caps_word_task();
+  if (now - last_housekeeping > stats.max_tick_ms) {
+    stats.max_tick_ms = now - last_housekeeping;
+  }
+  last_housekeeping = now;
+  housekeeping_task_user();
+  // QMK stops rendering, indicators included, while RGB Matrix is off or
+  // timed out.
+  if (now >= next_frame && rgb_matrix_config.enable &&
+      !rgb_matrix_timed_out()) {
+    rgb_matrix_indicators_user();
+    ++stats.frames;
+    next_frame = now + RGB_FRAME_MS;
+  }
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void tick(void) {
+  const idle_state_t state = idle_state();
+  ++stats.idle_ms[state];
+  if (!options.time_ticks) {
+    run_tick();
+    return;
+  }
+  const uint64_t start = now_ns();
+  run_tick();
+  stats.tick_ns[state] += now_ns() - start;
+}
+
+void sim_run_until(uint32_t time) {
+  while (now < time) {
+    tick();
+    ++now;
+  }
+}
+
+void sim_init(const sim_options_t* opts) {
+  options = *opts;
+  if (options.achordion) {
+    achordion_params = *options.achordion;
+  } else {
+    memset(&achordion_params, 0xFF, sizeof(achordion_params));  // SIM_KEYMAP
+  }
+  options.achordion = &achordion_params;
+  if (options.policy == SIM_POLICY_CORE && options.flow_tap_term == 0xFFFF) {
+    options.flow_tap_term = DEFAULT_FLOW_TAP_TERM;
+  }
+  memset(&stats, 0, sizeof(stats));
+  now = 1;
+
+  // Sources linked in keep their own state, which settles once all keys are
+  // released and timers have run out, as after sim_finish().
+  layer_state = 0;
+  memset(leds, 0, sizeof(leds));
+  memset(source_layers, 0, sizeof(source_layers));
+  memset(presses, 0, sizeof(presses));
+  effect_key = -1;
+  real_mods = weak_mods = sent_mods = 0;
+  memset(keys_down, 0, sizeof(keys_down));
+  memset(sent_keys, 0, sizeof(sent_keys));
+  caps_word_active = false;
+  td_active = td_key = -1;
+  depth = 0;
+  memset(holdback_since, 0, sizeof(holdback_since));
+  tapping_active = false;
+  num_waiting = 0;
+  memset(tapped_keys, 0, sizeof(tapped_keys));
+  flow_tap_time = 0;
+  rgb_matrix_config.enable = 1;
+  next_frame = 0;
+  last_housekeeping = now;
+  last_matrix_event = now;
+
+  keyboard_post_init_user();
+}
+
+void action_exec(keyevent_t event) {
+  keyrecord_t record = {.event = event};
+  if (pre_process_record_user(event_keycode(event, false), &record)) {
+    tapping_feed(record);
+  }
+}
+
+void sim_key_event(uint32_t time, uint8_t row, uint8_t col, bool pressed,
+                   int8_t intent) {
+  sim_run_until(time);
+  const keypos_t key = {.col = col, .row = row};
+  const uint8_t i = key_index(key);
+  ++stats.events;
+  last_matrix_event = now;
+  if (pressed) {
+    ++stats.presses;
+    close_press(i);
+    presses[i] = (press_track_t){
+        .active = true,
+        .intent = intent,
+        .time = time,
+        .woke = idle_state() == IDLE_STATE_ASLEEP,
+    };
+    stats.wakes += presses[i].woke;
+  }
+
+  action_exec((keyevent_t){.key = key,
+                            .time = (uint16_t)(now | 1),
+                            .type = KEY_EVENT,
+                            .pressed = pressed});
+}
+
+void sim_hid_event(uint32_t time, const uint8_t* data, uint8_t length) {
+  sim_run_until(time);
+  uint8_t packet[32] = {0};
+  memcpy(packet, data, length < sizeof(packet) ? length : sizeof(packet));
+  process_raw_hid_user(packet, sizeof(packet));
+}
+
+void sim_finish(void) {
+  // Long enough for every timeout, including Caps Word's.
+  sim_run_until(now + 2 * CAPS_WORD_IDLE_TIMEOUT);
+  for (uint16_t i = 0; i < NUM_KEYS; ++i) {
+    close_press(i);
+  }
+  stats.stuck_keys = __builtin_popcount(real_mods | weak_mods);
+  for (int code = 0; code < 256; ++code) {
+    stats.stuck_keys += keys_down[code];
+  }
+}
+
+/* Output ------------------------------------------------------------------ */
+
+static uint32_t percentile(const sim_latency_t* l, double q) {
+  if (!l->count) {
+    return 0;
+  }
+  const uint64_t target = (uint64_t)(q * l->count);
+  uint64_t seen = 0;
+  for (uint32_t ms = 0; ms <= SIM_LATENCY_MAX_MS; ++ms) {
+    seen += l->hist[ms];
+    if (seen > target) {
+      return ms;
+    }
+  }
+  return SIM_LATENCY_MAX_MS;
+}
+
+void sim_write_json(FILE* out, double cpu_ns_per_event) {
+  static const char* const classes[] = {"plain", "mod_tap", "layer_tap",
+                                        "tap_dance"};
+  fprintf(out,
+          "{\n  \"events\": %llu,\n  \"presses\": %llu,\n"
+          "  \"strokes\": %llu,\n  \"reports\": %llu,\n"
+          "  \"intended\": %llu,\n  \"false_taps\": %llu,\n"
+          "  \"false_holds\": %llu,\n  \"misfires\": %llu,\n"
+          "  \"max_depth\": %u,\n  \"stuck_keys\": %u,\n"
+          "  \"max_holdback_ms\": %u,\n  \"holdback_violations\": %u,\n"
+          "  \"max_tick_ms\": %u,\n"
+          "  \"frames\": %llu,\n  \"wakes\": %llu,\n  \"max_wake_ms\": %u,\n"
+          "  \"cpu_ns_per_event\": %.1f,\n  \"events_per_sec\": %.0f,\n"
+          "  \"latency\": {",
+          (unsigned long long)stats.events, (unsigned long long)stats.presses,
+          (unsigned long long)stats.strokes, (unsigned long long)stats.reports,
+          (unsigned long long)stats.intended,
+          (unsigned long long)stats.false_taps,
+          (unsigned long long)stats.false_holds,
+          (unsigned long long)(stats.false_taps + stats.false_holds),
+          stats.max_depth, stats.stuck_keys, stats.max_holdback_ms,
+          stats.holdback_violations, stats.max_tick_ms,
+          (unsigned long long)stats.frames, (unsigned long long)stats.wakes,
+          stats.max_wake_ms, cpu_ns_per_event,
+          cpu_ns_per_event > 0 ? 1e9 / cpu_ns_per_event : 0.0);
+  for (int c = 0; c < 4; ++c) {
+    const sim_latency_t* l = &stats.latency[c];
+    fprintf(out,
+            "%s\n    \"%s\": {\"count\": %llu, \"mean_ms\": %.3f, "
+            "\"p50_ms\": %u, \"p90_ms\": %u, \"p99_ms\": %u, \"max_ms\": %u}",
+            c ? "," : "", classes[c], (unsigned long long)l->count,
+            l->count ? (double)l->sum_ms / l->count : 0.0,
+            percentile(l, 0.5), percentile(l, 0.9), percentile(l, 0.99),
+            l->max_ms);
+  }
+  static const char* const states[] = {"active", "quiet", "asleep"};
+  fprintf(out, "\n  },\n  \"idle\": {");
+  for (int s = 0; s < 3; ++s) {
+    const uint64_t ms = stats.idle_ms[s];
+    fprintf(out, "%s\n    \"%s\": {\"ms\": %llu", s ? "," : "", states[s],
+            (unsigned long long)ms);
+    if (options.time_ticks) {
+      fprintf(out, ", \"tick_ns\": %.1f",
+              ms ? (double)stats.tick_ns[s] / ms : 0.0);
+    }
+    fprintf(out, "}");
+  }
+  fprintf(out, "\n  }\n}\n");
+}
@@ -0,0 +1,179 @@
+/**
+ * @file sim.h
+ * @brief Host model of QMK's key record pipeline for the eZrPW keymap.
+ *
+ * The simulator links the real keymap.c and features/ sources against the
+ * stand-in QMK API in qmk/quantum.h. Behind that API, sim.c models the parts
+ * of QMK that decide what the host sees:
+ *
+ *  * tap-hold buffering as in action_tapping.c, with PERMISSIVE_HOLD when
+ *    config.h defines it, and optionally QMK's Chordal Hold and Flow Tap;
+ *  * layer lookup, caps word, tap dance and the HID report;
+ *  * the main loop: matrix events, then per-millisecond tapping, tap dance and
+ *    housekeeping ticks, with an RGB Matrix frame every RGB_FRAME_MS.
+ *
+ * Time is simulated in milliseconds. `wait_ms()` advances it, as blocking
+ * does on the keyboard, so events queued behind a wait are seen late.
+ *
+ * Per press, the simulator records the latency from the physical press to the
+ * last action the press caused (the settled tap or hold for tap-hold keys) and,
+ * when the trace states an intent, whether a tap-hold key resolved the way the
+ * typist meant.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/** How tap-hold keys are resolved past QMK's tapping logic. */
+typedef enum {
+  /** Through process_achordion(), as the keymap does on the keyboard. */
+  SIM_POLICY_ACHORDION,
+  /** Achordion bypassed; QMK core Chordal Hold and Flow Tap instead. */
+  SIM_POLICY_CORE,
+} sim_policy_t;
+
+/** Intent of a press, as annotated in a trace. */
+enum {
+  SIM_INTENT_NONE = -1,
+  SIM_INTENT_TAP = 0,
+  SIM_INTENT_HOLD = 1,
+};
+
+/** Mod-tap classes, and layer-tap, of the streak timeout overrides. */
+enum {
+  SIM_STREAK_CTRL,
+  SIM_STREAK_SHIFT,
+  SIM_STREAK_ALT,
+  SIM_STREAK_GUI,
+  SIM_STREAK_LAYER,
+  SIM_STREAK_CLASSES,
+};
+
+/** Keeps the keymap's callback for a setting of sim_achordion_params_t. */
+#define SIM_KEYMAP 0xFFFF
+
+/**
+ * Achordion settings replacing the keymap's callbacks, for parameter sweeps.
+ * Each field is SIM_KEYMAP to keep what the keymap (or, where it does not
+ * define the callback, Achordion) does.
+ */
+typedef struct {
+  /** achordion_timeout() for every key. */
+  uint16_t timeout;
+  /**
+   * achordion_streak_chord_timeout() per class of the tap-hold key. A mod-tap
+   * with several mods takes the first of Shift, GUI, Alt and Ctrl it has, in
+   * the order the keymap's callback tests them. Unlike that callback, which
+   * tests with MOD_RSFT and so takes every right hand mod for Shift, the
+   * classes go by the mods themselves.
+   */
+  uint16_t streak_timeout[SIM_STREAK_CLASSES];
+  /** achordion_max_streak_timeout(). */
+  uint16_t max_streak_timeout;
+  /**
+   * achordion_overlap_percent() for every key: settle at the other key's
+   * release (ACHORDION_OVERLAP), or at its press if 0.
+   */
+  uint16_t overlap_percent;
+  /**
+   * Mods achordion_eager_mod() applies eagerly, as 8-bit mods (left hand in
+   * the low nibble). A mod-tap is eager if all its mods are in the set.
+   */
+  uint16_t eager_mods;
+} sim_achordion_params_t;
+
+#define SIM_LATENCY_MAX_MS 2048
+#define RGB_FRAME_MS 16
+
+typedef struct {
+  sim_policy_t policy;
+  /** Flow Tap term under SIM_POLICY_CORE; 0 disables Flow Tap. */
+  uint16_t flow_tap_term;
+  /** Apply Chordal Hold under SIM_POLICY_CORE. */
+  bool chordal_hold;
+  /** If set, replaces the keymap's Achordion settings. */
+  const sim_achordion_params_t* achordion;
+  /** If set, every key the host sees pressed is written here. */
+  FILE* strokes;
+  /** Measure the host CPU time of each tick, per idle state. */
+  bool time_ticks;
+} sim_options_t;
+
+typedef struct {
+  uint64_t count;
+  uint64_t sum_ms;
+  uint32_t max_ms;
+  // Histogram in 1 ms buckets; the last bucket collects the overflow.
+  uint32_t hist[SIM_LATENCY_MAX_MS + 1];
+} sim_latency_t;
+
+typedef struct {
+  uint64_t events;
+  uint64_t presses;
+  uint64_t strokes;
+  uint64_t reports;
+  // Tap-hold presses with an intent, and how many resolved against it.
+  uint64_t intended;
+  uint64_t false_taps;
+  uint64_t false_holds;
+  // Deepest nesting of process_record() seen.
+  uint32_t max_depth;
+  // Keys and mods still registered after the trace, which should be none.
+  uint32_t stuck_keys;
+  // Longest time Achordion held back a tap-hold press, and how often that
+  // exceeded achordion_timeout() plus the longest housekeeping tick.
+  uint32_t max_holdback_ms;
+  uint32_t holdback_violations;
+  // Longest interval between housekeeping ticks, 1 ms unless a callback
+  // blocks in wait_ms().
+  uint32_t max_tick_ms;
+  // Latency per `enum latency_class` (features/latency_trace.h).
+  sim_latency_t latency[4];
+  // RGB Matrix frames rendered, and ms spent per `idle_state_t`
+  // (features/idle.h).
+  uint64_t frames;
+  uint64_t idle_ms[3];
+  // Presses that woke the keyboard from IDLE_STATE_ASLEEP, and the longest
+  // latency of one.
+  uint64_t wakes;
+  uint32_t max_wake_ms;
+  // Host CPU time of the ticks per idle state, with sim_options_t.time_ticks.
+  uint64_t tick_ns[3];
+} sim_stats_t;
+
+/**
+ * Resets the model and runs `keyboard_post_init_user()`. Can be called again
+ * after sim_finish() to start over.
+ */
+void sim_init(const sim_options_t* options);
+
+/**
+ * Feeds one physical key event at `time` ms, running ticks up to it first.
+ * Events must come in nondecreasing time order.
+ */
+void sim_key_event(uint32_t time, uint8_t row, uint8_t col, bool pressed,
+                   int8_t intent);
+
+/**
+ * Feeds a raw HID packet of `length` bytes at `time` ms, zero-padded to 32
+ * bytes, to the keymap's `process_raw_hid_user()`, running ticks up to it
+ * first. Replies go nowhere.
+ */
+void sim_hid_event(uint32_t time, const uint8_t* data, uint8_t length);
+
+/** Runs ticks until `time` ms. */
+void sim_run_until(uint32_t time);
+
+/** Runs out all timers and closes the statistics. */
+void sim_finish(void);
+
+/** Current simulated time in ms. */
+uint32_t sim_time(void);
+
+const sim_stats_t* sim_stats(void);
+
+/** Writes the statistics as a JSON object. */
+void sim_write_json(FILE* out, double cpu_ns_per_event);
@@ -0,0 +1,15 @@
+/**
+ * @file sim_config.h
+ * @brief Build options the simulator adds to the keymap's config.h.
+ *
+ * Achordion's overlap policy is always built in, so `sim_replay --overlap`
+ * can compare it with the keymap's policy on the same traces. Where config.h
+ * does not enable it, it stays off unless asked for (see sim.c).
+ */
+
+#pragma once
+
+#ifndef ACHORDION_OVERLAP
+#define ACHORDION_OVERLAP
+#define SIM_ADDED_ACHORDION_OVERLAP
+#endif
@@ -0,0 +1,19 @@
+/**
+ * @file test_combos.c
+ * @brief Combos the simulator's tests replay with, in place of the keymap's.
+ *
+ * `make -C sim test` renames custom_keymap.c's table out of the way (see
+ * Makefile), so the tests do not change with the combos the keymap ships.
+ */
+
+#include "features/position_combos.h"
+
+// Sorted by mask. Positions count from 0 in LAYOUT_voyager() order.
+const position_combo_t PROGMEM position_combos[] = {
+  // The 5 and 6 keys of layer 2 together: Tab.
+  {POSITION_COMBO_KEY(32) | POSITION_COMBO_KEY(33), KC_TAB, 2},
+  // The , and . keys together on the base layer: Escape.
+  {POSITION_COMBO_KEY(44) | POSITION_COMBO_KEY(45), KC_ESCAPE, 0},
+};
+const uint8_t position_combos_count =
+    sizeof(position_combos) / sizeof(position_combos[0]);
@@ -0,0 +1,260 @@
+/**
+ * @file trace.c
+ * @brief Reader for key event traces.
+ */
+
+#include "trace.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "quantum.h"
+
+static bool valid_key(unsigned row, unsigned col) {
+  return row < MATRIX_ROWS && col < MATRIX_COLS;
+}
+
+static bool append(trace_t* trace, size_t* capacity, trace_event_t event) {
+  if (trace->count == *capacity) {
+    *capacity = *capacity ? 2 * *capacity : 1024;
+    trace_event_t* events =
+        realloc(trace->events, *capacity * sizeof(trace_event_t));
+    if (!events) {
+      return false;
+    }
+    trace->events = events;
+  }
+  trace->events[trace->count++] = event;
+  return true;
+}
+
+// Reads the bytes of a `hid` line from `text` into `event`.
+static bool read_hid(const char* text, trace_event_t* event) {
+  for (;;) {
+    char* end;
+    const unsigned long byte = strtoul(text, &end, 16);
+    if (end == text) {
+      break;
+    }
+    if (byte > UINT8_MAX || event->hid_length == TRACE_HID_BYTES) {
+      return false;
+    }
+    event->hid[event->hid_length++] = byte;
+    text = end;
+  }
+  return event->hid_length && !text[strspn(text, " \t\r\n")];
+}
+
+static bool read_text(const char* path, FILE* in, trace_t* trace) {
+  size_t capacity = 0;
+  uint32_t last_time = 0;
+  char line[256];
+  for (unsigned lineno = 1; fgets(line, sizeof(line), in); ++lineno) {
+    char* comment = strchr(line, '#');
+    if (comment) {
+      *comment = '\0';
+    }
+    unsigned long time;
+    int hid_at = 0;
+    if (sscanf(line, "%lu hid%n", &time, &hid_at) == 1 && hid_at) {
+      trace_event_t event = {.time = time};
+      if (time < last_time || !read_hid(line + hid_at, &event)) {
+        fprintf(stderr, "%s:%u: bad HID packet\n", path, lineno);
+        return false;
+      }
+      last_time = time;
+      if (!append(trace, &capacity, event)) {
+        fprintf(stderr, "%s: out of memory\n", path);
+        return false;
+      }
+      continue;
+    }
+    unsigned row, col, pressed;
+    char intent = 0;
+    const int n =
+        sscanf(line, "%lu %u %u %u %c", &time, &row, &col, &pressed, &intent);
+    if (n <= 0) {
+      continue;  // Blank line.
+    }
+    if (n < 4 || !valid_key(row, col) || pressed > 1 || time < last_time ||
+        (n == 5 && intent != 't' && intent != 'h')) {
+      fprintf(stderr, "%s:%u: bad event\n", path, lineno);
+      return false;
+    }
+    last_time = time;
+    const trace_event_t event = {
+        .time = time,
+        .row = row,
+        .col = col,
+        .pressed = pressed,
+        .intent = n < 5           ? SIM_INTENT_NONE
+                  : intent == 'h' ? SIM_INTENT_HOLD
+                                  : SIM_INTENT_TAP,
+    };
+    if (!append(trace, &capacity, event)) {
+      fprintf(stderr, "%s: out of memory\n", path);
+      return false;
+    }
+  }
+  return true;
+}
+
+static uint32_t get32(const uint8_t* p) {
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static bool map_binary(const char* path, int fd, size_t size, trace_t* trace) {
+  void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) {
+    perror(path);
+    return false;
+  }
+  madvise(map, size, MADV_SEQUENTIAL);
+  trace->map = map;
+  trace->map_size = size;
+
+  const uint8_t* header = map;
+  const uint16_t version = header[4] | header[5] << 8;
+  const uint16_t record_size = header[6] | header[7] << 8;
+  if (version != KEY_TRACE_VERSION || record_size != KEY_TRACE_RECORD_SIZE) {
+    fprintf(stderr, "%s: unsupported trace version %u\n", path, version);
+    return false;
+  }
+  trace->start_time = get32(header + 8);
+  trace->records = (const key_trace_record_t*)(header + KEY_TRACE_HEADER_SIZE);
+  trace->num_records = (size - KEY_TRACE_HEADER_SIZE) / KEY_TRACE_RECORD_SIZE;
+  const uint32_t count = get32(header + 12);
+  if (count && count <= trace->num_records) {
+    trace->num_records = count;
+  }
+
+  // Check positions once here, so replay can use records as they are.
+  for (size_t i = 0; i < trace->num_records; ++i) {
+    const key_trace_record_t* r = &trace->records[i];
+    if (key_trace_has_key(r) &&
+        !valid_key(key_trace_row(r), key_trace_col(r))) {
+      fprintf(stderr, "%s: record %zu: bad key position\n", path, i);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool trace_open(const char* path, trace_t* trace) {
+  *trace = (trace_t){0};
+  const int fd = open(path, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) < 0) {
+    perror(path);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return false;
+  }
+
+  char magic[4] = {0};
+  const bool binary = st.st_size >= KEY_TRACE_HEADER_SIZE &&
+                      pread(fd, magic, sizeof(magic), 0) == sizeof(magic) &&
+                      !memcmp(magic, KEY_TRACE_MAGIC, sizeof(magic));
+  bool ok;
+  if (binary) {
+    ok = map_binary(path, fd, st.st_size, trace);
+    close(fd);
+  } else {
+    FILE* in = fdopen(fd, "r");
+    ok = in && read_text(path, in, trace);
+    if (in) {
+      fclose(in);
+    } else {
+      close(fd);
+    }
+  }
+  if (!ok) {
+    trace_close(trace);
+  }
+  return ok;
+}
+
+void trace_close(trace_t* trace) {
+  free(trace->events);
+  if (trace->map) {
+    munmap(trace->map, trace->map_size);
+  }
+  *trace = (trace_t){0};
+}
+
+size_t trace_num_events(const trace_t* trace) {
+  size_t n = 0;
+  for (size_t i = 0; i < trace->count; ++i) {
+    n += !trace->events[i].hid_length;
+  }
+  for (size_t i = 0; i < trace->num_records; ++i) {
+    n += key_trace_has_key(&trace->records[i]);
+  }
+  return n;
+}
+
+static void put32(uint8_t* p, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    p[i] = value >> (8 * i);
+  }
+}
+
+bool trace_write_binary(const trace_t* trace, const char* path) {
+  for (size_t i = 0; i < trace->count; ++i) {
+    if (trace->events[i].hid_length) {
+      fprintf(stderr, "%s: HID packets have no binary form\n", path);
+      return false;
+    }
+  }
+  FILE* out = fopen(path, "wb");
+  if (!out) {
+    perror(path);
+    return false;
+  }
+  const uint32_t start = trace->count ? trace->events[0].time
+                                      : trace->start_time;
+  size_t written = 0;
+  uint8_t header[KEY_TRACE_HEADER_SIZE] = {'K', 'T', 'R', 'C'};
+  header[4] = KEY_TRACE_VERSION;
+  header[6] = KEY_TRACE_RECORD_SIZE;
+  put32(header + 8, start);
+  fwrite(header, sizeof(header), 1, out);
+
+  uint32_t last = start;
+  for (size_t i = 0; i < trace->count; ++i) {
+    const trace_event_t* e = &trace->events[i];
+    uint32_t delta = e->time - last;
+    for (; delta > UINT16_MAX; delta -= UINT16_MAX, ++written) {
+      const key_trace_record_t r = key_trace_time_record(UINT16_MAX);
+      fwrite(&r, sizeof(r), 1, out);
+    }
+    const key_trace_record_t r = key_trace_record(
+        delta, e->row, e->col,
+        (e->pressed ? KEY_TRACE_PRESSED : 0) |
+            (e->intent + 1) << KEY_TRACE_INTENT_SHIFT);
+    fwrite(&r, sizeof(r), 1, out);
+    ++written;
+    last = e->time;
+  }
+  if (trace->num_records) {
+    fwrite(trace->records, sizeof(key_trace_record_t), trace->num_records,
+           out);
+    written += trace->num_records;
+  }
+
+  put32(header + 12, written);
+  fseek(out, 0, SEEK_SET);
+  fwrite(header, sizeof(header), 1, out);
+  const bool ok = !ferror(out);
+  if (fclose(out) != 0 || !ok) {
+    perror(path);
+    return false;
+  }
+  return true;
+}
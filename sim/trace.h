@@ -0,0 +1,94 @@
+/**
+ * @file trace.h
+ * @brief Reader for key event traces.
+ *
+ * Traces come in two formats, told apart by the binary header's magic:
+ *
+ *  * Text, one physical key event per line:
+ *
+ *        <time ms> <row> <col> <1 pressed | 0 released> [t | h]
+ *
+ *    The optional last field is the typist's intent for the press, tap or
+ *    hold, which the simulator scores tap-hold keys against. A line
+ *
+ *        <time ms> hid <byte> ...
+ *
+ *    sends a raw HID packet of up to TRACE_HID_BYTES hex bytes instead, such
+ *    as `hid a5 02` to toggle bypass mode (see features/user_hid.h). Blank
+ *    lines and anything after `#` are ignored. Times must be nondecreasing.
+ *
+ *  * Binary, as defined in features/key_trace_format.h. The file is mapped
+ *    into memory and its records are fed to the simulator as they are, which
+ *    is what large benchmark corpora should use.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "features/key_trace_format.h"
+#include "sim.h"
+
+/** Most bytes of a raw HID packet in a text trace. */
+#define TRACE_HID_BYTES 4
+
+typedef struct {
+  uint32_t time;
+  uint8_t row;
+  uint8_t col;
+  bool pressed;
+  int8_t intent;
+  // A raw HID packet in place of the key event, if `hid_length` is nonzero.
+  uint8_t hid_length;
+  uint8_t hid[TRACE_HID_BYTES];
+} trace_event_t;
+
+typedef struct {
+  // Text traces, parsed into events.
+  trace_event_t* events;
+  size_t count;
+  // Binary traces, mapped from the file.
+  const key_trace_record_t* records;
+  size_t num_records;
+  uint32_t start_time;
+  void* map;
+  size_t map_size;
+} trace_t;
+
+/**
+ * Opens the trace at `path` in either format. On error, prints a message to
+ * stderr and returns false.
+ */
+bool trace_open(const char* path, trace_t* trace);
+
+void trace_close(trace_t* trace);
+
+/** Number of key events in the trace. */
+size_t trace_num_events(const trace_t* trace);
+
+/** Feeds all events of the trace to the simulator. */
+static inline void trace_replay(const trace_t* trace) {
+  for (size_t i = 0; i < trace->count; ++i) {
+    const trace_event_t* e = &trace->events[i];
+    if (e->hid_length) {
+      sim_hid_event(e->time, e->hid, e->hid_length);
+    } else {
+      sim_key_event(e->time, e->row, e->col, e->pressed, e->intent);
+    }
+  }
+  uint32_t time = trace->start_time;
+  const key_trace_record_t* end = trace->records + trace->num_records;
+  for (const key_trace_record_t* r = trace->records; r < end; ++r) {
+    time += key_trace_delta(r);
+    if (key_trace_has_key(r)) {
+      // Intent none, tap and hold map to SIM_INTENT_NONE, _TAP and _HOLD.
+      sim_key_event(time, key_trace_row(r), key_trace_col(r),
+                    key_trace_pressed(r), (int8_t)key_trace_intent(r) - 1);
+    }
+  }
+}
+
+/** Writes the trace in the binary format, which has no HID packets. */
+bool trace_write_binary(const trace_t* trace, const char* path);